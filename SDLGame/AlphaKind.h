@@ -0,0 +1,37 @@
+#pragma once
+#include <cstdint>
+#include <initializer_list>
+#include <string>
+
+// How an image uses alpha, from cheapest to draw to dearest. Worked out for every
+// sprite when the atlas and the asset pack are built (see SpriteRuns::alphaKind), so
+// drawing can pick the cheapest way that gives the same picture.
+enum class AlphaKind : uint8_t
+{
+	Opaque,      // alpha 255 everywhere: drawn with blending off
+	Binary,      // alpha 0 or 255: a masked copy, no blending maths
+	Translucent, // anything between somewhere: blended
+};
+
+inline const char* alphaKindName(AlphaKind kind)
+{
+	switch (kind)
+	{
+	case AlphaKind::Opaque: return "opaque";
+	case AlphaKind::Binary: return "binary";
+	default: return "translucent";
+	}
+}
+
+inline bool parseAlphaKind(const std::string& name, AlphaKind& kind)
+{
+	for (AlphaKind candidate : { AlphaKind::Opaque, AlphaKind::Binary, AlphaKind::Translucent })
+	{
+		if (name == alphaKindName(candidate))
+		{
+			kind = candidate;
+			return true;
+		}
+	}
+	return false;
+}
@@ -0,0 +1,333 @@
+#include "AssetCache.h"
+#include <future>
+#include "ThreadPool.h"
+
+namespace
+{
+	const int kindCount = 3;
+
+	size_t textureBytes(SDL_Texture* pTexture)
+	{
+		Uint32 format = 0;
+		int width = 0, height = 0;
+		SDL_QueryTexture(pTexture, &format, nullptr, &width, &height);
+		return (size_t)width * height * (SDL_ISPIXELFORMAT_FOURCC(format) ? 4 : SDL_BYTESPERPIXEL(format));
+	}
+
+	size_t surfaceBytes(SDL_Surface* pSurface)
+	{
+		// Surfaces from the asset pack point into the mapped file; only their header is ours.
+		size_t bytes = sizeof(SDL_Surface);
+		if ((pSurface->flags & SDL_PREALLOC) == 0)
+			bytes += (size_t)pSurface->pitch * pSurface->h;
+		return bytes;
+	}
+}
+
+AssetCache::AssetCache(ImageLoader& loader, SDL_Renderer* pRenderer, size_t budgetBytes)
+	: imageLoader(loader), pRenderer(pRenderer), budgetBytes(budgetBytes)
+{
+}
+
+AssetCache::~AssetCache()
+{
+	clear();
+}
+
+AssetHandle AssetCache::acquireTexture(const std::string& path)
+{
+	return acquire(AssetKind::Texture, path);
+}
+
+AssetHandle AssetCache::acquireSurface(const std::string& path)
+{
+	return acquire(AssetKind::Surface, path);
+}
+
+AssetHandle AssetCache::acquireSound(const std::string& path)
+{
+	return acquire(AssetKind::Sound, path);
+}
+
+AssetHandle AssetCache::acquire(AssetKind kind, const std::string& path)
+{
+	uint32_t pathId = paths.intern(path);
+	int index = findEntry(kind, pathId);
+	if (index >= 0)
+	{
+		counters.hits++;
+		return addReference(index);
+	}
+
+	counters.misses++;
+	Entry loaded;
+	switch (kind)
+	{
+	case AssetKind::Texture:
+		loaded = uploadEntry(imageLoader.loadSurface(path, keepPixels ? ImageLoader::textureFormat(pRenderer) : (Uint32)SDL_PIXELFORMAT_UNKNOWN), path);
+		if (loaded.pTexture == nullptr)
+			return {};
+		break;
+	case AssetKind::Surface:
+		loaded.pSurface = imageLoader.loadSurface(path);
+		if (loaded.pSurface == nullptr)
+			return {};
+		loaded.bytes = surfaceBytes(loaded.pSurface);
+		break;
+	case AssetKind::Sound:
+		if (SDL_LoadWAV((imageLoader.root() + path).c_str(), &loaded.sound.spec, &loaded.sound.pBuffer, &loaded.sound.length) == nullptr)
+			return {};
+		loaded.bytes = loaded.sound.length;
+		break;
+	}
+	return addEntry(kind, pathId, loaded);
+}
+
+std::vector<AssetHandle> AssetCache::acquireTextures(const std::vector<std::string>& texturePaths, ThreadPool& pool)
+{
+	std::vector<AssetHandle> handles(texturePaths.size());
+	std::vector<std::future<SDL_Surface*>> pending(texturePaths.size());
+	Uint32 format = ImageLoader::textureFormat(pRenderer);
+	for (size_t i = 0; i < texturePaths.size(); i++)
+	{
+		int index = findEntry(AssetKind::Texture, paths.intern(texturePaths[i]));
+		if (index >= 0)
+		{
+			counters.hits++;
+			handles[i] = addReference(index);
+		}
+		else
+		{
+			pending[i] = imageLoader.loadSurfaceAsync(texturePaths[i], pool, format);
+		}
+	}
+
+	// Upload in request order, so the result doesn't depend on thread timing.
+	for (size_t i = 0; i < texturePaths.size(); i++)
+	{
+		if (!pending[i].valid())
+			continue;
+
+		uint32_t pathId = paths.intern(texturePaths[i]);
+		Entry loaded = uploadEntry(pending[i].get(), texturePaths[i]);
+		int index = findEntry(AssetKind::Texture, pathId);
+		if (index >= 0)
+		{
+			// The same path was listed twice and the first copy is already in.
+			if (loaded.pTexture)
+				SDL_DestroyTexture(loaded.pTexture);
+			SDL_FreeSurface(loaded.pSurface);
+			counters.hits++;
+			handles[i] = addReference(index);
+			continue;
+		}
+
+		counters.misses++;
+		if (loaded.pTexture == nullptr)
+			continue;
+		handles[i] = addEntry(AssetKind::Texture, pathId, loaded);
+	}
+	return handles;
+}
+
+AssetCache::Entry AssetCache::uploadEntry(SDL_Surface* pSurface, const std::string& path)
+{
+	Entry loaded;
+	loaded.pTexture = imageLoader.upload(pRenderer, pSurface, path, keepPixels);
+	if (keepPixels && loaded.pTexture)
+		loaded.pSurface = pSurface;
+	else if (keepPixels)
+		SDL_FreeSurface(pSurface);
+	if (loaded.pTexture)
+		loaded.bytes = textureBytes(loaded.pTexture) + (loaded.pSurface ? surfaceBytes(loaded.pSurface) : 0);
+	return loaded;
+}
+
+int AssetCache::findEntry(AssetKind kind, uint32_t pathId) const
+{
+	size_t key = (size_t)pathId * kindCount + (size_t)kind;
+	return key < entryByKey.size() ? entryByKey[key] : -1;
+}
+
+AssetHandle AssetCache::addEntry(AssetKind kind, uint32_t pathId, Entry loaded)
+{
+	int index;
+	if (!freeEntries.empty())
+	{
+		index = freeEntries.back();
+		freeEntries.pop_back();
+		loaded.generation = entries[index].generation;
+		entries[index] = loaded;
+	}
+	else
+	{
+		index = (int)entries.size();
+		entries.push_back(loaded);
+	}
+
+	Entry& entry = entries[index];
+	entry.kind = kind;
+	entry.path = pathId;
+	entry.refs = 1;
+
+	size_t key = (size_t)pathId * kindCount + (size_t)kind;
+	if (key >= entryByKey.size())
+		entryByKey.resize(key + 1, -1);
+	entryByKey[key] = index;
+
+	counters.entries++;
+	counters.bytes += entry.bytes;
+	if (counters.bytes > counters.peakBytes)
+		counters.peakBytes = counters.bytes;
+	trim();
+	return { (uint32_t)index, entry.generation };
+}
+
+AssetHandle AssetCache::addReference(int index)
+{
+	Entry& entry = entries[index];
+	if (entry.refs == 0)
+		unlinkLru(index);
+	entry.refs++;
+	return { (uint32_t)index, entry.generation };
+}
+
+bool AssetCache::replaceTexture(AssetHandle handle, SDL_Texture* pTexture)
+{
+	if (resolve(handle) == nullptr || pTexture == nullptr)
+		return false;
+
+	Entry& entry = entries[handle.index];
+	if (entry.pTexture == nullptr)
+		return false;
+	SDL_DestroyTexture(entry.pTexture);
+	entry.pTexture = pTexture;
+	// Kept pixels would be the old image; whoever draws from them goes back to the texture.
+	SDL_FreeSurface(entry.pSurface);
+	entry.pSurface = nullptr;
+	counters.bytes -= entry.bytes;
+	entry.bytes = textureBytes(pTexture);
+	counters.bytes += entry.bytes;
+	if (counters.bytes > counters.peakBytes)
+		counters.peakBytes = counters.bytes;
+	trim();
+	return true;
+}
+
+void AssetCache::retain(AssetHandle handle)
+{
+	if (resolve(handle))
+		addReference((int)handle.index);
+}
+
+void AssetCache::release(AssetHandle handle)
+{
+	if (resolve(handle) == nullptr)
+		return;
+
+	int index = (int)handle.index;
+	Entry& entry = entries[index];
+	if (--entry.refs > 0)
+		return;
+
+	entry.lruPrev = -1;
+	entry.lruNext = lruHead;
+	if (lruHead >= 0)
+		entries[lruHead].lruPrev = index;
+	lruHead = index;
+	if (lruTail < 0)
+		lruTail = index;
+	trim();
+}
+
+const AssetCache::Entry* AssetCache::resolve(AssetHandle handle) const
+{
+	if (handle.index >= entries.size())
+		return nullptr;
+	const Entry& entry = entries[handle.index];
+	return entry.generation == handle.generation && entry.path != StringInterner::noId ? &entry : nullptr;
+}
+
+SDL_Texture* AssetCache::texture(AssetHandle handle) const
+{
+	const Entry* pEntry = resolve(handle);
+	return pEntry ? pEntry->pTexture : nullptr;
+}
+
+SDL_Surface* AssetCache::surface(AssetHandle handle) const
+{
+	const Entry* pEntry = resolve(handle);
+	return pEntry ? pEntry->pSurface : nullptr;
+}
+
+const SoundClip* AssetCache::sound(AssetHandle handle) const
+{
+	const Entry* pEntry = resolve(handle);
+	return pEntry && pEntry->kind == AssetKind::Sound ? &pEntry->sound : nullptr;
+}
+
+const std::string& AssetCache::path(AssetHandle handle) const
+{
+	static const std::string none;
+	const Entry* pEntry = resolve(handle);
+	return pEntry ? paths.str(pEntry->path) : none;
+}
+
+void AssetCache::setBudget(size_t bytes)
+{
+	budgetBytes = bytes;
+	trim();
+}
+
+void AssetCache::trim()
+{
+	while (counters.bytes > budgetBytes && lruTail >= 0)
+	{
+		destroy(lruTail);
+		counters.evictions++;
+	}
+}
+
+void AssetCache::unlinkLru(int index)
+{
+	Entry& entry = entries[index];
+	if (entry.lruPrev >= 0)
+		entries[entry.lruPrev].lruNext = entry.lruNext;
+	else
+		lruHead = entry.lruNext;
+	if (entry.lruNext >= 0)
+		entries[entry.lruNext].lruPrev = entry.lruPrev;
+	else
+		lruTail = entry.lruPrev;
+	entry.lruPrev = entry.lruNext = -1;
+}
+
+void AssetCache::destroy(int index)
+{
+	Entry& entry = entries[index];
+	if (entry.refs == 0)
+		unlinkLru(index);
+
+	if (entry.pTexture)
+		SDL_DestroyTexture(entry.pTexture);
+	SDL_FreeSurface(entry.pSurface);
+	SDL_FreeWAV(entry.sound.pBuffer);
+
+	entryByKey[(size_t)entry.path * kindCount + (size_t)entry.kind] = -1;
+	counters.entries--;
+	counters.bytes -= entry.bytes;
+
+	uint32_t generation = entry.generation + 1;
+	entry = Entry();
+	entry.generation = generation != 0 ? generation : 1;
+	freeEntries.push_back(index);
+}
+
+void AssetCache::clear()
+{
+	for (int i = 0; i < (int)entries.size(); i++)
+	{
+		if (entries[i].path != StringInterner::noId)
+			destroy(i);
+	}
+}
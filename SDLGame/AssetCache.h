@@ -0,0 +1,144 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <SDL.h>
+#include "ImageLoader.h"
+#include "StringInterner.h"
+
+class ThreadPool;
+
+enum class AssetKind : uint8_t
+{
+	Texture,
+	Surface,
+	Sound,
+};
+
+// Refers to one cache entry. Copying a handle doesn't add a reference; use
+// AssetCache::retain for that. A handle whose entry was released and evicted
+// simply stops resolving (the accessors return nullptr), it never points at
+// someone else's asset.
+struct AssetHandle
+{
+	uint32_t index = 0;
+	uint32_t generation = 0; // 0 = no asset
+
+	bool isValid() const { return generation != 0; }
+};
+
+// A WAV file decoded by SDL_LoadWAV.
+struct SoundClip
+{
+	SDL_AudioSpec spec = {};
+	Uint8* pBuffer = nullptr;
+	Uint32 length = 0;
+};
+
+// Owns every texture, surface and sound the game loads, keyed by interned asset path.
+// Loading a path that is already cached returns the same asset with one more reference.
+// Assets nobody references any more stay cached, so switching back to them is free,
+// until the cache is over its memory budget; then the least recently released ones
+// are destroyed first. Assets that are still referenced are never evicted, so the
+// budget can be exceeded if the game holds on to more than it allows.
+//
+// Everything here runs on the render thread.
+class AssetCache
+{
+public:
+	struct Stats
+	{
+		uint64_t hits = 0;
+		uint64_t misses = 0;    // loads, including failed ones
+		uint64_t evictions = 0;
+		size_t bytes = 0;
+		size_t peakBytes = 0;
+		int entries = 0;
+	};
+
+	AssetCache(ImageLoader& loader, SDL_Renderer* pRenderer, size_t budgetBytes = 128 * 1024 * 1024);
+	~AssetCache();
+
+	AssetCache(const AssetCache&) = delete;
+	AssetCache& operator=(const AssetCache&) = delete;
+
+	// Each returns a handle holding one reference, or an invalid handle if loading failed.
+	// Paths are relative to the asset root, e.g. "Meteors/meteorBrown_big1.png".
+	AssetHandle acquireTexture(const std::string& path);
+	AssetHandle acquireSurface(const std::string& path);
+	AssetHandle acquireSound(const std::string& path);
+
+	// acquireTexture for many paths at once: the ones not cached yet are decoded on
+	// the pool and uploaded here as they finish. handles[i] belongs to paths[i].
+	std::vector<AssetHandle> acquireTextures(const std::vector<std::string>& paths, ThreadPool& pool);
+
+	// Swaps a new texture into a texture entry and destroys the old one, and its kept
+	// pixels. Handles stay valid.
+	// Used by hot reload when an image changes size.
+	bool replaceTexture(AssetHandle handle, SDL_Texture* pTexture);
+
+	// Keeps every texture loaded from now on in memory as well, as a surface in the
+	// texture's format, for drawing without the renderer (see SoftwareBlitter). surface()
+	// then gives it for texture handles too. Images from the asset pack are mapped, so
+	// keeping theirs costs next to nothing.
+	void setKeepPixels(bool keep) { keepPixels = keep; }
+	bool keepsPixels() const { return keepPixels; }
+
+	void retain(AssetHandle handle);
+	void release(AssetHandle handle);
+
+	SDL_Texture* texture(AssetHandle handle) const;
+	SDL_Surface* surface(AssetHandle handle) const; // also a texture's kept pixels, or nullptr
+	const SoundClip* sound(AssetHandle handle) const;
+	const std::string& path(AssetHandle handle) const;
+
+	// Evicts unreferenced assets until the cache fits (or nothing more can go).
+	void setBudget(size_t budgetBytes);
+	size_t budget() const { return budgetBytes; }
+	const Stats& stats() const { return counters; }
+
+	// Destroys every asset, referenced or not, and invalidates all handles.
+	// Call it before destroying the renderer.
+	void clear();
+
+	ImageLoader& loader() const { return imageLoader; }
+	SDL_Renderer* renderer() const { return pRenderer; }
+
+private:
+	struct Entry
+	{
+		AssetKind kind = AssetKind::Texture;
+		uint32_t generation = 1;
+		uint32_t path = StringInterner::noId;
+		int refs = 0;
+		size_t bytes = 0;
+		SDL_Texture* pTexture = nullptr;
+		SDL_Surface* pSurface = nullptr; // a surface, or a texture's kept pixels
+		SoundClip sound;
+		int lruPrev = -1; // unreferenced entries form a list, most recently released first
+		int lruNext = -1;
+	};
+
+	AssetHandle acquire(AssetKind kind, const std::string& path);
+	Entry uploadEntry(SDL_Surface* pSurface, const std::string& path);
+	int findEntry(AssetKind kind, uint32_t pathId) const;
+	AssetHandle addEntry(AssetKind kind, uint32_t pathId, Entry loaded);
+	AssetHandle addReference(int index);
+	const Entry* resolve(AssetHandle handle) const;
+	void destroy(int index);
+	void unlinkLru(int index);
+	void trim();
+
+	ImageLoader& imageLoader;
+	SDL_Renderer* pRenderer;
+	size_t budgetBytes;
+	bool keepPixels = false;
+	StringInterner paths;
+	std::vector<int> entryByKey; // pathId * kindCount + kind -> entry index, or -1
+	std::vector<Entry> entries;
+	std::vector<int> freeEntries;
+	int lruHead = -1;
+	int lruTail = -1;
+	Stats counters;
+};
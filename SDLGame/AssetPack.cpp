@@ -0,0 +1,324 @@
+#include "AssetPack.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include "Hash.h"
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace AssetPackFormat;
+
+namespace
+{
+	// size bytes from offset lie inside a file of fileSize bytes. Written so that
+	// damaged offsets near 2^64 can't wrap around and pass.
+	bool fitsIn(uint64_t offset, uint64_t size, uint64_t fileSize)
+	{
+		return offset <= fileSize && size <= fileSize - offset;
+	}
+
+	// Bytes per pixel of a packed SDL_PIXELFORMAT_* value (SDL_BYTESPERPIXEL), or 0 for
+	// the planar FOURCC ones, which the pack never holds. The core builds without SDL.
+	uint64_t bytesPerPixel(uint32_t pixelFormat)
+	{
+		return (pixelFormat >> 28) == 1 ? pixelFormat & 0xFF : 0;
+	}
+}
+
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+bool MappedFile::open(const std::string& path)
+{
+	close();
+
+#if defined(_WIN32)
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	const void* view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+	if (view == nullptr)
+	{
+		if (mapping)
+			CloseHandle(mapping);
+		CloseHandle(file);
+		return false;
+	}
+
+	fileHandle = file;
+	mappingHandle = mapping;
+	pData = (const unsigned char*)view;
+	mappedSize = (size_t)fileSize.QuadPart;
+#else
+	int fd = ::open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	struct stat info;
+	if (fstat(fd, &info) != 0 || info.st_size == 0)
+	{
+		::close(fd);
+		return false;
+	}
+
+	void* view = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd); // the mapping keeps the file alive
+	if (view == MAP_FAILED)
+		return false;
+
+	pData = (const unsigned char*)view;
+	mappedSize = (size_t)info.st_size;
+#endif
+	return true;
+}
+
+void MappedFile::close()
+{
+	if (pData == nullptr)
+		return;
+
+#if defined(_WIN32)
+	UnmapViewOfFile(pData);
+	CloseHandle((HANDLE)mappingHandle);
+	CloseHandle((HANDLE)fileHandle);
+	fileHandle = mappingHandle = nullptr;
+#else
+	munmap((void*)pData, mappedSize);
+#endif
+	pData = nullptr;
+	mappedSize = 0;
+}
+
+bool AssetPack::open(const std::string& path)
+{
+	close();
+	if (!file.open(path) || file.size() < sizeof(PackHeader))
+	{
+		file.close();
+		return false;
+	}
+
+	const PackHeader* pHead = (const PackHeader*)file.data();
+	const uint64_t fileSize = file.size();
+	const uint64_t pixelBytes = bytesPerPixel(pHead->pixelFormat);
+	bool valid = memcmp(pHead->magic, magic, sizeof(magic)) == 0
+		&& pHead->version == version
+		&& pHead->fileSize == fileSize
+		&& pixelBytes > 0
+		&& pHead->stringsOffset <= fileSize
+		&& fitsIn(pHead->entriesOffset, (uint64_t)pHead->entryCount * sizeof(PackEntry), pHead->stringsOffset);
+
+	// Every entry has to point inside the file before we hand out pointers into it, and
+	// its rows have to hold its pixels.
+	const PackEntry* pIndex = (const PackEntry*)(file.data() + (valid ? pHead->entriesOffset : 0));
+	for (uint32_t i = 0; valid && i < pHead->entryCount; i++)
+	{
+		const PackEntry& e = pIndex[i];
+		valid = fitsIn((uint64_t)e.nameOffset, e.nameLength, fileSize - pHead->stringsOffset)
+			&& fitsIn(e.dataOffset, e.dataSize, fileSize)
+			&& e.pitch >= e.width * pixelBytes
+			&& (uint64_t)e.pitch * e.height <= e.dataSize
+			&& e.maskOffset % sizeof(uint64_t) == 0
+			&& e.maskWordCount <= fileSize / sizeof(uint64_t)
+			&& fitsIn(e.maskOffset, e.maskWordCount * sizeof(uint64_t), fileSize)
+			&& e.runsOffset % sizeof(uint32_t) == 0
+			&& e.runsWordCount <= fileSize / sizeof(uint32_t)
+			&& fitsIn(e.runsOffset, e.runsWordCount * sizeof(uint32_t), fileSize);
+	}
+
+	if (!valid)
+	{
+		file.close();
+		return false;
+	}
+
+	pHeader = pHead;
+	pEntries = pIndex;
+	pStrings = (const char*)file.data() + pHeader->stringsOffset;
+	return true;
+}
+
+void AssetPack::close()
+{
+	file.close();
+	pHeader = nullptr;
+	pEntries = nullptr;
+	pStrings = nullptr;
+}
+
+const AssetPack::Entry* AssetPack::find(const std::string& name) const
+{
+	if (!isOpen())
+		return nullptr;
+
+	uint64_t hash = fnv1a64(name);
+	const Entry* pEnd = pEntries + pHeader->entryCount;
+	const Entry* pFound = std::lower_bound(pEntries, pEnd, hash, [](const Entry& e, uint64_t h) { return e.nameHash < h; });
+	for (; pFound != pEnd && pFound->nameHash == hash; pFound++)
+	{
+		if (pFound->nameLength == name.size() && memcmp(pStrings + pFound->nameOffset, name.data(), name.size()) == 0)
+			return pFound;
+	}
+	return nullptr;
+}
+
+std::string AssetPack::name(const Entry& entry) const
+{
+	return std::string(pStrings + entry.nameOffset, entry.nameLength);
+}
+
+bool AssetPack::collisionMask(const Entry& entry, CollisionMask& mask) const
+{
+	if (entry.maskOffset == 0)
+		return false;
+	return mask.assign((int)entry.width, (int)entry.height, (const uint64_t*)(file.data() + entry.maskOffset), (size_t)entry.maskWordCount);
+}
+
+bool AssetPack::spriteRuns(const Entry& entry, SpriteRuns& runs) const
+{
+	if (entry.runsOffset == 0)
+		return false;
+	return runs.assign((int)entry.width, (int)entry.height, (const uint32_t*)(file.data() + entry.runsOffset), (size_t)entry.runsWordCount);
+}
+
+bool AssetPack::alphaKind(const Entry& entry, AlphaKind& kind) const
+{
+	uint32_t stored = entry.flags & alphaKindMask;
+	if (stored == 0)
+		return false;
+	kind = (AlphaKind)(stored - 1);
+	return true;
+}
+
+void AssetPackWriter::add(const std::string& name, uint64_t contentHash, uint32_t width, uint32_t height, uint32_t pitch, const void* pixels,
+	const CollisionMask* pMask, const SpriteRuns* pRuns)
+{
+	images.push_back({ name, contentHash, width, height, pitch, pixels, pMask, pRuns });
+}
+
+bool AssetPackWriter::write(const std::string& path) const
+{
+	std::vector<const Pending*> sorted;
+	for (const Pending& image : images)
+		sorted.push_back(&image);
+	std::sort(sorted.begin(), sorted.end(), [](const Pending* a, const Pending* b) { return fnv1a64(a->name) < fnv1a64(b->name); });
+
+	auto align = [](uint64_t offset) { return (offset + packAlignment - 1) / packAlignment * packAlignment; };
+
+	PackHeader header = {};
+	memcpy(header.magic, magic, sizeof(magic));
+	header.version = version;
+	header.pixelFormat = format;
+	header.maskThreshold = threshold;
+	header.entryCount = (uint32_t)sorted.size();
+	header.entriesOffset = sizeof(PackHeader);
+	header.stringsOffset = header.entriesOffset + sorted.size() * sizeof(PackEntry);
+
+	std::string strings;
+	std::vector<PackEntry> entries;
+	for (const Pending* pImage : sorted)
+	{
+		PackEntry entry = {};
+		entry.nameHash = fnv1a64(pImage->name);
+		entry.contentHash = pImage->contentHash;
+		entry.nameOffset = (uint32_t)strings.size();
+		entry.nameLength = (uint32_t)pImage->name.size();
+		entry.width = pImage->width;
+		entry.height = pImage->height;
+		entry.pitch = pImage->pitch;
+		entry.dataSize = (uint64_t)pImage->pitch * pImage->height;
+		if (pImage->pRuns && !pImage->pRuns->isEmpty())
+			entry.flags = 1 + (uint32_t)pImage->pRuns->alphaKind();
+		strings += pImage->name;
+		entries.push_back(entry);
+	}
+
+	uint64_t offset = align(header.stringsOffset + strings.size());
+	for (PackEntry& entry : entries)
+	{
+		entry.dataOffset = offset;
+		offset = align(offset + entry.dataSize);
+	}
+	for (size_t i = 0; i < entries.size(); i++)
+	{
+		if (sorted[i]->pMask == nullptr || sorted[i]->pMask->isEmpty())
+			continue;
+		entries[i].maskOffset = offset;
+		entries[i].maskWordCount = sorted[i]->pMask->data().size();
+		offset = align(offset + entries[i].maskWordCount * sizeof(uint64_t));
+	}
+	for (size_t i = 0; i < entries.size(); i++)
+	{
+		if (sorted[i]->pRuns == nullptr || sorted[i]->pRuns->isEmpty())
+			continue;
+		entries[i].runsOffset = offset;
+		entries[i].runsWordCount = sorted[i]->pRuns->data().size();
+		offset = align(offset + entries[i].runsWordCount * sizeof(uint32_t));
+	}
+	header.fileSize = offset;
+
+	std::string tempPath = path + ".tmp";
+	{
+		std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+		if (!out)
+			return false;
+
+		out.write((const char*)&header, sizeof(header));
+		out.write((const char*)entries.data(), entries.size() * sizeof(PackEntry));
+		out.write(strings.data(), strings.size());
+
+		static const char zeros[packAlignment] = {};
+		uint64_t written = header.stringsOffset + strings.size();
+		for (size_t i = 0; i < entries.size(); i++)
+		{
+			out.write(zeros, entries[i].dataOffset - written);
+			out.write((const char*)sorted[i]->pixels, entries[i].dataSize);
+			written = entries[i].dataOffset + entries[i].dataSize;
+		}
+		for (size_t i = 0; i < entries.size(); i++)
+		{
+			if (entries[i].maskOffset == 0)
+				continue;
+			uint64_t maskSize = entries[i].maskWordCount * sizeof(uint64_t);
+			out.write(zeros, entries[i].maskOffset - written);
+			out.write((const char*)sorted[i]->pMask->data().data(), maskSize);
+			written = entries[i].maskOffset + maskSize;
+		}
+		for (size_t i = 0; i < entries.size(); i++)
+		{
+			if (entries[i].runsOffset == 0)
+				continue;
+			uint64_t runsSize = entries[i].runsWordCount * sizeof(uint32_t);
+			out.write(zeros, entries[i].runsOffset - written);
+			out.write((const char*)sorted[i]->pRuns->data().data(), runsSize);
+			written = entries[i].runsOffset + runsSize;
+		}
+		out.write(zeros, header.fileSize - written);
+		if (!out)
+			return false;
+	}
+
+	std::error_code error;
+	std::filesystem::rename(tempPath, path, error);
+	return !error;
+}
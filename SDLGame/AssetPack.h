@@ -0,0 +1,152 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "CollisionMask.h"
+#include "SpriteRuns.h"
+
+// Asset pack: images stored already decoded, in the pixel format the renderer
+// wants, so loading one is a pointer into a memory-mapped file instead of a PNG
+// decode. Built by Tools/AssetPackBuilder.cpp.
+//
+// Layout (little-endian):
+//   PackHeader
+//   PackEntry[entryCount], sorted by nameHash
+//   name strings (not NUL-terminated; see nameOffset/nameLength)
+//   pixel data, every image starting on a packAlignment boundary
+//   collision masks (CollisionMask::data()), likewise aligned
+//   sprite runs (SpriteRuns::data()), likewise aligned
+namespace AssetPackFormat
+{
+	const char magic[8] = { 'S', 'D', 'L', 'G', 'P', 'A', 'K', '\0' };
+	const uint32_t version = 3;
+	const uint32_t packAlignment = 64;
+
+	// The low bits of PackEntry::flags: 1 + the image's AlphaKind, or 0 if it has none.
+	const uint32_t alphaKindMask = 0x3;
+
+	struct PackHeader
+	{
+		char magic[8];
+		uint32_t version;
+		uint32_t pixelFormat; // an SDL_PIXELFORMAT_* value, the same for every image
+		uint32_t entryCount;
+		uint32_t maskThreshold; // alpha at or above this is solid in the masks
+		uint64_t entriesOffset;
+		uint64_t stringsOffset;
+		uint64_t fileSize;
+	};
+
+	struct PackEntry
+	{
+		uint64_t nameHash;    // fnv1a64 of the name
+		uint64_t contentHash; // fnv1a64 of the source file, for incremental rebuilds
+		uint32_t nameOffset;  // from stringsOffset
+		uint32_t nameLength;
+		uint32_t width;
+		uint32_t height;
+		uint32_t pitch;       // bytes per row
+		uint32_t flags;       // see alphaKindMask
+		uint64_t dataOffset;  // from the start of the file
+		uint64_t dataSize;
+		uint64_t maskOffset;  // from the start of the file; 0 if there is no mask
+		uint64_t maskWordCount;
+		uint64_t runsOffset;  // from the start of the file; 0 if there are no runs
+		uint64_t runsWordCount;
+	};
+}
+
+// A read-only memory-mapped file.
+class MappedFile
+{
+public:
+	MappedFile() = default;
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	bool open(const std::string& path);
+	void close();
+
+	const unsigned char* data() const { return pData; }
+	size_t size() const { return mappedSize; }
+
+private:
+	const unsigned char* pData = nullptr;
+	size_t mappedSize = 0;
+#if defined(_WIN32)
+	void* fileHandle = nullptr;
+	void* mappingHandle = nullptr;
+#endif
+};
+
+// Read access to an asset pack. Nothing is copied: pixels() points into the mapping,
+// which stays valid until close() or destruction.
+class AssetPack
+{
+public:
+	using Entry = AssetPackFormat::PackEntry;
+
+	// Maps the pack and checks its header and index. Returns false if it's missing or damaged.
+	bool open(const std::string& path);
+	void close();
+	bool isOpen() const { return pHeader != nullptr; }
+
+	uint32_t pixelFormat() const { return pHeader ? pHeader->pixelFormat : 0; }
+	uint32_t entryCount() const { return pHeader ? pHeader->entryCount : 0; }
+	uint8_t maskThreshold() const { return pHeader ? (uint8_t)pHeader->maskThreshold : CollisionMask::defaultThreshold; }
+	const Entry& entry(uint32_t index) const { return pEntries[index]; }
+
+	// Entry for a name relative to Assets/, e.g. "Meteors/meteorBrown_big1.png", or nullptr.
+	const Entry* find(const std::string& name) const;
+
+	std::string name(const Entry& entry) const;
+	const void* pixels(const Entry& entry) const { return file.data() + entry.dataOffset; }
+
+	// Copies the image's collision mask out of the pack. Returns false if it has none.
+	bool collisionMask(const Entry& entry, CollisionMask& mask) const;
+
+	// Copies the image's sprite runs out of the pack. Returns false if it has none.
+	bool spriteRuns(const Entry& entry, SpriteRuns& runs) const;
+
+	// How the image uses alpha. Returns false if the builder didn't say.
+	bool alphaKind(const Entry& entry, AlphaKind& kind) const;
+
+private:
+	MappedFile file;
+	const AssetPackFormat::PackHeader* pHeader = nullptr;
+	const Entry* pEntries = nullptr;
+	const char* pStrings = nullptr;
+};
+
+// Builds a pack file. Pixel data is referenced, not copied, so it must stay alive until write().
+class AssetPackWriter
+{
+public:
+	AssetPackWriter(uint32_t pixelFormat, uint8_t maskThreshold = CollisionMask::defaultThreshold) : format(pixelFormat), threshold(maskThreshold) {}
+
+	// The mask and runs, if any, must be the image's size. Like the pixels they are referenced, not copied.
+	// The runs also give the entry its AlphaKind.
+	void add(const std::string& name, uint64_t contentHash, uint32_t width, uint32_t height, uint32_t pitch, const void* pixels,
+		const CollisionMask* pMask = nullptr, const SpriteRuns* pRuns = nullptr);
+
+	// Writes to path + ".tmp" and renames it over path, so a failed build never leaves a half-written pack.
+	bool write(const std::string& path) const;
+
+private:
+	struct Pending
+	{
+		std::string name;
+		uint64_t contentHash;
+		uint32_t width, height, pitch;
+		const void* pixels;
+		const CollisionMask* pMask;
+		const SpriteRuns* pRuns;
+	};
+
+	uint32_t format;
+	uint8_t threshold;
+	std::vector<Pending> images;
+};
@@ -0,0 +1,770 @@
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <SDL.h>
+#include <SDL_image.h>
+#include "AssetCache.h"
+#include "BenchStats.h"
+#include "Broadphase.h"
+#include "CollisionKernels.h"
+#include "DirtyRectRenderer.h"
+#include "FramePacer.h"
+#include "GameLoop.h"
+#include "Hash.h"
+#include "ImageLoader.h"
+#include "Scenes.h"
+#include "SimulationThread.h"
+#include "SoftwareBlitter.h"
+#include "SpriteAtlas.h"
+#include "SpriteBatch.h"
+#include "ThreadPool.h"
+#include "TraceLog.h"
+
+// SDLGame_bench: runs the scripted scenes headless and prints a JSON report.
+//
+//   SDLGame_bench [--scene <name>|all] [--broadphase <name>|all] [--frames N] [--warmup N] [--entities N]
+//                 [--width W] [--height H] [--tick-rate HZ] [--frame-rate HZ] [--pace FPS]
+//                 [--assets DIR] [--asset-pack on|off] [--pixel-masks on|off] [--startup-trace trace.json]
+//                 [--decode-threads N] [--cache-budget MB] [--cache-churn N] [--checksum-log FILE]
+//                 [--sim-thread off|on|both] [--renderer sdl|blitter|both] [--sprite-meshes on|off]
+//                 [--dirty-rects on|off] [--out report.json]
+//
+// Every frame advances the game clock by exactly 1/frame-rate seconds, whatever the
+// real frame took, so each run simulates the same ticks and draws the same frames.
+// With --pace the frame pacer caps the loop at FPS and the report includes its
+// error histogram (run it next to a CPU hog to check pacing under load).
+//
+// --broadphase picks the collision backend the scenes use; "all" runs every scene
+// with each of them in turn. "tick_ms" in each scene's report is the simulation alone.
+// Rotated sprites are tested by their convex hulls (CollisionShape); --pixel-masks on
+// tests their pixel masks instead.
+//
+// --sim-thread on runs the ticks on a SimulationThread, a frame ahead of drawing, the
+// way the game does; "both" runs every scene without it and then with it, and
+// "sim_thread_speedup" compares their frame rates. The software renderer keeps the
+// main thread busy, so the overlap shows most in scenes whose ticks cost about as
+// much as drawing them. "sim_wait_ms" is the time per frame drawing waited for the
+// worker: the frames the simulation was the slower half. The ticks are the same either
+// way, and so are the state checksums.
+//
+// "state_checksum" hashes the scene's state after every measured tick, and
+// --checksum-log writes the per-tick hashes out, one line each, so two runs can be
+// diffed to the first tick they part. "fixed_point" says whether the simulation ran
+// on Fixed (cmake -DSDLGAME_FIXED_POINT=ON): only then do builds from different
+// compilers or optimisation levels agree.
+//
+// --renderer blitter draws every sprite it can with the SoftwareBlitter's SIMD kernels
+// (BlitKernels, "blit_simd" in the report) instead of SDL's software renderer; "both"
+// runs every scene with each, and "blitter_speedup" compares their sprites per second.
+// "draw_ms" is the time per frame from the first sprite queued until the frame is
+// done, and "blits_per_frame" how many sprites the blitter drew rather than SDL.
+//
+// Sprites with a mesh in the atlas table (SpriteMesh) are drawn as their outline
+// rather than their quad, on SDL 2.0.18+; --sprite-meshes off draws quads. Each
+// scene's "overdraw" gives the window pixels per frame under the sprites' quads and
+// the ones actually sent to be filled, and "saved_share" the part the meshes left out.
+//
+// --dirty-rects on draws through a DirtyRectRenderer, the way the game draws its pause
+// menu: only what changed since the last frame is drawn again, and a frame where
+// nothing did is skipped. Each scene's "dirty_rects" counts the skipped frames and
+// gives "redrawn_share", the part of all the frames' pixels that was drawn. Try it on
+// the "menu" scene; the busy scenes change almost everywhere every frame.
+//
+// Frames are drawn into a surface in memory by SDL's software renderer
+// (SDL_CreateSoftwareRenderer), so the numbers are comparable between machines with
+// and without a GPU. SDL uses the "dummy" video driver unless SDL_VIDEODRIVER says otherwise. Sprites are loaded from
+// Assets/ in the working directory unless --assets says otherwise, from the packed
+// atlas in Assets/Atlas if there is one. Scenes draw plain rectangles for images
+// they can't find. Images come out of Assets/assets.pack when it exists; the report's
+// "assets" block says how many did and how long loading took, and --asset-pack off
+// forces PNG decoding for comparison.
+//
+// --startup-trace loads every loose PNG twice, once one by one as the game used to
+// and once decoded on a thread pool (--decode-threads, default one per core) with
+// only the uploads on the main thread. The report gets both wall-clock times, and
+// the file gets a Chrome trace (chrome://tracing, ui.perfetto.dev) of both passes.
+//
+// Every texture goes through an AssetCache limited to --cache-budget megabytes.
+// --cache-churn N then loads and releases every image N times, the way a long
+// session cycling through colour variants would; "asset_cache" in the report
+// shows the peak stays near the budget while evictions climb.
+
+namespace
+{
+	struct BenchOptions
+	{
+		std::string scene = "all";
+		std::string broadphase; // empty: the scenes' default; "all": every backend in turn
+		int frames = 1000;
+		int warmupFrames = 60;
+		double tickRate = 120.0;
+		double frameRate = 60.0;
+		double paceFps = 0.0; // 0 = run flat out
+		std::string assetRoot = "Assets/";
+		bool useAssetPack = true;
+		std::string startupTracePath;
+		int decodeThreads = 0;
+		double cacheBudgetMb = 128.0;
+		int cacheChurnRounds = 0;
+		std::string checksumLogPath;
+		std::string simThread = "off"; // "off", "on" or "both"
+		std::string renderer = "sdl";  // "sdl", "blitter" or "both"
+		bool spriteMeshes = true;
+		bool dirtyRects = false;
+		SceneConfig sceneConfig;
+		std::string outPath;
+	};
+
+	struct SceneResult
+	{
+		std::string name;
+		std::string broadphase;
+		bool simThread = false;
+		bool blitter = false;
+		int frames = 0;
+		uint64_t ticks = 0;
+		double totalSeconds = 0.0;
+		SampleStats frameMs;
+		SampleStats tickMs;
+		SampleStats entities;
+		SampleStats contacts;
+		SampleStats batches;
+		SampleStats renderCalls;
+		SampleStats drawMs;
+		SampleStats blits;
+		uint64_t sprites = 0;
+		double quadPixels = 0.0;  // summed over measured frames
+		double drawnPixels = 0.0;
+		bool dirtyRects = false;
+		int skippedFrames = 0;     // with dirtyRects: measured frames with nothing to redraw
+		double redrawnPixels = 0.0; // and the pixels the others redrew
+		Histogram pacingErrorUs = Histogram(1, 1);
+		double spinMarginMs = 0.0;
+		double simWaitMs = 0.0; // per frame, with simThread
+		uint64_t checksum = fnv1a64Seed;
+	};
+
+	double spritesPerSecond(const SceneResult& result)
+	{
+		double drawSeconds = result.drawMs.mean() * result.frames / 1000.0;
+		return drawSeconds > 0.0 ? result.sprites / drawSeconds : 0.0;
+	}
+
+	std::string hexString(uint64_t value)
+	{
+		std::ostringstream text;
+		text << std::hex << std::setw(16) << std::setfill('0') << value;
+		return text.str();
+	}
+
+	void printUsage()
+	{
+		std::cerr << "usage: SDLGame_bench [--scene <name>|all] [--broadphase <name>|all] [--frames N] [--warmup N] [--entities N]\n"
+			"                     [--width W] [--height H] [--tick-rate HZ] [--frame-rate HZ] [--pace FPS]\n"
+			"                     [--assets DIR] [--asset-pack on|off] [--pixel-masks on|off] [--startup-trace trace.json]\n"
+			"                     [--decode-threads N] [--cache-budget MB] [--cache-churn N] [--checksum-log FILE]\n"
+			"                     [--sim-thread off|on|both] [--renderer sdl|blitter|both] [--sprite-meshes on|off]\n"
+			"                     [--dirty-rects on|off] [--out report.json]\n"
+			"scenes:";
+		for (const std::string& name : sceneNames())
+			std::cerr << " " << name;
+		std::cerr << "\nbroadphases:";
+		for (const std::string& name : broadphaseNames())
+			std::cerr << " " << name;
+		std::cerr << "\n";
+	}
+
+	bool parseOptions(int argc, char* args[], BenchOptions& options)
+	{
+		for (int i = 1; i < argc; i++)
+		{
+			const char* arg = args[i];
+			const char* value = i + 1 < argc ? args[i + 1] : nullptr;
+			if (value == nullptr)
+				return false;
+
+			if (strcmp(arg, "--scene") == 0)
+				options.scene = value;
+			else if (strcmp(arg, "--broadphase") == 0)
+				options.broadphase = value;
+			else if (strcmp(arg, "--frames") == 0)
+				options.frames = atoi(value);
+			else if (strcmp(arg, "--warmup") == 0)
+				options.warmupFrames = atoi(value);
+			else if (strcmp(arg, "--entities") == 0)
+				options.sceneConfig.entityCount = atoi(value);
+			else if (strcmp(arg, "--width") == 0)
+				options.sceneConfig.width = atoi(value);
+			else if (strcmp(arg, "--height") == 0)
+				options.sceneConfig.height = atoi(value);
+			else if (strcmp(arg, "--tick-rate") == 0)
+				options.tickRate = atof(value);
+			else if (strcmp(arg, "--frame-rate") == 0)
+				options.frameRate = atof(value);
+			else if (strcmp(arg, "--pace") == 0)
+				options.paceFps = atof(value);
+			else if (strcmp(arg, "--assets") == 0)
+				options.assetRoot = std::string(value) + "/";
+			else if (strcmp(arg, "--asset-pack") == 0)
+				options.useAssetPack = strcmp(value, "off") != 0;
+			else if (strcmp(arg, "--pixel-masks") == 0)
+				options.sceneConfig.pixelMasks = strcmp(value, "on") == 0;
+			else if (strcmp(arg, "--startup-trace") == 0)
+				options.startupTracePath = value;
+			else if (strcmp(arg, "--decode-threads") == 0)
+				options.decodeThreads = atoi(value);
+			else if (strcmp(arg, "--cache-budget") == 0)
+				options.cacheBudgetMb = atof(value);
+			else if (strcmp(arg, "--cache-churn") == 0)
+				options.cacheChurnRounds = atoi(value);
+			else if (strcmp(arg, "--checksum-log") == 0)
+				options.checksumLogPath = value;
+			else if (strcmp(arg, "--sim-thread") == 0)
+				options.simThread = value;
+			else if (strcmp(arg, "--renderer") == 0)
+				options.renderer = value;
+			else if (strcmp(arg, "--sprite-meshes") == 0)
+				options.spriteMeshes = strcmp(value, "off") != 0;
+			else if (strcmp(arg, "--dirty-rects") == 0)
+				options.dirtyRects = strcmp(value, "on") == 0;
+			else if (strcmp(arg, "--out") == 0)
+				options.outPath = value;
+			else
+				return false;
+			i++;
+		}
+		bool simThreadKnown = options.simThread == "off" || options.simThread == "on" || options.simThread == "both";
+		bool rendererKnown = options.renderer == "sdl" || options.renderer == "blitter" || options.renderer == "both";
+		return simThreadKnown && rendererKnown && options.frames > 0 && options.warmupFrames >= 0 && options.cacheBudgetMb >= 0.0 && options.tickRate > 0.0 && options.frameRate > 0.0;
+	}
+
+	// Runs one scene for warmup + frames frames and records the time of every measured frame.
+	// pBlitter, if set, draws the sprites instead of the renderer. pChecksumLog, if set,
+	// gets a line per measured tick.
+	SceneResult runScene(Scene& scene, const std::string& broadphase, bool simThread, SoftwareBlitter* pBlitter, SpriteAtlas& atlas,
+		const BenchOptions& options, std::ostream* pChecksumLog)
+	{
+		SpriteBatch& batch = atlas.batch();
+		SDL_Renderer* pRenderer = batch.renderer();
+		batch.setBlitter(pBlitter);
+		FixedTimestep timestep(options.tickRate);
+		const double frameSeconds = 1.0 / options.frameRate;
+		const float tickSeconds = (float)timestep.tickSeconds();
+		const double ticksToMs = 1000.0 / SDL_GetPerformanceFrequency();
+		FramePacer pacer(options.paceFps > 0.0 ? options.paceFps : 60.0);
+		pacer.setMode(options.paceFps > 0.0 ? PacingMode::Capped : PacingMode::Uncapped, pRenderer, nullptr);
+
+		SceneResult result;
+		result.name = scene.name();
+		result.broadphase = broadphase;
+		result.simThread = simThread;
+		result.blitter = pBlitter != nullptr;
+		result.dirtyRects = options.dirtyRects;
+		result.frameMs.reserve(options.frames);
+		result.tickMs.reserve(options.frames * 2);
+		result.entities.reserve(options.frames);
+		result.contacts.reserve(options.frames);
+
+		// One tick and its measurements. With simThread it runs on the worker, which only
+		// reads measuring while the main thread is between finish() and start().
+		bool measuring = false;
+		uint64_t measuredTicks = 0;
+		auto runTick = [&]()
+		{
+			Uint64 tickStart = SDL_GetPerformanceCounter();
+			scene.tick(tickSeconds);
+			if (!measuring)
+				return;
+			result.tickMs.add((SDL_GetPerformanceCounter() - tickStart) * ticksToMs);
+			uint64_t tickChecksum = scene.checksum();
+			result.checksum = fnv1a64(&tickChecksum, sizeof(tickChecksum), result.checksum);
+			if (pChecksumLog)
+				*pChecksumLog << result.name << " " << broadphase << " " << (simThread ? "threaded" : "serial") << " " << (pBlitter ? "blitter" : "sdl") << " " << ++measuredTicks << " " << hexString(tickChecksum) << "\n";
+		};
+		std::unique_ptr<SimulationThread> simulation;
+		if (simThread)
+			simulation = std::make_unique<SimulationThread>(scene, runTick);
+		SceneSnapshot serialSnapshot;
+		std::unique_ptr<DirtyRectRenderer> dirtyRects;
+		if (options.dirtyRects)
+			dirtyRects = std::make_unique<DirtyRectRenderer>(atlas, nullptr, options.sceneConfig.width, options.sceneConfig.height);
+
+		Uint64 benchStart = 0;
+		uint64_t benchStartTick = 0;
+		double benchStartWait = 0.0;
+		for (int frame = 0; frame < options.warmupFrames + options.frames; frame++)
+		{
+			SDL_Event event;
+			while (SDL_PollEvent(&event))
+			{
+			}
+
+			Uint64 frameStart = SDL_GetPerformanceCounter();
+			if (frame == options.warmupFrames)
+			{
+				benchStart = frameStart;
+				benchStartTick = timestep.tickCount();
+				benchStartWait = simulation ? simulation->waitSeconds() : 0.0;
+				pacer.resetStats();
+			}
+
+			// Threaded, this frame draws the ticks the last one started, and the counts are theirs.
+			int ticks = timestep.advance(frameSeconds);
+			const SceneSnapshot* pSnapshot = &serialSnapshot;
+			if (simulation)
+			{
+				pSnapshot = &simulation->finish();
+				measuring = frame >= options.warmupFrames;
+				if (measuring)
+				{
+					result.entities.add(scene.entityCount());
+					result.contacts.add(scene.contactCount());
+				}
+				simulation->start(ticks, timestep.alpha());
+			}
+			else
+			{
+				measuring = frame >= options.warmupFrames;
+				for (int i = 0; i < ticks; i++)
+					runTick();
+				if (measuring)
+				{
+					result.entities.add(scene.entityCount());
+					result.contacts.add(scene.contactCount());
+				}
+				serialSnapshot.clear();
+				scene.capture(serialSnapshot);
+				serialSnapshot.alpha = timestep.alpha();
+			}
+
+			// The renderer may hold on to draws until the frame is presented; flushing the
+			// clear first leaves the sprites alone in the draw time.
+			Uint64 drawStart;
+			bool presented = true;
+			if (dirtyRects)
+			{
+				// The batch's counters are then those of the last dirty rectangle.
+				drawStart = SDL_GetPerformanceCounter();
+				dirtyRects->begin();
+				dirtyRects->add(*pSnapshot);
+				presented = dirtyRects->present();
+			}
+			else
+			{
+				SDL_SetRenderDrawColor(pRenderer, 0, 0, 0, 255);
+				SDL_RenderClear(pRenderer);
+#if SDL_VERSION_ATLEAST(2, 0, 10)
+				SDL_RenderFlush(pRenderer);
+#endif
+				drawStart = SDL_GetPerformanceCounter();
+				pSnapshot->draw(atlas);
+				batch.flush();
+				SDL_RenderPresent(pRenderer);
+			}
+
+			Uint64 frameEnd = SDL_GetPerformanceCounter();
+			if (frame >= options.warmupFrames)
+			{
+				SpriteBatch::Stats drawStats = presented ? batch.lastStats() : SpriteBatch::Stats();
+				result.frameMs.add((frameEnd - frameStart) * ticksToMs);
+				result.drawMs.add((frameEnd - drawStart) * ticksToMs);
+				result.batches.add(drawStats.batches);
+				result.renderCalls.add(drawStats.renderCalls);
+				result.blits.add(drawStats.blits);
+				result.sprites += drawStats.sprites;
+				result.quadPixels += drawStats.quadPixels;
+				result.drawnPixels += drawStats.drawnPixels;
+				if (dirtyRects)
+				{
+					result.skippedFrames += presented ? 0 : 1;
+					result.redrawnPixels += (double)dirtyRects->lastStats().pixels;
+				}
+			}
+			pacer.waitForNextFrame();
+		}
+		result.totalSeconds = (SDL_GetPerformanceCounter() - benchStart) * ticksToMs / 1000.0;
+
+		// The last frame's ticks are still running; they count, though nothing draws them.
+		if (simulation)
+		{
+			result.simWaitMs = (simulation->waitSeconds() - benchStartWait) * 1000.0 / options.frames;
+			simulation->finish();
+		}
+		result.pacingErrorUs = pacer.errorHistogram();
+		result.spinMarginMs = pacer.spinMarginSeconds() * 1000.0;
+		result.frames = options.frames;
+		result.ticks = timestep.tickCount() - benchStartTick;
+		batch.setBlitter(nullptr);
+		return result;
+	}
+
+	struct LoadResult
+	{
+		bool pack = false;
+		int packLoads = 0;
+		int decodedLoads = 0;
+		double seconds = 0.0;
+	};
+
+	struct StartupTraceResult
+	{
+		bool ran = false;
+		int images = 0;
+		int decodeThreads = 0;
+		double singleThreadedSeconds = 0.0;
+		double threadPoolSeconds = 0.0;
+	};
+
+	// Loads every loose PNG the old way and then through the thread pool, and writes a trace of both.
+	StartupTraceResult traceStartup(SDL_Renderer* pRenderer, const BenchOptions& options)
+	{
+		// No pack here: it would skip the decoding this is meant to measure.
+		ImageLoader loader(options.assetRoot);
+		std::vector<std::string> paths = loader.listImages();
+		std::vector<SDL_Texture*> textures;
+		auto destroyTextures = [&textures]()
+		{
+			for (SDL_Texture* pTexture : textures)
+				SDL_DestroyTexture(pTexture);
+			textures.clear();
+		};
+
+		// Untimed pass so both measured passes read from a warm file cache.
+		for (const std::string& path : paths)
+			textures.push_back(loader.loadTexture(pRenderer, path));
+		destroyTextures();
+
+		TraceLog trace;
+		loader.setTrace(&trace);
+		StartupTraceResult result;
+		result.ran = true;
+		result.images = (int)paths.size();
+
+		double startUs = trace.nowUs();
+		for (const std::string& path : paths)
+			textures.push_back(loader.loadTexture(pRenderer, path));
+		double endUs = trace.nowUs();
+		trace.addSpan("single-threaded", "phase", startUs, endUs);
+		result.singleThreadedSeconds = (endUs - startUs) / 1e6;
+		destroyTextures();
+
+		ThreadPool pool(options.decodeThreads);
+		result.decodeThreads = pool.threadCount();
+		startUs = trace.nowUs();
+		Uint32 format = ImageLoader::textureFormat(pRenderer);
+		std::vector<std::future<SDL_Surface*>> surfaces;
+		for (const std::string& path : paths)
+			surfaces.push_back(loader.loadSurfaceAsync(path, pool, format));
+		for (size_t i = 0; i < paths.size(); i++)
+			textures.push_back(loader.upload(pRenderer, surfaces[i].get(), paths[i]));
+		endUs = trace.nowUs();
+		trace.addSpan("thread pool", "phase", startUs, endUs);
+		result.threadPoolSeconds = (endUs - startUs) / 1e6;
+		destroyTextures();
+
+		std::ofstream out(options.startupTracePath);
+		trace.writeJson(out);
+		if (!out)
+			std::cerr << "could not write " << options.startupTracePath << "\n";
+		return result;
+	}
+
+	void writeReport(std::ostream& out, const BenchOptions& options, const char* videoDriver, const char* rendererName, const SpriteAtlas& atlas,
+		const AssetCache& cache, const LoadResult& load, const StartupTraceResult& startup, const std::vector<SceneResult>& results)
+	{
+		SDL_version version;
+		SDL_GetVersion(&version);
+
+		out << "{\n";
+		out << "  \"sdl_version\": \"" << (int)version.major << "." << (int)version.minor << "." << (int)version.patch << "\",\n";
+		out << "  \"video_driver\": " << jsonString(videoDriver ? videoDriver : "") << ",\n";
+		out << "  \"renderer\": " << jsonString(rendererName ? rendererName : "") << ",\n";
+		out << "  \"width\": " << options.sceneConfig.width << ",\n";
+		out << "  \"height\": " << options.sceneConfig.height << ",\n";
+		out << "  \"warmup_frames\": " << options.warmupFrames << ",\n";
+		out << "  \"tick_rate\": " << options.tickRate << ",\n";
+		out << "  \"frame_rate\": " << options.frameRate << ",\n";
+		out << "  \"pace_fps\": " << options.paceFps << ",\n";
+		out << "  \"simd\": " << jsonString(simdLevelName(collisionKernels().level)) << ",\n";
+		out << "  \"blit_simd\": " << jsonString(simdLevelName(blitKernels().level)) << ",\n";
+		out << "  \"pixel_masks\": " << (options.sceneConfig.pixelMasks ? "true" : "false") << ",\n";
+		out << "  \"sprite_meshes\": " << (options.spriteMeshes ? "true" : "false") << ",\n";
+		out << "  \"dirty_rects\": " << (options.dirtyRects ? "true" : "false") << ",\n";
+#ifdef SDLGAME_FIXED_POINT
+		out << "  \"fixed_point\": true,\n";
+#else
+		out << "  \"fixed_point\": false,\n";
+#endif
+		out << "  \"atlas\": {\"packed\":" << (atlas.isPacked() ? "true" : "false") << ",\"sprites\":" << atlas.spriteCount() << ",\"textures\":" << atlas.textureCount() << "},\n";
+		out << "  \"assets\": {\"pack\":" << (load.pack ? "true" : "false") << ",\"pack_loads\":" << load.packLoads
+			<< ",\"decoded_loads\":" << load.decodedLoads << ",\"load_ms\":" << load.seconds * 1000.0 << "},\n";
+		const AssetCache::Stats& cacheStats = cache.stats();
+		out << "  \"asset_cache\": {\"entries\":" << cacheStats.entries << ",\"bytes\":" << cacheStats.bytes << ",\"peak_bytes\":" << cacheStats.peakBytes
+			<< ",\"budget\":" << cache.budget() << ",\"hits\":" << cacheStats.hits << ",\"misses\":" << cacheStats.misses << ",\"evictions\":" << cacheStats.evictions << "},\n";
+		if (startup.ran)
+		{
+			out << "  \"startup_trace\": {\"images\":" << startup.images << ",\"decode_threads\":" << startup.decodeThreads
+				<< ",\"single_threaded_ms\":" << startup.singleThreadedSeconds * 1000.0 << ",\"thread_pool_ms\":" << startup.threadPoolSeconds * 1000.0
+				<< ",\"speedup\":" << (startup.threadPoolSeconds > 0.0 ? startup.singleThreadedSeconds / startup.threadPoolSeconds : 0.0) << "},\n";
+		}
+		out << "  \"scenes\": [\n";
+		for (size_t i = 0; i < results.size(); i++)
+		{
+			const SceneResult& result = results[i];
+			out << "    {\n";
+			out << "      \"name\": " << jsonString(result.name) << ",\n";
+			out << "      \"broadphase\": " << jsonString(result.broadphase) << ",\n";
+			out << "      \"sim_thread\": " << (result.simThread ? "true" : "false") << ",\n";
+			out << "      \"renderer\": " << jsonString(result.blitter ? "blitter" : "sdl") << ",\n";
+			out << "      \"frames\": " << result.frames << ",\n";
+			out << "      \"ticks\": " << result.ticks << ",\n";
+			out << "      \"fps\": " << (result.totalSeconds > 0.0 ? result.frames / result.totalSeconds : 0.0) << ",\n";
+			out << "      \"frame_ms\": ";
+			result.frameMs.writeJson(out);
+			out << ",\n";
+			out << "      \"tick_ms\": ";
+			result.tickMs.writeJson(out);
+			out << ",\n";
+			out << "      \"draw_ms\": ";
+			result.drawMs.writeJson(out);
+			out << ",\n";
+			out << "      \"sprites_per_second\": " << spritesPerSecond(result) << ",\n";
+			if (result.simThread)
+				out << "      \"sim_wait_ms\": " << result.simWaitMs << ",\n";
+			if (options.paceFps > 0.0)
+			{
+				out << "      \"pacing_error_us\": ";
+				result.pacingErrorUs.writeJson(out);
+				out << ",\n";
+				out << "      \"spin_margin_ms\": " << result.spinMarginMs << ",\n";
+			}
+			out << "      \"batches_per_frame\": " << result.batches.mean() << ",\n";
+			out << "      \"render_calls_per_frame\": " << result.renderCalls.mean() << ",\n";
+			out << "      \"blits_per_frame\": " << result.blits.mean() << ",\n";
+			out << "      \"overdraw\": {\"quad_pixels_per_frame\":" << (result.frames > 0 ? result.quadPixels / result.frames : 0.0)
+				<< ",\"drawn_pixels_per_frame\":" << (result.frames > 0 ? result.drawnPixels / result.frames : 0.0)
+				<< ",\"saved_share\":" << (result.quadPixels > 0.0 ? 1.0 - result.drawnPixels / result.quadPixels : 0.0) << "},\n";
+			if (result.dirtyRects)
+			{
+				double framePixels = (double)options.sceneConfig.width * options.sceneConfig.height * result.frames;
+				out << "      \"dirty_rects\": {\"skipped_frames\":" << result.skippedFrames
+					<< ",\"redrawn_share\":" << (framePixels > 0.0 ? result.redrawnPixels / framePixels : 0.0) << "},\n";
+			}
+			out << "      \"contacts\": {\"min\":" << result.contacts.min() << ",\"mean\":" << result.contacts.mean() << ",\"max\":" << result.contacts.max() << "},\n";
+			out << "      \"entities\": {\"min\":" << result.entities.min() << ",\"mean\":" << result.entities.mean() << ",\"max\":" << result.entities.max() << "},\n";
+			out << "      \"state_checksum\": \"" << hexString(result.checksum) << "\"\n";
+			out << "    }" << (i + 1 < results.size() ? "," : "") << "\n";
+		}
+		out << "  ],\n";
+		if (options.simThread == "both")
+		{
+			// Each threaded run against the serial run of the same scene and backend.
+			out << "  \"sim_thread_speedup\": [";
+			const char* separator = "\n";
+			for (const SceneResult& threaded : results)
+			{
+				for (const SceneResult& serial : results)
+				{
+					if (!threaded.simThread || serial.simThread || serial.name != threaded.name || serial.broadphase != threaded.broadphase || serial.blitter != threaded.blitter)
+						continue;
+					double serialFps = serial.totalSeconds > 0.0 ? serial.frames / serial.totalSeconds : 0.0;
+					double threadedFps = threaded.totalSeconds > 0.0 ? threaded.frames / threaded.totalSeconds : 0.0;
+					out << separator << "    {\"name\":" << jsonString(threaded.name) << ",\"broadphase\":" << jsonString(threaded.broadphase)
+						<< ",\"serial_fps\":" << serialFps << ",\"threaded_fps\":" << threadedFps << ",\"speedup\":" << (serialFps > 0.0 ? threadedFps / serialFps : 0.0) << "}";
+					separator = ",\n";
+				}
+			}
+			out << "\n  ],\n";
+		}
+		if (options.renderer == "both")
+		{
+			// Each blitter run against SDL drawing the same scene, backend and threading.
+			out << "  \"blitter_speedup\": [";
+			const char* separator = "\n";
+			for (const SceneResult& blitted : results)
+			{
+				for (const SceneResult& rendered : results)
+				{
+					if (!blitted.blitter || rendered.blitter || rendered.name != blitted.name || rendered.broadphase != blitted.broadphase || rendered.simThread != blitted.simThread)
+						continue;
+					double sdlRate = spritesPerSecond(rendered), blitterRate = spritesPerSecond(blitted);
+					out << separator << "    {\"name\":" << jsonString(blitted.name) << ",\"broadphase\":" << jsonString(blitted.broadphase)
+						<< ",\"sim_thread\":" << (blitted.simThread ? "true" : "false") << ",\"sdl_sprites_per_second\":" << sdlRate
+						<< ",\"blitter_sprites_per_second\":" << blitterRate << ",\"speedup\":" << (sdlRate > 0.0 ? blitterRate / sdlRate : 0.0) << "}";
+					separator = ",\n";
+				}
+			}
+			out << "\n  ],\n";
+		}
+		out << "  \"peak_rss_kb\": " << peakResidentKilobytes() << "\n";
+		out << "}\n";
+	}
+}
+
+int main(int argc, char* args[])
+{
+	BenchOptions options;
+	if (!parseOptions(argc, args, options))
+	{
+		printUsage();
+		return 1;
+	}
+
+	std::vector<std::string> scenesToRun;
+	if (options.scene == "all")
+		scenesToRun = sceneNames();
+	else
+		scenesToRun.push_back(options.scene);
+
+	// Every scene runs once per backend, to compare them on the same work.
+	std::vector<std::string> broadphasesToRun;
+	if (options.broadphase == "all")
+		broadphasesToRun = broadphaseNames();
+	else
+		broadphasesToRun.push_back(options.broadphase.empty() ? options.sceneConfig.broadphase : options.broadphase);
+	for (const std::string& name : broadphasesToRun)
+	{
+		if (!createBroadphase(name))
+		{
+			std::cerr << "unknown broadphase: " << name << "\n";
+			printUsage();
+			return 1;
+		}
+	}
+
+	// Headless by default; an explicit SDL_VIDEODRIVER from the environment wins.
+	SDL_setenv("SDL_VIDEODRIVER", "dummy", 0);
+	SDL_SetHint(SDL_HINT_RENDER_DRIVER, "software");
+
+	if (SDL_Init(SDL_INIT_VIDEO) != 0)
+	{
+		std::cerr << "SDL_Init failed: " << SDL_GetError() << "\n";
+		return 1;
+	}
+	IMG_Init(IMG_INIT_PNG);
+
+	// SDL's software renderer and the blitter draw into the same surface, so runs with
+	// either do the same work and a run with both makes one picture.
+	SDL_Surface* pFramebuffer = SDL_CreateRGBSurfaceWithFormat(0, options.sceneConfig.width, options.sceneConfig.height, 32, SDL_PIXELFORMAT_ARGB8888);
+	SDL_Renderer* pRenderer = pFramebuffer ? SDL_CreateSoftwareRenderer(pFramebuffer) : nullptr;
+	if (pRenderer == nullptr)
+	{
+		std::cerr << "could not create framebuffer/renderer: " << SDL_GetError() << "\n";
+		SDL_FreeSurface(pFramebuffer);
+		SDL_Quit();
+		return 1;
+	}
+
+	SDL_RendererInfo rendererInfo;
+	SDL_GetRendererInfo(pRenderer, &rendererInfo);
+
+	StartupTraceResult startup;
+	if (!options.startupTracePath.empty())
+		startup = traceStartup(pRenderer, options);
+
+	// Load time covers the pack, the atlas pages and every image the scenes look up.
+	Uint64 loadStart = SDL_GetPerformanceCounter();
+	ImageLoader loader(options.assetRoot);
+	if (options.useAssetPack)
+		loader.openPack();
+	AssetCache cache(loader, pRenderer, (size_t)(options.cacheBudgetMb * 1024 * 1024));
+	cache.setKeepPixels(options.renderer != "sdl");
+	SpriteBatch batch(pRenderer);
+	batch.setMeshes(options.spriteMeshes);
+	SoftwareBlitter blitter(pFramebuffer);
+	SpriteAtlas atlas(batch, cache);
+	atlas.loadPacked();
+
+	// "both" runs each scene serially first, then on the worker, from a fresh scene each time.
+	std::vector<bool> simThreadModes;
+	if (options.simThread != "on")
+		simThreadModes.push_back(false);
+	if (options.simThread != "off")
+		simThreadModes.push_back(true);
+
+	// Likewise "both" renderers: SDL first, then the blitter.
+	std::vector<bool> blitterModes;
+	if (options.renderer != "blitter")
+		blitterModes.push_back(false);
+	if (options.renderer != "sdl")
+		blitterModes.push_back(true);
+
+	std::vector<std::unique_ptr<Scene>> scenes;
+	std::vector<std::string> sceneBroadphases;
+	std::vector<bool> sceneSimThreads;
+	std::vector<bool> sceneBlitters;
+	for (const std::string& name : scenesToRun)
+	{
+		for (const std::string& broadphase : broadphasesToRun)
+		{
+			for (bool simThread : simThreadModes)
+			{
+				for (bool useBlitter : blitterModes)
+				{
+					SceneConfig config = options.sceneConfig;
+					config.broadphase = broadphase;
+					scenes.push_back(createScene(name, config, atlas));
+					sceneBroadphases.push_back(broadphase);
+					sceneSimThreads.push_back(simThread);
+					sceneBlitters.push_back(useBlitter);
+					if (!scenes.back())
+					{
+						std::cerr << "unknown scene: " << name << "\n";
+						printUsage();
+						return 1;
+					}
+				}
+			}
+		}
+	}
+
+	LoadResult load;
+	load.seconds = (double)(SDL_GetPerformanceCounter() - loadStart) / SDL_GetPerformanceFrequency();
+	load.pack = loader.hasPack();
+	load.packLoads = loader.packLoads();
+	load.decodedLoads = loader.decodedLoads();
+
+	std::ofstream checksumLog;
+	if (!options.checksumLogPath.empty())
+	{
+		checksumLog.open(options.checksumLogPath);
+		if (!checksumLog)
+			std::cerr << "could not write " << options.checksumLogPath << "\n";
+	}
+
+	std::vector<SceneResult> results;
+	for (size_t i = 0; i < scenes.size(); i++)
+		results.push_back(runScene(*scenes[i], sceneBroadphases[i], sceneSimThreads[i], sceneBlitters[i] ? &blitter : nullptr, atlas, options,
+			checksumLog.is_open() ? &checksumLog : nullptr));
+
+	// Scenes are done with their sprites; release them and push every loose image through
+	// the cache to check that unreferenced ones are evicted within the budget.
+	scenes.clear();
+	if (options.cacheChurnRounds > 0)
+	{
+		atlas.clear();
+		std::vector<std::string> paths = loader.listImages();
+		for (int round = 0; round < options.cacheChurnRounds; round++)
+		{
+			for (const std::string& path : paths)
+				cache.release(cache.acquireTexture(path));
+		}
+	}
+
+	std::ostringstream report;
+	writeReport(report, options, SDL_GetCurrentVideoDriver(), rendererInfo.name, atlas, cache, load, startup, results);
+	std::cout << report.str();
+	if (!options.outPath.empty())
+		std::ofstream(options.outPath) << report.str();
+
+	atlas.clear();
+	cache.clear();
+	SDL_DestroyRenderer(pRenderer);
+	SDL_FreeSurface(pFramebuffer);
+	IMG_Quit();
+	SDL_Quit();
+	return 0;
+}
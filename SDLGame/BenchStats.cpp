@@ -0,0 +1,157 @@
+#include "BenchStats.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+double SampleStats::mean() const
+{
+	if (samples.empty())
+		return 0.0;
+
+	double sum = 0.0;
+	for (double sample : samples)
+		sum += sample;
+	return sum / samples.size();
+}
+
+double SampleStats::min() const
+{
+	return samples.empty() ? 0.0 : *std::min_element(samples.begin(), samples.end());
+}
+
+double SampleStats::max() const
+{
+	return samples.empty() ? 0.0 : *std::max_element(samples.begin(), samples.end());
+}
+
+double SampleStats::percentile(double p) const
+{
+	if (samples.empty())
+		return 0.0;
+
+	std::vector<double> sorted = samples;
+	size_t rank = (size_t)std::ceil(p / 100.0 * sorted.size());
+	rank = std::min(std::max(rank, (size_t)1), sorted.size()) - 1;
+	std::nth_element(sorted.begin(), sorted.begin() + rank, sorted.end());
+	return sorted[rank];
+}
+
+void SampleStats::writeJson(std::ostream& out) const
+{
+	char buffer[256];
+	snprintf(buffer, sizeof(buffer), "{\"mean\":%.4f,\"p50\":%.4f,\"p90\":%.4f,\"p99\":%.4f,\"max\":%.4f}",
+		mean(), percentile(50), percentile(90), percentile(99), max());
+	out << buffer;
+}
+
+Histogram::Histogram(double binWidth, int binCount)
+	: width(binWidth), counts(binCount > 0 ? binCount : 1, 0)
+{
+}
+
+void Histogram::add(double value)
+{
+	if (value < 0.0)
+		value = 0.0;
+
+	size_t bin = (size_t)(value / width);
+	if (bin < counts.size())
+		counts[bin]++;
+	else
+		overflowCount++;
+
+	if (total == 0 || value > maxValue)
+		maxValue = value;
+	total++;
+	sum += value;
+}
+
+void Histogram::clear()
+{
+	std::fill(counts.begin(), counts.end(), 0);
+	overflowCount = 0;
+	total = 0;
+	sum = 0.0;
+	maxValue = 0.0;
+}
+
+double Histogram::percentile(double p) const
+{
+	if (total == 0)
+		return 0.0;
+
+	uint64_t rank = (uint64_t)std::ceil(p / 100.0 * total);
+	uint64_t seen = 0;
+	for (size_t i = 0; i < counts.size(); i++)
+	{
+		seen += counts[i];
+		if (seen >= rank)
+			return std::min((i + 1) * width, maxValue);
+	}
+	return maxValue;
+}
+
+void Histogram::writeJson(std::ostream& out) const
+{
+	char buffer[256];
+	snprintf(buffer, sizeof(buffer), "{\"count\":%llu,\"mean\":%.2f,\"p50\":%.2f,\"p90\":%.2f,\"p99\":%.2f,\"max\":%.2f,\"bin_width\":%g,\"bins\":[",
+		(unsigned long long)total, mean(), percentile(50), percentile(90), percentile(99), maxValue, width);
+	out << buffer;
+	for (size_t i = 0; i < counts.size(); i++)
+		out << (i ? "," : "") << counts[i];
+	out << "],\"overflow\":" << overflowCount << "}";
+}
+
+uint64_t peakResidentKilobytes()
+{
+#if defined(_WIN32)
+	PROCESS_MEMORY_COUNTERS counters;
+	if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+		return counters.PeakWorkingSetSize / 1024;
+	return 0;
+#else
+	rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) != 0)
+		return 0;
+#if defined(__APPLE__)
+	return (uint64_t)usage.ru_maxrss / 1024; // bytes on macOS
+#else
+	return (uint64_t)usage.ru_maxrss; // kilobytes on Linux
+#endif
+#endif
+}
+
+std::string jsonString(const std::string& text)
+{
+	std::string result = "\"";
+	for (char c : text)
+	{
+		switch (c)
+		{
+		case '"': result += "\\\""; break;
+		case '\\': result += "\\\\"; break;
+		case '\n': result += "\\n"; break;
+		case '\t': result += "\\t"; break;
+		default:
+			if ((unsigned char)c < 0x20)
+			{
+				char escaped[8];
+				snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+				result += escaped;
+			}
+			else
+			{
+				result += c;
+			}
+		}
+	}
+	return result + "\"";
+}
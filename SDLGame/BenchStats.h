@@ -0,0 +1,67 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Collects one sample per frame and summarises them for the benchmark report.
+class SampleStats
+{
+public:
+	void reserve(size_t count) { samples.reserve(count); }
+	void add(double value) { samples.push_back(value); }
+	void clear() { samples.clear(); }
+
+	size_t count() const { return samples.size(); }
+	double mean() const;
+	double min() const;
+	double max() const;
+
+	// Nearest-rank percentile, p in [0, 100].
+	double percentile(double p) const;
+
+	// Writes {"mean":..,"p50":..,"p90":..,"p99":..,"max":..} to out.
+	void writeJson(std::ostream& out) const;
+
+private:
+	std::vector<double> samples;
+};
+
+// Fixed-width histogram for values that arrive too often to keep every sample,
+// e.g. frame pacing error in microseconds. Values past the last bin go into an overflow bin.
+class Histogram
+{
+public:
+	Histogram(double binWidth, int binCount);
+
+	void add(double value);
+	void clear();
+
+	uint64_t count() const { return total; }
+	double binWidth() const { return width; }
+	const std::vector<uint64_t>& bins() const { return counts; }
+	uint64_t overflow() const { return overflowCount; }
+	double max() const { return maxValue; }
+	double mean() const { return total ? sum / total : 0.0; }
+
+	// Upper edge of the bin holding the p-th percentile (max() if it's in the overflow bin).
+	double percentile(double p) const;
+
+	// Writes {"count":..,"mean":..,"p50":..,"p90":..,"p99":..,"max":..,"bin_width":..,"bins":[..],"overflow":..}.
+	void writeJson(std::ostream& out) const;
+
+private:
+	double width;
+	std::vector<uint64_t> counts;
+	uint64_t overflowCount = 0;
+	uint64_t total = 0;
+	double sum = 0.0;
+	double maxValue = 0.0;
+};
+
+// Peak resident set size of this process in kilobytes, or 0 if the platform can't tell us.
+uint64_t peakResidentKilobytes();
+
+// Quotes and escapes a string for JSON output.
+std::string jsonString(const std::string& text);
@@ -0,0 +1,446 @@
+#include "BlitKernels.h"
+#include <algorithm>
+#include <cstring>
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define SDLGAME_X86 1
+#include <immintrin.h>
+#endif
+
+// As in CollisionKernels.cpp: GCC and Clang compile only the AVX2 kernels for AVX2,
+// and those clear the upper register halves before returning.
+#if defined(SDLGAME_X86) && !defined(_MSC_VER)
+#define SDLGAME_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define SDLGAME_TARGET_AVX2
+#endif
+
+namespace
+{
+	const uint32_t opaqueWhite = 0xFFFFFFFF;
+
+	// x / 255 rounded to nearest, for x up to 255 * 255.
+	inline uint32_t div255(uint32_t x)
+	{
+		x += 128;
+		return (x + (x >> 8)) >> 8;
+	}
+
+	inline uint32_t channel(uint32_t pixel, int shift)
+	{
+		return pixel >> shift & 0xFF;
+	}
+
+	inline uint32_t tinted(uint32_t pixel, uint32_t color, int shift)
+	{
+		return div255(channel(pixel, shift) * channel(color, shift));
+	}
+
+	void copyScalar(uint32_t* pDst, const uint32_t* pSrc, size_t count, uint32_t color, size_t start)
+	{
+		for (size_t i = start; i < count; i++)
+		{
+			uint32_t out = 0;
+			for (int shift = 0; shift < 32; shift += 8)
+				out |= tinted(pSrc[i], color, shift) << shift;
+			pDst[i] = out;
+		}
+	}
+
+	void blendScalar(uint32_t* pDst, const uint32_t* pSrc, size_t count, uint32_t color, size_t start)
+	{
+		for (size_t i = start; i < count; i++)
+		{
+			uint32_t alpha = tinted(pSrc[i], color, 24);
+			if (alpha == 0)
+				continue;
+			uint32_t d = pDst[i];
+			uint32_t out = div255(255 * alpha + channel(d, 24) * (255 - alpha)) << 24;
+			for (int shift = 0; shift < 24; shift += 8)
+				out |= div255(tinted(pSrc[i], color, shift) * alpha + channel(d, shift) * (255 - alpha)) << shift;
+			pDst[i] = out;
+		}
+	}
+
+	void addScalar(uint32_t* pDst, const uint32_t* pSrc, size_t count, uint32_t color, size_t start)
+	{
+		for (size_t i = start; i < count; i++)
+		{
+			uint32_t alpha = tinted(pSrc[i], color, 24);
+			if (alpha == 0)
+				continue;
+			uint32_t d = pDst[i];
+			uint32_t out = d & 0xFF000000;
+			for (int shift = 0; shift < 24; shift += 8)
+				out |= std::min(255u, channel(d, shift) + div255(tinted(pSrc[i], color, shift) * alpha)) << shift;
+			pDst[i] = out;
+		}
+	}
+
+	void modulateScalar(uint32_t* pDst, const uint32_t* pSrc, size_t count, uint32_t color, size_t start)
+	{
+		for (size_t i = start; i < count; i++)
+		{
+			uint32_t d = pDst[i];
+			uint32_t out = d & 0xFF000000;
+			for (int shift = 0; shift < 24; shift += 8)
+				out |= div255(tinted(pSrc[i], color, shift) * channel(d, shift)) << shift;
+			pDst[i] = out;
+		}
+	}
+
+	void maskedCopyScalar(uint32_t* pDst, const uint32_t* pSrc, size_t count, uint32_t color, size_t start)
+	{
+		for (size_t i = start; i < count; i++)
+		{
+			if (tinted(pSrc[i], color, 24) == 0)
+				continue;
+			uint32_t out = 0;
+			for (int shift = 0; shift < 32; shift += 8)
+				out |= tinted(pSrc[i], color, shift) << shift;
+			pDst[i] = out;
+		}
+	}
+
+	void copyPlain(uint32_t* pDst, const uint32_t* pSrc, size_t count, uint32_t color)
+	{
+		if (color == opaqueWhite)
+			memcpy(pDst, pSrc, count * sizeof(uint32_t));
+		else
+			copyScalar(pDst, pSrc, count, color, 0);
+	}
+
+	void blendPlain(uint32_t* pDst, const uint32_t* pSrc, size_t count, uint32_t color)
+	{
+		blendScalar(pDst, pSrc, count, color, 0);
+	}
+
+	void addPlain(uint32_t* pDst, const uint32_t* pSrc, size_t count, uint32_t color)
+	{
+		addScalar(pDst, pSrc, count, color, 0);
+	}
+
+	void modulatePlain(uint32_t* pDst, const uint32_t* pSrc, size_t count, uint32_t color)
+	{
+		modulateScalar(pDst, pSrc, count, color, 0);
+	}
+
+	void maskedCopyPlain(uint32_t* pDst, const uint32_t* pSrc, size_t count, uint32_t color)
+	{
+		maskedCopyScalar(pDst, pSrc, count, color, 0);
+	}
+
+#if defined(SDLGAME_X86)
+	// The SIMD kernels widen each group of pixels into two registers of 16-bit lanes,
+	// two pixels (SSE2) or four (AVX2) each, with alpha in lanes 3 and 7 of every 128
+	// bits. Products of two bytes fit a lane, so the maths is the scalar code's.
+
+	inline __m128i div255(__m128i x)
+	{
+		x = _mm_add_epi16(x, _mm_set1_epi16(128));
+		return _mm_srli_epi16(_mm_add_epi16(x, _mm_srli_epi16(x, 8)), 8);
+	}
+
+	// Each pixel's alpha lane copied to its other three.
+	inline __m128i spreadAlpha(__m128i x)
+	{
+		return _mm_shufflehi_epi16(_mm_shufflelo_epi16(x, 0xFF), 0xFF);
+	}
+
+	inline bool allTransparent(__m128i pixels)
+	{
+		__m128i alpha = _mm_and_si128(pixels, _mm_set1_epi32((int)0xFF000000));
+		return _mm_movemask_epi8(_mm_cmpeq_epi32(alpha, _mm_setzero_si128())) == 0xFFFF;
+	}
+
+	inline __m128i blendHalf(__m128i s, __m128i d, __m128i tint)
+	{
+		__m128i t = div255(_mm_mullo_epi16(s, tint));
+		__m128i alpha = spreadAlpha(t);
+		__m128i source = _mm_or_si128(t, _mm_set_epi16(255, 0, 0, 0, 255, 0, 0, 0));
+		return div255(_mm_add_epi16(_mm_mullo_epi16(source, alpha), _mm_mullo_epi16(d, _mm_sub_epi16(_mm_set1_epi16(255), alpha))));
+	}
+
+	inline __m128i addHalf(__m128i s, __m128i tint)
+	{
+		__m128i t = div255(_mm_mullo_epi16(s, tint));
+		__m128i color = _mm_and_si128(t, _mm_set_epi16(0, -1, -1, -1, 0, -1, -1, -1));
+		return div255(_mm_mullo_epi16(color, spreadAlpha(t)));
+	}
+
+	inline __m128i modulateHalf(__m128i s, __m128i d, __m128i tint)
+	{
+		__m128i t = div255(_mm_mullo_epi16(s, tint));
+		__m128i source = _mm_or_si128(t, _mm_set_epi16(255, 0, 0, 0, 255, 0, 0, 0));
+		return div255(_mm_mullo_epi16(source, d));
+	}
+
+	// Each kernel on one group of 4 source and destination pixels, giving the new destination.
+	inline __m128i copyGroup(__m128i s, __m128i, __m128i tint)
+	{
+		const __m128i zero = _mm_setzero_si128();
+		__m128i low = div255(_mm_mullo_epi16(_mm_unpacklo_epi8(s, zero), tint));
+		__m128i high = div255(_mm_mullo_epi16(_mm_unpackhi_epi8(s, zero), tint));
+		return _mm_packus_epi16(low, high);
+	}
+
+	inline __m128i blendGroup(__m128i s, __m128i d, __m128i tint)
+	{
+		const __m128i zero = _mm_setzero_si128();
+		__m128i low = blendHalf(_mm_unpacklo_epi8(s, zero), _mm_unpacklo_epi8(d, zero), tint);
+		__m128i high = blendHalf(_mm_unpackhi_epi8(s, zero), _mm_unpackhi_epi8(d, zero), tint);
+		return _mm_packus_epi16(low, high);
+	}
+
+	inline __m128i addGroup(__m128i s, __m128i d, __m128i tint)
+	{
+		const __m128i zero = _mm_setzero_si128();
+		__m128i added = _mm_packus_epi16(addHalf(_mm_unpacklo_epi8(s, zero), tint), addHalf(_mm_unpackhi_epi8(s, zero), tint));
+		return _mm_adds_epu8(d, added);
+	}
+
+	inline __m128i modulateGroup(__m128i s, __m128i d, __m128i tint)
+	{
+		const __m128i zero = _mm_setzero_si128();
+		__m128i low = modulateHalf(_mm_unpacklo_epi8(s, zero), _mm_unpacklo_epi8(d, zero), tint);
+		__m128i high = modulateHalf(_mm_unpackhi_epi8(s, zero), _mm_unpackhi_epi8(d, zero), tint);
+		return _mm_packus_epi16(low, high);
+	}
+
+	inline __m128i maskedCopyGroup(__m128i s, __m128i d, __m128i tint)
+	{
+		__m128i t = copyGroup(s, d, tint);
+		__m128i clear = _mm_cmpeq_epi32(_mm_and_si128(t, _mm_set1_epi32((int)0xFF000000)), _mm_setzero_si128());
+		return _mm_or_si128(_mm_and_si128(clear, d), _mm_andnot_si128(clear, t));
+	}
+
+	// The first count (under 4) pixels at p, the rest of the lanes zero: transparent.
+	inline __m128i loadPartial(const uint32_t* p, size_t count)
+	{
+		return _mm_setr_epi32((int)p[0], count > 1 ? (int)p[1] : 0, count > 2 ? (int)p[2] : 0, 0);
+	}
+
+	inline void storePartial(uint32_t* p, __m128i pixels, size_t count)
+	{
+		for (size_t i = 0; i < count; i++, pixels = _mm_srli_si128(pixels, 4))
+			p[i] = (uint32_t)_mm_cvtsi128_si32(pixels);
+	}
+
+	// Every group, then the last few pixels as one more, padded with transparent ones.
+	// Sprite runs make short spans common, and one more group costs far less than the
+	// scalar code per pixel. Groups of transparent source pixels are skipped when the
+	// kernel leaves the destination alone under them.
+	template<__m128i (*group)(__m128i, __m128i, __m128i), bool skipTransparent>
+	void runSSE2(uint32_t* pDst, const uint32_t* pSrc, size_t count, uint32_t color)
+	{
+		const __m128i tint = _mm_unpacklo_epi8(_mm_set1_epi32((int)color), _mm_setzero_si128());
+		size_t i = 0;
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128i s = _mm_loadu_si128((const __m128i*)(pSrc + i));
+			if (skipTransparent && allTransparent(s))
+				continue;
+			__m128i d = _mm_loadu_si128((const __m128i*)(pDst + i));
+			_mm_storeu_si128((__m128i*)(pDst + i), group(s, d, tint));
+		}
+		if (i < count)
+		{
+			__m128i s = loadPartial(pSrc + i, count - i);
+			if (skipTransparent && allTransparent(s))
+				return;
+			storePartial(pDst + i, group(s, loadPartial(pDst + i, count - i), tint), count - i);
+		}
+	}
+
+	void copySSE2(uint32_t* pDst, const uint32_t* pSrc, size_t count, uint32_t color)
+	{
+		if (color == opaqueWhite)
+			memcpy(pDst, pSrc, count * sizeof(uint32_t));
+		else
+			runSSE2<copyGroup, false>(pDst, pSrc, count, color);
+	}
+
+	void blendSSE2(uint32_t* pDst, const uint32_t* pSrc, size_t count, uint32_t color)
+	{
+		runSSE2<blendGroup, true>(pDst, pSrc, count, color);
+	}
+
+	void addSSE2(uint32_t* pDst, const uint32_t* pSrc, size_t count, uint32_t color)
+	{
+		runSSE2<addGroup, true>(pDst, pSrc, count, color);
+	}
+
+	void modulateSSE2(uint32_t* pDst, const uint32_t* pSrc, size_t count, uint32_t color)
+	{
+		runSSE2<modulateGroup, false>(pDst, pSrc, count, color);
+	}
+
+	void maskedCopySSE2(uint32_t* pDst, const uint32_t* pSrc, size_t count, uint32_t color)
+	{
+		runSSE2<maskedCopyGroup, true>(pDst, pSrc, count, color);
+	}
+
+	SDLGAME_TARGET_AVX2 inline __m256i div255(__m256i x)
+	{
+		x = _mm256_add_epi16(x, _mm256_set1_epi16(128));
+		return _mm256_srli_epi16(_mm256_add_epi16(x, _mm256_srli_epi16(x, 8)), 8);
+	}
+
+	SDLGAME_TARGET_AVX2 inline __m256i spreadAlpha(__m256i x)
+	{
+		return _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(x, 0xFF), 0xFF);
+	}
+
+	SDLGAME_TARGET_AVX2 inline bool allTransparent(__m256i pixels)
+	{
+		__m256i alpha = _mm256_and_si256(pixels, _mm256_set1_epi32((int)0xFF000000));
+		return _mm256_movemask_epi8(_mm256_cmpeq_epi32(alpha, _mm256_setzero_si256())) == -1;
+	}
+
+	SDLGAME_TARGET_AVX2 inline __m256i opaqueLanes()
+	{
+		return _mm256_set_epi16(255, 0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0);
+	}
+
+	SDLGAME_TARGET_AVX2 inline __m256i blendHalf(__m256i s, __m256i d, __m256i tint)
+	{
+		__m256i t = div255(_mm256_mullo_epi16(s, tint));
+		__m256i alpha = spreadAlpha(t);
+		__m256i source = _mm256_or_si256(t, opaqueLanes());
+		return div255(_mm256_add_epi16(_mm256_mullo_epi16(source, alpha), _mm256_mullo_epi16(d, _mm256_sub_epi16(_mm256_set1_epi16(255), alpha))));
+	}
+
+	SDLGAME_TARGET_AVX2 inline __m256i addHalf(__m256i s, __m256i tint)
+	{
+		__m256i t = div255(_mm256_mullo_epi16(s, tint));
+		__m256i color = _mm256_andnot_si256(opaqueLanes(), t);
+		return div255(_mm256_mullo_epi16(color, spreadAlpha(t)));
+	}
+
+	SDLGAME_TARGET_AVX2 inline __m256i modulateHalf(__m256i s, __m256i d, __m256i tint)
+	{
+		__m256i t = div255(_mm256_mullo_epi16(s, tint));
+		return div255(_mm256_mullo_epi16(_mm256_or_si256(t, opaqueLanes()), d));
+	}
+
+	SDLGAME_TARGET_AVX2 inline __m256i copyGroup(__m256i s, __m256i, __m256i tint)
+	{
+		const __m256i zero = _mm256_setzero_si256();
+		__m256i low = div255(_mm256_mullo_epi16(_mm256_unpacklo_epi8(s, zero), tint));
+		__m256i high = div255(_mm256_mullo_epi16(_mm256_unpackhi_epi8(s, zero), tint));
+		return _mm256_packus_epi16(low, high);
+	}
+
+	SDLGAME_TARGET_AVX2 inline __m256i blendGroup(__m256i s, __m256i d, __m256i tint)
+	{
+		const __m256i zero = _mm256_setzero_si256();
+		__m256i low = blendHalf(_mm256_unpacklo_epi8(s, zero), _mm256_unpacklo_epi8(d, zero), tint);
+		__m256i high = blendHalf(_mm256_unpackhi_epi8(s, zero), _mm256_unpackhi_epi8(d, zero), tint);
+		return _mm256_packus_epi16(low, high);
+	}
+
+	SDLGAME_TARGET_AVX2 inline __m256i addGroup(__m256i s, __m256i d, __m256i tint)
+	{
+		const __m256i zero = _mm256_setzero_si256();
+		__m256i added = _mm256_packus_epi16(addHalf(_mm256_unpacklo_epi8(s, zero), tint), addHalf(_mm256_unpackhi_epi8(s, zero), tint));
+		return _mm256_adds_epu8(d, added);
+	}
+
+	SDLGAME_TARGET_AVX2 inline __m256i modulateGroup(__m256i s, __m256i d, __m256i tint)
+	{
+		const __m256i zero = _mm256_setzero_si256();
+		__m256i low = modulateHalf(_mm256_unpacklo_epi8(s, zero), _mm256_unpacklo_epi8(d, zero), tint);
+		__m256i high = modulateHalf(_mm256_unpackhi_epi8(s, zero), _mm256_unpackhi_epi8(d, zero), tint);
+		return _mm256_packus_epi16(low, high);
+	}
+
+	SDLGAME_TARGET_AVX2 inline __m256i maskedCopyGroup(__m256i s, __m256i d, __m256i tint)
+	{
+		__m256i t = copyGroup(s, d, tint);
+		__m256i clear = _mm256_cmpeq_epi32(_mm256_and_si256(t, _mm256_set1_epi32((int)0xFF000000)), _mm256_setzero_si256());
+		return _mm256_blendv_epi8(t, d, clear);
+	}
+
+	// As runSSE2, 8 pixels at a time. The last group uses masked loads and stores, which
+	// read zeros (transparent) past the end and leave the pixels there alone.
+	template<__m256i (*group)(__m256i, __m256i, __m256i), bool skipTransparent>
+	SDLGAME_TARGET_AVX2 void runAVX2(uint32_t* pDst, const uint32_t* pSrc, size_t count, uint32_t color)
+	{
+		const __m256i tint = _mm256_unpacklo_epi8(_mm256_set1_epi32((int)color), _mm256_setzero_si256());
+		size_t i = 0;
+		for (; i + 8 <= count; i += 8)
+		{
+			__m256i s = _mm256_loadu_si256((const __m256i*)(pSrc + i));
+			if (skipTransparent && allTransparent(s))
+				continue;
+			__m256i d = _mm256_loadu_si256((const __m256i*)(pDst + i));
+			_mm256_storeu_si256((__m256i*)(pDst + i), group(s, d, tint));
+		}
+		if (i < count)
+		{
+			__m256i mask = _mm256_cmpgt_epi32(_mm256_set1_epi32((int)(count - i)), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+			__m256i s = _mm256_maskload_epi32((const int*)(pSrc + i), mask);
+			if (!skipTransparent || !allTransparent(s))
+			{
+				__m256i d = _mm256_maskload_epi32((const int*)(pDst + i), mask);
+				_mm256_maskstore_epi32((int*)(pDst + i), mask, group(s, d, tint));
+			}
+		}
+		_mm256_zeroupper();
+	}
+
+	SDLGAME_TARGET_AVX2 void copyAVX2(uint32_t* pDst, const uint32_t* pSrc, size_t count, uint32_t color)
+	{
+		if (color == opaqueWhite)
+			memcpy(pDst, pSrc, count * sizeof(uint32_t));
+		else
+			runAVX2<copyGroup, false>(pDst, pSrc, count, color);
+	}
+
+	SDLGAME_TARGET_AVX2 void blendAVX2(uint32_t* pDst, const uint32_t* pSrc, size_t count, uint32_t color)
+	{
+		runAVX2<blendGroup, true>(pDst, pSrc, count, color);
+	}
+
+	SDLGAME_TARGET_AVX2 void addAVX2(uint32_t* pDst, const uint32_t* pSrc, size_t count, uint32_t color)
+	{
+		runAVX2<addGroup, true>(pDst, pSrc, count, color);
+	}
+
+	SDLGAME_TARGET_AVX2 void modulateAVX2(uint32_t* pDst, const uint32_t* pSrc, size_t count, uint32_t color)
+	{
+		runAVX2<modulateGroup, false>(pDst, pSrc, count, color);
+	}
+
+	SDLGAME_TARGET_AVX2 void maskedCopyAVX2(uint32_t* pDst, const uint32_t* pSrc, size_t count, uint32_t color)
+	{
+		runAVX2<maskedCopyGroup, true>(pDst, pSrc, count, color);
+	}
+#endif
+
+	const BlitKernels kernelTable[] = {
+		{ SimdLevel::Scalar, copyPlain, blendPlain, addPlain, modulatePlain, maskedCopyPlain },
+#if defined(SDLGAME_X86)
+		{ SimdLevel::SSE2, copySSE2, blendSSE2, addSSE2, modulateSSE2, maskedCopySSE2 },
+		{ SimdLevel::AVX2, copyAVX2, blendAVX2, addAVX2, modulateAVX2, maskedCopyAVX2 },
+#endif
+	};
+}
+
+const BlitKernels& blitKernels(SimdLevel level)
+{
+	static const SimdLevel supported = detectSimdLevel();
+	if ((int)level > (int)supported)
+		level = supported;
+	for (const BlitKernels& kernels : kernelTable)
+	{
+		if (kernels.level == level)
+			return kernels;
+	}
+	return kernelTable[0];
+}
+
+const BlitKernels& blitKernels()
+{
+	static const BlitKernels& best = blitKernels(detectSimdLevel());
+	return best;
+}
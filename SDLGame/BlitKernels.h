@@ -0,0 +1,48 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include "CollisionKernels.h"
+
+// Row kernels for drawing sprites in software (see SoftwareBlitter).
+//
+// Each one combines count source pixels with count destination pixels and writes the
+// result over the destination. Pixels are 32 bits with alpha in the top byte; the other
+// three bytes are colour channels treated alike, so any order works as long as source,
+// destination and color agree. Sources are straight (not premultiplied) alpha.
+//
+// color tints the source first, the way SDL's colour and alpha mod do: every channel,
+// alpha included, is multiplied by color's and divided by 255. Every division by 255
+// rounds to nearest, so all levels give the same bytes.
+//
+// The SIMD versions do 4 (SSE2) or 8 (AVX2) pixels at a time in 16-bit lanes, and the
+// blending ones skip groups of fully transparent source pixels without touching the
+// destination. blitKernels() picks the widest version this CPU runs, once, at first use.
+typedef void (*BlitKernel)(uint32_t* pDst, const uint32_t* pSrc, size_t count, uint32_t color);
+
+struct BlitKernels
+{
+	SimdLevel level;
+
+	// SDL_BLENDMODE_NONE: dst = src.
+	BlitKernel copy;
+
+	// SDL_BLENDMODE_BLEND: dstRGB = srcRGB * srcA + dstRGB * (1 - srcA), dstA = srcA + dstA * (1 - srcA).
+	BlitKernel blend;
+
+	// SDL_BLENDMODE_ADD: dstRGB = dstRGB + srcRGB * srcA, saturating; dstA is kept.
+	BlitKernel add;
+
+	// SDL_BLENDMODE_MOD: dstRGB = srcRGB * dstRGB; dstA is kept.
+	BlitKernel modulate;
+
+	// dst = src wherever the source's alpha isn't 0. For sources with binary alpha (0 or
+	// 255) at full alpha that is what BLEND gives, without the blending maths.
+	BlitKernel maskedCopy;
+};
+
+// The best kernels for this CPU.
+const BlitKernels& blitKernels();
+
+// The kernels for one level, for comparing them. Levels the CPU can't run give the
+// best one it can.
+const BlitKernels& blitKernels(SimdLevel level);
@@ -0,0 +1,81 @@
+#include "Broadphase.h"
+#include <algorithm>
+#include "EntityStore.h"
+#include "SpatialHash.h"
+#include "SweepAndPrune.h"
+
+void Broadphase::clear()
+{
+	minX.clear();
+	minY.clear();
+	maxX.clear();
+	maxY.clear();
+	layerBits.clear();
+	addedGroups.clear();
+}
+
+uint32_t Broadphase::grow(size_t count, CollisionLayer layer)
+{
+	uint32_t first = (uint32_t)minX.size();
+	minX.resize(first + count);
+	minY.resize(first + count);
+	maxX.resize(first + count);
+	maxY.resize(first + count);
+	layerBits.resize(first + count, layerMatrix.filterBits(layer));
+	addedGroups.push_back({ first, layer });
+	return first;
+}
+
+uint32_t Broadphase::add(const float* pX, const float* pY, const float* pW, const float* pH, size_t count, CollisionLayer layer)
+{
+	uint32_t first = grow(count, layer);
+	for (size_t i = 0; i < count; i++)
+	{
+		minX[first + i] = pX[i];
+		minY[first + i] = pY[i];
+		maxX[first + i] = pX[i] + pW[i];
+		maxY[first + i] = pY[i] + pH[i];
+	}
+	return first;
+}
+
+uint32_t Broadphase::add(const EntityStore& store, CollisionLayer layer)
+{
+	uint32_t first = grow(store.size(), layer);
+	for (size_t i = 0; i < store.size(); i++)
+	{
+		minX[first + i] = toFloat(store.x[i]);
+		minY[first + i] = toFloat(store.y[i]);
+		maxX[first + i] = toFloat(store.x[i] + store.w[i]);
+		maxY[first + i] = toFloat(store.y[i] + store.h[i]);
+	}
+	return first;
+}
+
+uint32_t Broadphase::addSwept(const EntityStore& store, CollisionLayer layer)
+{
+	uint32_t first = grow(store.size(), layer);
+	for (size_t i = 0; i < store.size(); i++)
+	{
+		minX[first + i] = toFloat(std::min(store.prevX[i], store.x[i]));
+		minY[first + i] = toFloat(std::min(store.prevY[i], store.y[i]));
+		maxX[first + i] = toFloat(std::max(store.prevX[i], store.x[i]) + store.w[i]);
+		maxY[first + i] = toFloat(std::max(store.prevY[i], store.y[i]) + store.h[i]);
+	}
+	return first;
+}
+
+const std::vector<std::string>& broadphaseNames()
+{
+	static const std::vector<std::string> names = { "spatial-hash", "sweep-and-prune" };
+	return names;
+}
+
+std::unique_ptr<Broadphase> createBroadphase(const std::string& name)
+{
+	if (name == "spatial-hash")
+		return std::make_unique<SpatialHash>();
+	if (name == "sweep-and-prune")
+		return std::make_unique<SweepAndPrune>();
+	return nullptr;
+}
@@ -0,0 +1,93 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "CollisionLayers.h"
+
+class EntityStore;
+
+// Two boxes that overlap, by the ids Broadphase::add gave them. a < b.
+struct BoxPair
+{
+	uint32_t a;
+	uint32_t b;
+};
+
+// Finds which of many boxes overlap, without testing every pair.
+//
+// Every tick: clear(), add() each group of boxes, build(), then findPairs(). Ids are
+// given out in the order boxes are added, starting from 0 after each clear(). Every
+// group is on a CollisionLayer, and only boxes whose layers collide (setLayers()) are
+// paired. The backends differ in what they keep from one tick to the next; which is
+// faster depends on how the objects move, so scenes pick one by name.
+class Broadphase
+{
+public:
+	virtual ~Broadphase() = default;
+
+	virtual const char* name() const = 0;
+
+	// Lets a backend tune itself for objects of these sizes (the longer side of each, pixels).
+	virtual void fitSizes(const std::vector<float>& /*sizes*/) {}
+
+	// Which layers collide. Boxes take their layer's row when they're added, so set it
+	// before add(). Until then every layer collides with every other.
+	void setLayers(const LayerMatrix& matrix) { layerMatrix = matrix; }
+	const LayerMatrix& layers() const { return layerMatrix; }
+
+	void clear();
+
+	// Adds count boxes on layer, box i covering (x[i], y[i]) to (x[i] + w[i], y[i] + h[i]).
+	// Returns the id of the first one; the rest follow in order.
+	uint32_t add(const float* pX, const float* pY, const float* pW, const float* pH, size_t count, CollisionLayer layer);
+
+	// Adds every entity's box. Boxes are floats whatever Real is: toFloat() of the
+	// fixed-point state gives the same floats on every build.
+	uint32_t add(const EntityStore& store, CollisionLayer layer);
+
+	// Adds every entity as the box it swept through during the last tick, from
+	// (prevX, prevY) to (x, y). Fast objects then meet whatever lies along their path,
+	// not only what is under them at the end of the tick.
+	uint32_t addSwept(const EntityStore& store, CollisionLayer layer);
+
+	// The boxes one add() put in: ids from first up to the next group's first.
+	struct Group
+	{
+		uint32_t first;
+		CollisionLayer layer;
+	};
+
+	// Since clear(), in id order.
+	const std::vector<Group>& groups() const { return addedGroups; }
+
+	size_t size() const { return minX.size(); }
+
+	// Gets the boxes added since clear() ready for finding pairs.
+	virtual void build() = 0;
+
+	// Replaces pairs with every pair of overlapping boxes whose layers collide, each pair once.
+	virtual void findPairs(std::vector<BoxPair>& pairs) const = 0;
+
+	// Only pairs between two groups added one after the other: a below split, b at or
+	// above it. For bullets against enemies, split is the id add() returned for the enemies.
+	virtual void findPairsBetween(uint32_t split, std::vector<BoxPair>& pairs) const = 0;
+
+protected:
+	// Makes room for count more boxes on layer and returns the first one's id.
+	uint32_t grow(size_t count, CollisionLayer layer);
+
+	std::vector<float> minX, minY, maxX, maxY;
+	std::vector<uint32_t> layerBits; // LayerMatrix::filterBits() of each box's layer
+
+private:
+	LayerMatrix layerMatrix;
+	std::vector<Group> addedGroups;
+};
+
+// Names of all backends; the first is the default.
+const std::vector<std::string>& broadphaseNames();
+
+// Creates a backend by name, or returns nullptr if there is no such backend.
+std::unique_ptr<Broadphase> createBroadphase(const std::string& name);
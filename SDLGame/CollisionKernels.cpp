@@ -0,0 +1,218 @@
+#include "CollisionKernels.h"
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define SDLGAME_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+// MSVC lets any function use any intrinsic; GCC and Clang need to be told which
+// functions may use AVX2, so the rest of the program still runs without it. The AVX2
+// kernels clear the upper halves of the registers before returning: SSE code running
+// after them would otherwise pay a penalty on every instruction on many CPUs.
+#if defined(SDLGAME_X86) && !defined(_MSC_VER)
+#define SDLGAME_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define SDLGAME_TARGET_AVX2
+#endif
+
+namespace
+{
+	// For every mask of matching lanes, the numbers of those lanes packed to the front.
+	// Adding the first pair's index and storing all of them appends the matches in one
+	// go; the lanes past the matches are overwritten by the next store.
+	template <int Lanes>
+	struct LeftPackTable
+	{
+		alignas(32) uint32_t lanes[1 << Lanes][Lanes];
+		uint8_t counts[1 << Lanes];
+
+		LeftPackTable()
+		{
+			for (int mask = 0; mask < (1 << Lanes); mask++)
+			{
+				int count = 0;
+				for (int lane = 0; lane < Lanes; lane++)
+				{
+					lanes[mask][lane] = 0;
+					if (mask & (1 << lane))
+						lanes[mask][count++] = lane;
+				}
+				counts[mask] = (uint8_t)count;
+			}
+		}
+	};
+
+	const LeftPackTable<4> packTable4;
+	const LeftPackTable<8> packTable8;
+
+	size_t overlapBoxesScalar(const BoxArrays& a, const BoxArrays& b, size_t count, uint32_t* pOut, size_t start, size_t written)
+	{
+		for (size_t i = start; i < count; i++)
+		{
+			bool overlap = (a.minX[i] < b.maxX[i]) & (b.minX[i] < a.maxX[i]) & (a.minY[i] < b.maxY[i]) & (b.minY[i] < a.maxY[i]);
+			pOut[written] = (uint32_t)i;
+			written += overlap;
+		}
+		return written;
+	}
+
+	size_t overlapCirclesScalar(const CircleArrays& a, const CircleArrays& b, size_t count, uint32_t* pOut, size_t start, size_t written)
+	{
+		for (size_t i = start; i < count; i++)
+		{
+			float dx = a.x[i] - b.x[i], dy = a.y[i] - b.y[i];
+			float reach = a.radius[i] + b.radius[i];
+			pOut[written] = (uint32_t)i;
+			written += dx * dx + dy * dy < reach * reach;
+		}
+		return written;
+	}
+
+	size_t overlapBoxesPlain(const BoxArrays& a, const BoxArrays& b, size_t count, uint32_t* pOut)
+	{
+		return overlapBoxesScalar(a, b, count, pOut, 0, 0);
+	}
+
+	size_t overlapCirclesPlain(const CircleArrays& a, const CircleArrays& b, size_t count, uint32_t* pOut)
+	{
+		return overlapCirclesScalar(a, b, count, pOut, 0, 0);
+	}
+
+#if defined(SDLGAME_X86)
+	size_t overlapBoxesSSE2(const BoxArrays& a, const BoxArrays& b, size_t count, uint32_t* pOut)
+	{
+		size_t i = 0, written = 0;
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128 x = _mm_and_ps(_mm_cmplt_ps(_mm_loadu_ps(a.minX + i), _mm_loadu_ps(b.maxX + i)), _mm_cmplt_ps(_mm_loadu_ps(b.minX + i), _mm_loadu_ps(a.maxX + i)));
+			__m128 y = _mm_and_ps(_mm_cmplt_ps(_mm_loadu_ps(a.minY + i), _mm_loadu_ps(b.maxY + i)), _mm_cmplt_ps(_mm_loadu_ps(b.minY + i), _mm_loadu_ps(a.maxY + i)));
+			int mask = _mm_movemask_ps(_mm_and_ps(x, y));
+			_mm_storeu_si128((__m128i*)(pOut + written), _mm_add_epi32(_mm_load_si128((const __m128i*)packTable4.lanes[mask]), _mm_set1_epi32((int)i)));
+			written += packTable4.counts[mask];
+		}
+		return overlapBoxesScalar(a, b, count, pOut, i, written);
+	}
+
+	size_t overlapCirclesSSE2(const CircleArrays& a, const CircleArrays& b, size_t count, uint32_t* pOut)
+	{
+		size_t i = 0, written = 0;
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128 dx = _mm_sub_ps(_mm_loadu_ps(a.x + i), _mm_loadu_ps(b.x + i));
+			__m128 dy = _mm_sub_ps(_mm_loadu_ps(a.y + i), _mm_loadu_ps(b.y + i));
+			__m128 reach = _mm_add_ps(_mm_loadu_ps(a.radius + i), _mm_loadu_ps(b.radius + i));
+			__m128 distance = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+			int mask = _mm_movemask_ps(_mm_cmplt_ps(distance, _mm_mul_ps(reach, reach)));
+			_mm_storeu_si128((__m128i*)(pOut + written), _mm_add_epi32(_mm_load_si128((const __m128i*)packTable4.lanes[mask]), _mm_set1_epi32((int)i)));
+			written += packTable4.counts[mask];
+		}
+		return overlapCirclesScalar(a, b, count, pOut, i, written);
+	}
+
+	SDLGAME_TARGET_AVX2 size_t overlapBoxesAVX2(const BoxArrays& a, const BoxArrays& b, size_t count, uint32_t* pOut)
+	{
+		size_t i = 0, written = 0;
+		for (; i + 8 <= count; i += 8)
+		{
+			__m256 x = _mm256_and_ps(_mm256_cmp_ps(_mm256_loadu_ps(a.minX + i), _mm256_loadu_ps(b.maxX + i), _CMP_LT_OQ),
+				_mm256_cmp_ps(_mm256_loadu_ps(b.minX + i), _mm256_loadu_ps(a.maxX + i), _CMP_LT_OQ));
+			__m256 y = _mm256_and_ps(_mm256_cmp_ps(_mm256_loadu_ps(a.minY + i), _mm256_loadu_ps(b.maxY + i), _CMP_LT_OQ),
+				_mm256_cmp_ps(_mm256_loadu_ps(b.minY + i), _mm256_loadu_ps(a.maxY + i), _CMP_LT_OQ));
+			int mask = _mm256_movemask_ps(_mm256_and_ps(x, y));
+			_mm256_storeu_si256((__m256i*)(pOut + written), _mm256_add_epi32(_mm256_load_si256((const __m256i*)packTable8.lanes[mask]), _mm256_set1_epi32((int)i)));
+			written += packTable8.counts[mask];
+		}
+		_mm256_zeroupper();
+		return overlapBoxesScalar(a, b, count, pOut, i, written);
+	}
+
+	SDLGAME_TARGET_AVX2 size_t overlapCirclesAVX2(const CircleArrays& a, const CircleArrays& b, size_t count, uint32_t* pOut)
+	{
+		size_t i = 0, written = 0;
+		for (; i + 8 <= count; i += 8)
+		{
+			__m256 dx = _mm256_sub_ps(_mm256_loadu_ps(a.x + i), _mm256_loadu_ps(b.x + i));
+			__m256 dy = _mm256_sub_ps(_mm256_loadu_ps(a.y + i), _mm256_loadu_ps(b.y + i));
+			__m256 reach = _mm256_add_ps(_mm256_loadu_ps(a.radius + i), _mm256_loadu_ps(b.radius + i));
+			__m256 distance = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+			int mask = _mm256_movemask_ps(_mm256_cmp_ps(distance, _mm256_mul_ps(reach, reach), _CMP_LT_OQ));
+			_mm256_storeu_si256((__m256i*)(pOut + written), _mm256_add_epi32(_mm256_load_si256((const __m256i*)packTable8.lanes[mask]), _mm256_set1_epi32((int)i)));
+			written += packTable8.counts[mask];
+		}
+		_mm256_zeroupper();
+		return overlapCirclesScalar(a, b, count, pOut, i, written);
+	}
+#endif
+
+	const CollisionKernels kernelTable[] = {
+		{ SimdLevel::Scalar, overlapBoxesPlain, overlapCirclesPlain },
+#if defined(SDLGAME_X86)
+		{ SimdLevel::SSE2, overlapBoxesSSE2, overlapCirclesSSE2 },
+		{ SimdLevel::AVX2, overlapBoxesAVX2, overlapCirclesAVX2 },
+#endif
+	};
+}
+
+SimdLevel detectSimdLevel()
+{
+#if !defined(SDLGAME_X86)
+	return SimdLevel::Scalar;
+#elif defined(_MSC_VER)
+	// AVX2 needs the CPU to have it and the OS to save the wide registers (OSXSAVE, then XCR0).
+	int info[4];
+	__cpuid(info, 0);
+	int highest = info[0];
+	__cpuid(info, 1);
+	bool sse2 = (info[3] & (1 << 26)) != 0;
+	bool osSavesAvx = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && (_xgetbv(0) & 6) == 6;
+	bool avx2 = false;
+	if (osSavesAvx && highest >= 7)
+	{
+		__cpuidex(info, 7, 0);
+		avx2 = (info[1] & (1 << 5)) != 0;
+	}
+	return avx2 ? SimdLevel::AVX2 : sse2 ? SimdLevel::SSE2 : SimdLevel::Scalar;
+#else
+	// The builtins read CPUID and check that the OS saves the AVX registers.
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2"))
+		return SimdLevel::AVX2;
+	if (__builtin_cpu_supports("sse2"))
+		return SimdLevel::SSE2;
+	return SimdLevel::Scalar;
+#endif
+}
+
+const char* simdLevelName(SimdLevel level)
+{
+	switch (level)
+	{
+	case SimdLevel::SSE2:
+		return "sse2";
+	case SimdLevel::AVX2:
+		return "avx2";
+	default:
+		return "scalar";
+	}
+}
+
+const CollisionKernels& collisionKernels(SimdLevel level)
+{
+	static const SimdLevel supported = detectSimdLevel();
+	if ((int)level > (int)supported)
+		level = supported;
+	for (const CollisionKernels& kernels : kernelTable)
+	{
+		if (kernels.level == level)
+			return kernels;
+	}
+	return kernelTable[0];
+}
+
+const CollisionKernels& collisionKernels()
+{
+	static const CollisionKernels& best = collisionKernels(detectSimdLevel());
+	return best;
+}
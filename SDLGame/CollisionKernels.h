@@ -0,0 +1,59 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Narrow-phase overlap tests over many pairs at once.
+//
+// Pair i is a[i] against b[i]: the caller lays both sides of every candidate pair out
+// as plain float arrays, one per field, so the SIMD versions test 4 (SSE2) or 8 (AVX2)
+// pairs with each instruction. Every kernel writes the indices of the pairs that
+// overlap to pOut, which needs room for count of them, and returns how many it wrote.
+//
+// collisionKernels() picks the widest version this CPU runs, once, at first use.
+
+// Boxes by their edges, pixels.
+struct BoxArrays
+{
+	const float* minX;
+	const float* minY;
+	const float* maxX;
+	const float* maxY;
+};
+
+// Circles by their centre and radius, pixels.
+struct CircleArrays
+{
+	const float* x;
+	const float* y;
+	const float* radius;
+};
+
+enum class SimdLevel
+{
+	Scalar,
+	SSE2,
+	AVX2,
+};
+
+struct CollisionKernels
+{
+	SimdLevel level;
+
+	// Boxes overlap if they share more than an edge.
+	size_t (*overlapBoxes)(const BoxArrays& a, const BoxArrays& b, size_t count, uint32_t* pOut);
+
+	// Circles overlap if their centres are closer than the sum of their radii.
+	size_t (*overlapCircles)(const CircleArrays& a, const CircleArrays& b, size_t count, uint32_t* pOut);
+};
+
+// The best kernels for this CPU.
+const CollisionKernels& collisionKernels();
+
+// The kernels for one level, for comparing them. Levels the CPU can't run give the
+// best one it can.
+const CollisionKernels& collisionKernels(SimdLevel level);
+
+// The widest level this CPU (and OS) supports, from CPUID.
+SimdLevel detectSimdLevel();
+
+const char* simdLevelName(SimdLevel level);
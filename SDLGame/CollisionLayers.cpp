@@ -0,0 +1,35 @@
+#include "CollisionLayers.h"
+#include <initializer_list>
+
+LayerMatrix::LayerMatrix()
+{
+	for (uint32_t& row : rows)
+		row = (1u << collisionLayerCount) - 1;
+}
+
+LayerMatrix LayerMatrix::game()
+{
+	LayerMatrix matrix;
+	for (uint32_t& row : matrix.rows)
+		row = 0;
+	for (CollisionLayer other : { CollisionLayer::Enemy, CollisionLayer::EnemyLaser, CollisionLayer::Meteor, CollisionLayer::PowerUp })
+		matrix.set(CollisionLayer::Player, other, true);
+	matrix.set(CollisionLayer::PlayerLaser, CollisionLayer::Enemy, true);
+	matrix.set(CollisionLayer::PlayerLaser, CollisionLayer::Meteor, true);
+	matrix.set(CollisionLayer::Meteor, CollisionLayer::Meteor, true);
+	return matrix;
+}
+
+void LayerMatrix::set(CollisionLayer a, CollisionLayer b, bool collide)
+{
+	if (collide)
+	{
+		rows[(int)a] |= 1u << (int)b;
+		rows[(int)b] |= 1u << (int)a;
+	}
+	else
+	{
+		rows[(int)a] &= ~(1u << (int)b);
+		rows[(int)b] &= ~(1u << (int)a);
+	}
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include <cstdint>
+
+// What kind of object a box is, for deciding which boxes can collide at all.
+enum class CollisionLayer : uint8_t
+{
+	Player,
+	PlayerLaser,
+	Enemy,
+	EnemyLaser,
+	Meteor,
+	PowerUp,
+	Count
+};
+
+const int collisionLayerCount = (int)CollisionLayer::Count;
+
+// Which layers collide with which: a row of bits per layer, kept symmetric. The
+// broadphase tests it along with each pair's boxes, so pairs nothing cares about
+// (two of the player's lasers, a power-up and a meteor) never get as far as the
+// narrow phase.
+class LayerMatrix
+{
+public:
+	// Every layer collides with every layer, itself included.
+	LayerMatrix();
+
+	// The game's rules: the player against everything the enemies have and every
+	// power-up, the player's lasers against enemies and meteors, meteors against each other.
+	static LayerMatrix game();
+
+	// Sets whether a and b collide, both ways round.
+	void set(CollisionLayer a, CollisionLayer b, bool collide);
+
+	bool collides(CollisionLayer a, CollisionLayer b) const { return (rows[(int)a] >> (int)b & 1) != 0; }
+
+	// What the broadphase keeps for a box on layer: the layer's bit in the low 16 bits
+	// and the bits of the layers it collides with in the high 16. Boxes with bits a and
+	// b can collide if (a >> 16) & b is not 0.
+	uint32_t filterBits(CollisionLayer layer) const { return rows[(int)layer] << 16 | 1u << (int)layer; }
+
+private:
+	static_assert(collisionLayerCount <= 16, "filterBits() has 16 bits for layers");
+
+	uint32_t rows[collisionLayerCount];
+};
@@ -0,0 +1,345 @@
+#include "CollisionMask.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#include "Real.h"
+#include "Sweep.h"
+
+namespace
+{
+	// Index of the lowest set bit. v must not be zero.
+	int lowestSetBit(uint64_t v)
+	{
+#if defined(_MSC_VER)
+		// _BitScanForward64 doesn't exist in 32-bit builds.
+		unsigned long index;
+		if (_BitScanForward(&index, (unsigned long)v))
+			return (int)index;
+		_BitScanForward(&index, (unsigned long)(v >> 32));
+		return (int)index + 32;
+#else
+		return __builtin_ctzll(v);
+#endif
+	}
+
+	// Keeps the even bits of v and packs them into the low 32 bits.
+	uint64_t compactEvenBits(uint64_t v)
+	{
+		v &= 0x5555555555555555ull;
+		v = (v | (v >> 1)) & 0x3333333333333333ull;
+		v = (v | (v >> 2)) & 0x0F0F0F0F0F0F0F0Full;
+		v = (v | (v >> 4)) & 0x00FF00FF00FF00FFull;
+		v = (v | (v >> 8)) & 0x0000FFFF0000FFFFull;
+		v = (v | (v >> 16)) & 0x00000000FFFFFFFFull;
+		return v;
+	}
+
+	// The 64 bits of a row starting at pixel x, which may lie partly or wholly outside it.
+	uint64_t bitsAt(const uint64_t* pRow, int wordsPerRow, int x)
+	{
+		int word = x >= 0 ? x / 64 : -((63 - x) / 64);
+		int shift = x - word * 64;
+		uint64_t low = word >= 0 && word < wordsPerRow ? pRow[word] : 0;
+		if (shift == 0)
+			return low;
+		uint64_t high = word + 1 >= 0 && word + 1 < wordsPerRow ? pRow[word + 1] : 0;
+		return (low >> shift) | (high << (64 - shift));
+	}
+}
+
+size_t CollisionMask::layout(int width, int height)
+{
+	size_t offset = 0;
+	for (int level = 0; level < levelCount; level++)
+	{
+		Level& l = levels[level];
+		l.width = width > 0 ? ((width - 1) >> level) + 1 : 0;
+		l.height = height > 0 ? ((height - 1) >> level) + 1 : 0;
+		l.wordsPerRow = (l.width + 63) / 64;
+		l.offset = offset;
+		offset += (size_t)l.wordsPerRow * l.height;
+	}
+	return offset;
+}
+
+size_t CollisionMask::wordCountFor(int width, int height)
+{
+	CollisionMask sizing;
+	return sizing.layout(width, height);
+}
+
+void CollisionMask::clear()
+{
+	layout(0, 0);
+	words.clear();
+}
+
+void CollisionMask::build(const void* pixels, int width, int height, int pitch, uint8_t alphaThreshold)
+{
+	words.assign(layout(width, height), 0);
+
+	for (int y = 0; y < height; y++)
+	{
+		const uint32_t* pPixels = (const uint32_t*)((const uint8_t*)pixels + (size_t)y * pitch);
+		uint64_t* pRow = words.data() + (size_t)y * levels[0].wordsPerRow;
+		for (int x = 0; x < width; x++)
+		{
+			if ((pPixels[x] >> 24) >= alphaThreshold)
+				pRow[x / 64] |= 1ull << (x % 64);
+		}
+	}
+
+	// Each level from the one before: OR row pairs together, then bit pairs.
+	for (int level = 1; level < levelCount; level++)
+	{
+		const Level& source = levels[level - 1];
+		const Level& target = levels[level];
+		for (int y = 0; y < target.height; y++)
+		{
+			const uint64_t* pTop = row(y * 2, level - 1);
+			const uint64_t* pBottom = y * 2 + 1 < source.height ? row(y * 2 + 1, level - 1) : pTop;
+			uint64_t* pRow = words.data() + target.offset + (size_t)y * target.wordsPerRow;
+			for (int word = 0; word < target.wordsPerRow; word++)
+			{
+				int low = word * 2, high = word * 2 + 1;
+				uint64_t lowBits = pTop[low] | pBottom[low];
+				uint64_t highBits = high < source.wordsPerRow ? pTop[high] | pBottom[high] : 0;
+				pRow[word] = compactEvenBits(lowBits | (lowBits >> 1)) | compactEvenBits(highBits | (highBits >> 1)) << 32;
+			}
+		}
+	}
+}
+
+bool CollisionMask::assign(int width, int height, const uint64_t* pWords, size_t wordCount)
+{
+	if (width < 0 || height < 0 || wordCount != layout(width, height))
+	{
+		clear();
+		return false;
+	}
+	words.assign(pWords, pWords + wordCount);
+	return true;
+}
+
+bool CollisionMask::test(int x, int y, int level) const
+{
+	if (x < 0 || y < 0 || x >= levels[level].width || y >= levels[level].height)
+		return false;
+	return (row(y, level)[x / 64] >> (x % 64)) & 1;
+}
+
+float CollisionMask::radiusAround(float x, float y) const
+{
+	// Only the first and last solid pixel of each row can be farthest.
+	float farthest = 0.0f;
+	for (int row = 0; row < height(); row++)
+	{
+		const uint64_t* pRow = this->row(row);
+		int first = -1, last = -1;
+		for (int word = 0; word < wordsPerRow(); word++)
+		{
+			if (pRow[word] == 0)
+				continue;
+			if (first < 0)
+				first = word * 64 + lowestSetBit(pRow[word]);
+			uint64_t bits = pRow[word];
+			int top = 63;
+			while (!(bits >> top))
+				top--;
+			last = word * 64 + top;
+		}
+		if (first < 0)
+			continue;
+		float dy = std::max(std::abs(row - y), std::abs(row + 1 - y));
+		float dx = std::max(std::abs(first - x), std::abs(last + 1 - x));
+		farthest = std::max(farthest, dx * dx + dy * dy);
+	}
+	return std::sqrt(farthest);
+}
+
+bool CollisionMask::overlaps(const CollisionMask& a, const CollisionMask& b, int dx, int dy)
+{
+	// Only the rows and columns both masks cover.
+	int x0 = std::max(0, dx), x1 = std::min(a.width(), dx + b.width());
+	int y0 = std::max(0, dy), y1 = std::min(a.height(), dy + b.height());
+	if (x0 >= x1 || y0 >= y1)
+		return false;
+
+	int firstWord = x0 / 64, lastWord = (x1 - 1) / 64;
+	for (int y = y0; y < y1; y++)
+	{
+		const uint64_t* pRowA = a.row(y);
+		const uint64_t* pRowB = b.row(y - dy);
+		for (int word = firstWord; word <= lastWord; word++)
+		{
+			// Bits past either mask's width are zero, so nothing outside the overlap can match.
+			if (pRowA[word] & bitsAt(pRowB, b.wordsPerRow(), word * 64 - dx))
+				return true;
+		}
+	}
+	return false;
+}
+
+bool CollisionMask::overlapsRect(int x0, int y0, int x1, int y1) const
+{
+	x0 = std::max(x0, 0);
+	y0 = std::max(y0, 0);
+	x1 = std::min(x1, width());
+	y1 = std::min(y1, height());
+	if (x0 >= x1 || y0 >= y1)
+		return false;
+
+	int firstWord = x0 / 64, lastWord = (x1 - 1) / 64;
+	uint64_t firstBits = ~0ull << (x0 % 64);
+	uint64_t lastBits = ~0ull >> (63 - (x1 - 1) % 64);
+	for (int y = y0; y < y1; y++)
+	{
+		const uint64_t* pRow = row(y);
+		for (int word = firstWord; word <= lastWord; word++)
+		{
+			uint64_t bits = pRow[word];
+			if (word == firstWord)
+				bits &= firstBits;
+			if (word == lastWord)
+				bits &= lastBits;
+			if (bits)
+				return true;
+		}
+	}
+	return false;
+}
+
+bool CollisionMask::overlapsRotated(const CollisionMask& a, const MaskPlacement& placeA, const CollisionMask& b, const MaskPlacement& placeB, int level)
+{
+	if (a.isEmpty() || b.isEmpty())
+		return false;
+	level = std::min(std::max(level, 0), levelCount - 1);
+
+	// One affine map from a's pixels to b's: rotate about a's pivot into the world,
+	// then back about b's pivot into b.
+	float cosA, sinA, cosB, sinB;
+	sinCosDegrees(placeA.angle, sinA, cosA);
+	sinCosDegrees(placeB.angle, sinB, cosB);
+	float pivotAX = placeA.pivotX * a.width(), pivotAY = placeA.pivotY * a.height();
+	float pivotBX = placeB.pivotX * b.width(), pivotBY = placeB.pivotY * b.height();
+
+	// Rotating by A, then by -B, is rotating by A - B.
+	float c = cosA * cosB + sinA * sinB;
+	float s = sinA * cosB - cosA * sinB;
+	float offsetX = placeA.x + pivotAX - placeB.x - pivotBX;
+	float offsetY = placeA.y + pivotAY - placeB.y - pivotBY;
+	float translateX = cosB * offsetX + sinB * offsetY + pivotBX;
+	float translateY = -sinB * offsetX + cosB * offsetY + pivotBY;
+
+	// Only a's cells that can land inside b need testing: b's corners mapped back into
+	// a (the inverse rotation) bound them. Grazing pairs then test a sliver of a.
+	float minAX = (float)a.width(), minAY = (float)a.height(), maxAX = 0.0f, maxAY = 0.0f;
+	float cornersB[4][2] = { { 0.0f, 0.0f }, { (float)b.width(), 0.0f }, { 0.0f, (float)b.height() }, { (float)b.width(), (float)b.height() } };
+	for (const float* pCorner : cornersB)
+	{
+		float px = pCorner[0] - translateX, py = pCorner[1] - translateY;
+		float ax = c * px + s * py + pivotAX;
+		float ay = -s * px + c * py + pivotAY;
+		minAX = std::min(minAX, ax);
+		minAY = std::min(minAY, ay);
+		maxAX = std::max(maxAX, ax);
+		maxAY = std::max(maxAY, ay);
+	}
+	int x0 = std::max(0, (int)std::floor(minAX) >> level), x1 = std::min(a.width(level) - 1, (int)std::floor(maxAX) >> level);
+	int y0 = std::max(0, (int)std::floor(minAY) >> level), y1 = std::min(a.height(level) - 1, (int)std::floor(maxAY) >> level);
+	if (x0 > x1 || y0 > y1)
+		return false;
+
+	// Work in cells of this level: positions scale down, the rotation doesn't change.
+	float cell = (float)(1 << level);
+	float inverseCell = 1.0f / cell;
+	int firstWord = x0 / 64, lastWord = x1 / 64;
+	uint64_t firstBits = ~0ull << (x0 % 64);
+	uint64_t lastBits = ~0ull >> (63 - x1 % 64);
+	for (int y = y0; y <= y1; y++)
+	{
+		const uint64_t* pRow = a.row(y, level);
+		float centerY = (y + 0.5f) * cell - pivotAY;
+		float rowX = -s * centerY + translateX;
+		float rowY = c * centerY + translateY;
+		for (int word = firstWord; word <= lastWord; word++)
+		{
+			uint64_t bits = pRow[word];
+			if (word == firstWord)
+				bits &= firstBits;
+			if (word == lastWord)
+				bits &= lastBits;
+			for (; bits != 0; bits &= bits - 1)
+			{
+				int x = word * 64 + lowestSetBit(bits);
+				float centerX = (x + 0.5f) * cell - pivotAX;
+				float bx = (c * centerX + rowX) * inverseCell;
+				float by = (s * centerX + rowY) * inverseCell;
+				if (bx >= 0.0f && by >= 0.0f && b.test((int)bx, (int)by, level))
+					return true;
+			}
+		}
+	}
+	return false;
+}
+
+bool CollisionMask::raycast(const MaskPlacement& place, float fromX, float fromY, float toX, float toY, int level, float& hitTime) const
+{
+	if (isEmpty())
+		return false;
+	level = std::min(std::max(level, 0), levelCount - 1);
+
+	// Into the mask's own pixels: undo the rotation about the pivot.
+	float c, s;
+	sinCosDegrees(place.angle, s, c);
+	float pivotX = place.pivotX * width(), pivotY = place.pivotY * height();
+	float px = fromX - place.x - pivotX, py = fromY - place.y - pivotY;
+	float x0 = c * px + s * py + pivotX;
+	float y0 = -s * px + c * py + pivotY;
+	px = toX - place.x - pivotX;
+	py = toY - place.y - pivotY;
+	float dx = c * px + s * py + pivotX - x0;
+	float dy = -s * px + c * py + pivotY - y0;
+
+	// Start where the segment enters the mask, if it does.
+	float t;
+	if (!sweepBounds({ x0, y0, x0, y0 }, dx, dy, { 0.0f, 0.0f, (float)width(), (float)height() }, t))
+		return false;
+
+	// Step from cell to cell, always across whichever edge the segment reaches first.
+	const float infinity = std::numeric_limits<float>::infinity();
+	float cell = (float)(1 << level);
+	int cellX = std::min(std::max((int)((x0 + dx * t) / cell), 0), width(level) - 1);
+	int cellY = std::min(std::max((int)((y0 + dy * t) / cell), 0), height(level) - 1);
+	int stepX = dx > 0.0f ? 1 : -1, stepY = dy > 0.0f ? 1 : -1;
+	float deltaX = dx != 0.0f ? cell / std::abs(dx) : infinity;
+	float deltaY = dy != 0.0f ? cell / std::abs(dy) : infinity;
+	float nextX = dx != 0.0f ? ((cellX + (dx > 0.0f)) * cell - x0) / dx : infinity;
+	float nextY = dy != 0.0f ? ((cellY + (dy > 0.0f)) * cell - y0) / dy : infinity;
+	while (t <= 1.0f)
+	{
+		if (test(cellX, cellY, level))
+		{
+			hitTime = t;
+			return true;
+		}
+		if (nextX < nextY)
+		{
+			cellX += stepX;
+			t = nextX;
+			nextX += deltaX;
+		}
+		else
+		{
+			cellY += stepY;
+			t = nextY;
+			nextY += deltaY;
+		}
+		if (cellX < 0 || cellY < 0 || cellX >= width(level) || cellY >= height(level))
+			break;
+	}
+	return false;
+}
@@ -0,0 +1,87 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Where a mask's image is in the world, for CollisionMask::overlapsRotated.
+struct MaskPlacement
+{
+	float x = 0.0f, y = 0.0f;           // top-left of the unrotated image
+	float angle = 0.0f;                 // degrees clockwise around the pivot, as in SpriteAtlas::draw
+	float pivotX = 0.5f, pivotY = 0.5f; // fraction of the image size
+};
+
+// One bit per pixel of an image, set where it's solid enough to hit something (alpha
+// at or above a threshold). Each row is a run of 64-bit words with pixel x in bit
+// x % 64 of word x / 64, so testing two masks against each other is a shifted AND per
+// row: 64 pixels at a time, at close to the cost of comparing bounding boxes.
+//
+// Level 0 is the full-resolution mask. Every further level halves both sides, a bit
+// being set if any of the four under it is. Rotated tests use them to check far fewer
+// cells when they don't need every pixel.
+//
+// Tools/AssetPackBuilder.cpp builds a mask for every image and stores it in the pack.
+class CollisionMask
+{
+public:
+	static constexpr int levelCount = 4;
+	static constexpr uint8_t defaultThreshold = 128;
+
+	// Builds every level from 32-bit pixels with alpha in the top byte (ARGB8888, ABGR8888).
+	void build(const void* pixels, int width, int height, int pitch, uint8_t alphaThreshold = defaultThreshold);
+
+	// Takes the words of a mask built elsewhere, all levels as data() returns them.
+	// Returns false (and leaves the mask empty) if wordCount doesn't fit the size.
+	bool assign(int width, int height, const uint64_t* pWords, size_t wordCount);
+
+	void clear();
+	bool isEmpty() const { return levels[0].width == 0; }
+
+	int width(int level = 0) const { return levels[level].width; }
+	int height(int level = 0) const { return levels[level].height; }
+	int wordsPerRow(int level = 0) const { return levels[level].wordsPerRow; }
+	const uint64_t* row(int y, int level = 0) const { return words.data() + levels[level].offset + (size_t)y * levels[level].wordsPerRow; }
+
+	// False outside the mask.
+	bool test(int x, int y, int level = 0) const;
+
+	// Distance from (x, y), in pixels, to the farthest corner of any solid pixel: the
+	// smallest circle there that holds the shape at every angle. 0 if nothing is solid.
+	float radiusAround(float x, float y) const;
+
+	// Every level, one after another, for storing in a pack.
+	const std::vector<uint64_t>& data() const { return words; }
+	static size_t wordCountFor(int width, int height);
+
+	// Whether a solid pixel of b, with b's top-left at (dx, dy) in a's pixels, lands on a solid pixel of a. Exact.
+	static bool overlaps(const CollisionMask& a, const CollisionMask& b, int dx, int dy);
+
+	// Whether any solid pixel lies in the box from (x0, y0) to (x1, y1), ends excluded, in this mask's pixels.
+	bool overlapsRect(int x0, int y0, int x1, int y1) const;
+
+	// Maps the centre of every solid cell of a at this level into b and checks b's cell
+	// there. Accurate to about a cell (1 << level pixels) either way: level 0 for exact
+	// hits, higher levels when a few pixels of slack are fine and speed matters.
+	static bool overlapsRotated(const CollisionMask& a, const MaskPlacement& placeA, const CollisionMask& b, const MaskPlacement& placeB, int level);
+
+	// Walks the cells of a level that the segment from (fromX, fromY) to (toX, toY), in
+	// world pixels, crosses with the mask placed at place, in order. hitTime is how far
+	// along the segment (0 to 1) it enters the first solid one. For lasers and other
+	// thin, fast things: the segment is the path they took during the tick.
+	bool raycast(const MaskPlacement& place, float fromX, float fromY, float toX, float toY, int level, float& hitTime) const;
+
+private:
+	struct Level
+	{
+		int width;
+		int height;
+		int wordsPerRow;
+		size_t offset; // into words
+	};
+
+	// Fills in levels for this size and returns how many words they need.
+	size_t layout(int width, int height);
+
+	Level levels[levelCount] = {};
+	std::vector<uint64_t> words;
+};
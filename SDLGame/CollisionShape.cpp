@@ -0,0 +1,298 @@
+#include "CollisionShape.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "ConvexHull.h"
+#include "Real.h"
+
+namespace
+{
+	const float degrees = 3.14159265f / 180.0f;
+
+	typedef HullPoint Point;
+
+	// Smallest circle holding every point; the incremental algorithm, which is plenty
+	// for the few dozen points of a hull.
+	void enclosingCircle(const std::vector<Point>& points, float& x, float& y, float& radius)
+	{
+		auto inside = [&](const Point& p) { return (p.x - x) * (p.x - x) + (p.y - y) * (p.y - y) <= radius * radius * 1.0001f + 1e-4f; };
+		auto throughTwo = [&](const Point& a, const Point& b)
+		{
+			x = (a.x + b.x) * 0.5f;
+			y = (a.y + b.y) * 0.5f;
+			radius = std::sqrt((a.x - x) * (a.x - x) + (a.y - y) * (a.y - y));
+		};
+
+		x = points[0].x;
+		y = points[0].y;
+		radius = 0.0f;
+		for (size_t i = 1; i < points.size(); i++)
+		{
+			if (inside(points[i]))
+				continue;
+			x = points[i].x;
+			y = points[i].y;
+			radius = 0.0f;
+			for (size_t j = 0; j < i; j++)
+			{
+				if (inside(points[j]))
+					continue;
+				throughTwo(points[i], points[j]);
+				for (size_t k = 0; k < j; k++)
+				{
+					if (inside(points[k]))
+						continue;
+
+					// The circle through all three.
+					const Point& a = points[i];
+					const Point& b = points[j];
+					const Point& c = points[k];
+					float d = 2.0f * (a.x * (b.y - c.y) + b.x * (c.y - a.y) + c.x * (a.y - b.y));
+					if (d == 0.0f)
+					{
+						// In line: the two farthest apart are the diameter.
+						float ab = (a.x - b.x) * (a.x - b.x) + (a.y - b.y) * (a.y - b.y);
+						float ac = (a.x - c.x) * (a.x - c.x) + (a.y - c.y) * (a.y - c.y);
+						float bc = (b.x - c.x) * (b.x - c.x) + (b.y - c.y) * (b.y - c.y);
+						if (ab >= ac && ab >= bc)
+							throughTwo(a, b);
+						else if (ac >= bc)
+							throughTwo(a, c);
+						else
+							throughTwo(b, c);
+						continue;
+					}
+					float a2 = a.x * a.x + a.y * a.y, b2 = b.x * b.x + b.y * b.y, c2 = c.x * c.x + c.y * c.y;
+					x = (a2 * (b.y - c.y) + b2 * (c.y - a.y) + c2 * (a.y - b.y)) / d;
+					y = (a2 * (c.x - b.x) + b2 * (a.x - c.x) + c2 * (b.x - a.x)) / d;
+					radius = std::sqrt((a.x - x) * (a.x - x) + (a.y - y) * (a.y - y));
+				}
+			}
+		}
+	}
+
+	// A rotation and a move: where one sprite's pixels land in the world, or in another sprite's pixels.
+	struct Placed
+	{
+		float c, s;
+		float originX, originY; // where pixel (0, 0) lands
+
+		Point apply(float x, float y) const { return { originX + c * x - s * y, originY + s * x + c * y }; }
+	};
+
+	// From b's pixels to a's, as in CollisionMask::overlapsRotated: rotate about b's
+	// pivot into the world, then back about a's pivot into a.
+	Placed relativePlacement(const CollisionShape& a, const MaskPlacement& placeA, const CollisionShape& b, const MaskPlacement& placeB)
+	{
+		float cosA, sinA, cosB, sinB;
+		sinCosDegrees(placeA.angle, sinA, cosA);
+		sinCosDegrees(placeB.angle, sinB, cosB);
+		float pivotAX = placeA.pivotX * a.width, pivotAY = placeA.pivotY * a.height;
+		float pivotBX = placeB.pivotX * b.width, pivotBY = placeB.pivotY * b.height;
+
+		// Rotating by B, then by -A, is rotating by B - A.
+		Placed placed;
+		placed.c = cosB * cosA + sinB * sinA;
+		placed.s = sinB * cosA - cosB * sinA;
+		float offsetX = placeB.x + pivotBX - placeA.x - pivotAX;
+		float offsetY = placeB.y + pivotBY - placeA.y - pivotAY;
+		placed.originX = cosA * offsetX + sinA * offsetY + pivotAX - (placed.c * pivotBX - placed.s * pivotBY);
+		placed.originY = -sinA * offsetX + cosA * offsetY + pivotAY - (placed.s * pivotBX + placed.c * pivotBY);
+		return placed;
+	}
+
+	// A convex polygon of up to maxHullPoints points, padded out to exactly that many by
+	// repeating the last one: the projections below then run a fixed number of times and
+	// vectorise, and repeated points change no polygon's extent along an axis.
+	struct Polygon
+	{
+		float x[CollisionShape::maxHullPoints];
+		float y[CollisionShape::maxHullPoints];
+		int count;
+	};
+
+	void pad(Polygon& polygon)
+	{
+		for (int i = polygon.count; i < CollisionShape::maxHullPoints; i++)
+		{
+			polygon.x[i] = polygon.x[polygon.count - 1];
+			polygon.y[i] = polygon.y[polygon.count - 1];
+		}
+	}
+
+	// Whether an edge of p is a line with all of q on its outer side. Hulls and boxes
+	// both go counter-clockwise (with y up), so p itself is on the inner side of every
+	// one of its edges and only q needs projecting.
+	bool separatedByEdgeOf(const Polygon& p, const Polygon& q)
+	{
+		for (int i = 0, previous = p.count - 1; i < p.count; previous = i++)
+		{
+			float axisX = p.y[previous] - p.y[i], axisY = p.x[i] - p.x[previous];
+			float edge = axisX * p.x[i] + axisY * p.y[i];
+			float d[CollisionShape::maxHullPoints];
+			for (int j = 0; j < CollisionShape::maxHullPoints; j++)
+				d[j] = axisX * q.x[j] + axisY * q.y[j];
+			float farthest = d[0];
+			for (int j = 1; j < CollisionShape::maxHullPoints; j++)
+				farthest = std::max(farthest, d[j]);
+			if (farthest <= edge)
+				return true;
+		}
+		return false;
+	}
+
+	bool convexOverlap(const Polygon& p, const Polygon& q)
+	{
+		return !separatedByEdgeOf(p, q) && !separatedByEdgeOf(q, p);
+	}
+
+	void boxCorners(const CollisionShape& shape, const Placed& placed, Polygon& corners)
+	{
+		float ux, uy;
+		sinCosDegrees(shape.boxAngle, uy, ux);
+		float alongX = ux * shape.boxHalfW, alongY = uy * shape.boxHalfW;
+		float acrossX = -uy * shape.boxHalfH, acrossY = ux * shape.boxHalfH;
+		const float signs[4][2] = { { -1.0f, -1.0f }, { 1.0f, -1.0f }, { 1.0f, 1.0f }, { -1.0f, 1.0f } };
+		corners.count = 4;
+		for (int i = 0; i < 4; i++)
+		{
+			Point corner = placed.apply(shape.boxX + alongX * signs[i][0] + acrossX * signs[i][1], shape.boxY + alongY * signs[i][0] + acrossY * signs[i][1]);
+			corners.x[i] = corner.x;
+			corners.y[i] = corner.y;
+		}
+		pad(corners);
+	}
+}
+
+void CollisionShape::build(const CollisionMask& mask)
+{
+	*this = CollisionShape();
+	width = (float)mask.width();
+	height = (float)mask.height();
+
+	// Only the first and last solid pixel of each row can be on the hull; take the corners of both.
+	std::vector<Point> points;
+	for (int y = 0; y < mask.height(); y++)
+	{
+		const uint64_t* pRow = mask.row(y);
+		int first = -1, last = -1;
+		for (int word = 0; word < mask.wordsPerRow(); word++)
+		{
+			uint64_t bits = pRow[word];
+			if (bits == 0)
+				continue;
+			if (first < 0)
+			{
+				int bit = 0;
+				while (!((bits >> bit) & 1))
+					bit++;
+				first = word * 64 + bit;
+			}
+			int top = 63;
+			while (!(bits >> top))
+				top--;
+			last = word * 64 + top;
+		}
+		if (first < 0)
+			continue;
+		points.push_back({ (float)first, (float)y });
+		points.push_back({ (float)first, (float)(y + 1) });
+		points.push_back({ (float)(last + 1), (float)y });
+		points.push_back({ (float)(last + 1), (float)(y + 1) });
+	}
+	if (points.empty())
+		return;
+
+	std::vector<Point> hull = convexHull(points);
+	enclosingCircle(hull, circleX, circleY, radius);
+
+	// The smallest box has a side along one of the hull's edges: try each.
+	float bestArea = -1.0f;
+	for (size_t i = 0; i < hull.size(); i++)
+	{
+		const Point& from = hull[i];
+		const Point& to = hull[(i + 1) % hull.size()];
+		float length = std::sqrt((to.x - from.x) * (to.x - from.x) + (to.y - from.y) * (to.y - from.y));
+		if (length == 0.0f)
+			continue;
+		float ux = (to.x - from.x) / length, uy = (to.y - from.y) / length;
+
+		float minU = INFINITY, maxU = -INFINITY, minV = INFINITY, maxV = -INFINITY;
+		for (const Point& p : hull)
+		{
+			float u = p.x * ux + p.y * uy, v = -p.x * uy + p.y * ux;
+			minU = std::min(minU, u);
+			maxU = std::max(maxU, u);
+			minV = std::min(minV, v);
+			maxV = std::max(maxV, v);
+		}
+		float area = (maxU - minU) * (maxV - minV);
+		if (bestArea < 0.0f || area < bestArea)
+		{
+			bestArea = area;
+			float centerU = (minU + maxU) * 0.5f, centerV = (minV + maxV) * 0.5f;
+			boxX = centerU * ux - centerV * uy;
+			boxY = centerU * uy + centerV * ux;
+			boxHalfW = (maxU - minU) * 0.5f;
+			boxHalfH = (maxV - minV) * 0.5f;
+			boxAngle = std::atan2(uy, ux) / degrees;
+		}
+	}
+
+	// Should simplifying ever fail, the box holds everything too.
+	if (!simplifyHull(hull, maxHullPoints))
+	{
+		Polygon corners;
+		boxCorners(*this, { 1.0f, 0.0f, 0.0f, 0.0f }, corners);
+		hull.clear();
+		for (int i = 0; i < corners.count; i++)
+			hull.push_back({ corners.x[i], corners.y[i] });
+	}
+	hullCount = (int)hull.size();
+	for (int i = 0; i < hullCount; i++)
+	{
+		hullX[i] = hull[i].x;
+		hullY[i] = hull[i].y;
+	}
+}
+
+bool CollisionShape::overlaps(const CollisionShape& a, const MaskPlacement& placeA, const CollisionShape& b, const MaskPlacement& placeB)
+{
+	if (a.isEmpty() || b.isEmpty())
+		return false;
+
+	// Everything in a's pixels, so only b moves.
+	Placed bToA = relativePlacement(a, placeA, b, placeB);
+	Point circleB = bToA.apply(b.circleX, b.circleY);
+	float dx = a.circleX - circleB.x, dy = a.circleY - circleB.y, reach = a.radius + b.radius;
+	if (dx * dx + dy * dy >= reach * reach)
+		return false;
+
+	Polygon hullA, hullB;
+	hullA.count = a.hullCount;
+	for (int i = 0; i < a.hullCount; i++)
+	{
+		hullA.x[i] = a.hullX[i];
+		hullA.y[i] = a.hullY[i];
+	}
+	hullB.count = b.hullCount;
+	for (int i = 0; i < b.hullCount; i++)
+	{
+		Point point = bToA.apply(b.hullX[i], b.hullY[i]);
+		hullB.x[i] = point.x;
+		hullB.y[i] = point.y;
+	}
+	pad(hullA);
+	pad(hullB);
+	return convexOverlap(hullA, hullB);
+}
+
+bool CollisionShape::boxesOverlap(const CollisionShape& a, const MaskPlacement& placeA, const CollisionShape& b, const MaskPlacement& placeB)
+{
+	if (a.isEmpty() || b.isEmpty())
+		return false;
+	Polygon boxA, boxB;
+	boxCorners(a, { 1.0f, 0.0f, 0.0f, 0.0f }, boxA);
+	boxCorners(b, relativePlacement(a, placeA, b, placeB), boxB);
+	return convexOverlap(boxA, boxB);
+}
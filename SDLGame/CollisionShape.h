@@ -0,0 +1,36 @@
+#pragma once
+#include "CollisionMask.h"
+
+// Convex outlines of a sprite's solid pixels: a circle, an oriented box and a convex
+// hull of at most maxHullPoints points, from loosest to tightest. Worked out once from
+// the collision mask by Tools/AtlasPacker.cpp and stored in the sprite table.
+//
+// Each one holds every solid pixel whole, so when overlaps() says two sprites don't
+// touch they don't. When it says they do, they may still miss by a few pixels where
+// the hull bridges a dent; the masks settle that if it matters. Everything is in the
+// pixels of the original image (width x height), like the mask.
+struct CollisionShape
+{
+	static constexpr int maxHullPoints = 8;
+
+	float width = 0.0f, height = 0.0f; // of the image, for the pivot in MaskPlacement
+	float circleX = 0.0f, circleY = 0.0f, radius = 0.0f;
+	float boxX = 0.0f, boxY = 0.0f;         // centre of the oriented box
+	float boxHalfW = 0.0f, boxHalfH = 0.0f; // half its sides, along and across boxAngle
+	float boxAngle = 0.0f;                  // degrees clockwise from the image's x axis
+	int hullCount = 0;                      // 0 if nothing is solid
+	float hullX[maxHullPoints] = {}, hullY[maxHullPoints] = {}; // in order around the hull
+
+	bool isEmpty() const { return hullCount == 0; }
+
+	// Works out every shape from level 0 of mask. Empty if nothing is solid.
+	void build(const CollisionMask& mask);
+
+	// Whether the hulls overlap, each sprite placed as for CollisionMask::overlapsRotated.
+	// The circles are tried first, then a separating axis test on the hulls. Empty
+	// shapes touch nothing.
+	static bool overlaps(const CollisionShape& a, const MaskPlacement& placeA, const CollisionShape& b, const MaskPlacement& placeB);
+
+	// The same for the oriented boxes alone: looser, but half the axes of the hulls.
+	static bool boxesOverlap(const CollisionShape& a, const MaskPlacement& placeA, const CollisionShape& b, const MaskPlacement& placeB);
+};
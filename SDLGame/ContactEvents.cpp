@@ -0,0 +1,50 @@
+#include "ContactEvents.h"
+#include <algorithm>
+#include <utility>
+
+void ContactEvents::collect(const Broadphase& broadphase, const std::vector<BoxPair>& pairs)
+{
+	// Which add() each box came from. There are only a few, so a binary search is short.
+	const std::vector<Broadphase::Group>& groups = broadphase.groups();
+	auto groupOf = [&groups](uint32_t box) -> const Broadphase::Group&
+	{
+		auto after = std::upper_bound(groups.begin(), groups.end(), box, [](uint32_t id, const Broadphase::Group& group) { return id < group.first; });
+		return *(after - 1);
+	};
+
+	// Counting sort by slot, like the spatial hash's buckets: count, prefix sums, scatter.
+	const size_t count = pairs.size();
+	localPairs.resize(count);
+	pairSlots.resize(count);
+	std::fill(slotStart, slotStart + slotCount + 1, 0);
+	for (size_t i = 0; i < count; i++)
+	{
+		const Broadphase::Group& groupA = groupOf(pairs[i].a);
+		const Broadphase::Group& groupB = groupOf(pairs[i].b);
+		CollisionLayer layerA = groupA.layer, layerB = groupB.layer;
+		BoxPair local = { pairs[i].a - groupA.first, pairs[i].b - groupB.first };
+		if (layerA > layerB)
+		{
+			std::swap(layerA, layerB);
+			std::swap(local.a, local.b);
+		}
+		uint32_t slot = (uint32_t)layerA * collisionLayerCount + (uint32_t)layerB;
+		localPairs[i] = local;
+		pairSlots[i] = slot;
+		slotStart[slot + 1]++;
+	}
+	for (int slot = 0; slot < slotCount; slot++)
+		slotStart[slot + 1] += slotStart[slot];
+
+	uint32_t cursor[slotCount];
+	std::copy(slotStart, slotStart + slotCount, cursor);
+	events.resize(count);
+	for (size_t i = 0; i < count; i++)
+		events[cursor[pairSlots[i]]++] = localPairs[i];
+}
+
+ContactEvents::Range ContactEvents::between(CollisionLayer first, CollisionLayer second) const
+{
+	int slot = (int)first * collisionLayerCount + (int)second;
+	return { events.data() + slotStart[slot], events.data() + slotStart[slot + 1] };
+}
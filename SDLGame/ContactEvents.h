@@ -0,0 +1,47 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Broadphase.h"
+#include "CollisionLayers.h"
+
+// One tick's contacts, grouped by the two layers they're between, for gameplay to
+// take in bulk: every hit of the player's lasers on a meteor in one run, every meteor
+// that reached the player in another, and no call per pair. Filled once a tick from
+// the broadphase's pairs, or from whatever the narrow phase kept of them.
+class ContactEvents
+{
+public:
+	// A run of contacts, as pairs of indices into the stores that were added.
+	struct Range
+	{
+		const BoxPair* pBegin;
+		const BoxPair* pEnd;
+
+		const BoxPair* begin() const { return pBegin; }
+		const BoxPair* end() const { return pEnd; }
+		size_t size() const { return pEnd - pBegin; }
+	};
+
+	// Replaces the contacts with pairs, found by broadphase since its last clear(). Ids
+	// become indices within the add() that put each box in, so a layer whose contacts
+	// are to be told apart should go in with one add(). Within each run pairs keep the
+	// order they had.
+	void collect(const Broadphase& broadphase, const std::vector<BoxPair>& pairs);
+
+	// The contacts between first and second, a on first and b on second. first must not
+	// come after second in CollisionLayer. On one layer, a is the box added first.
+	Range between(CollisionLayer first, CollisionLayer second) const;
+
+	size_t size() const { return events.size(); }
+
+private:
+	static const int slotCount = collisionLayerCount * collisionLayerCount;
+
+	std::vector<BoxPair> events;      // sorted by slot: first layer, then second
+	uint32_t slotStart[slotCount + 1] = {};
+
+	// Scratch, kept so collecting doesn't allocate every tick.
+	std::vector<BoxPair> localPairs;
+	std::vector<uint32_t> pairSlots;
+};
@@ -0,0 +1,124 @@
+#include "ConvexHull.h"
+#include <algorithm>
+#include <cmath>
+#include <initializer_list>
+
+namespace
+{
+	// Positive if o -> a -> b turns one way, negative the other, 0 if they're in line.
+	float cross(const HullPoint& o, const HullPoint& a, const HullPoint& b)
+	{
+		return (a.x - o.x) * (b.y - o.y) - (a.y - o.y) * (b.x - o.x);
+	}
+}
+
+std::vector<HullPoint> convexHull(std::vector<HullPoint> points)
+{
+	std::sort(points.begin(), points.end(), [](const HullPoint& a, const HullPoint& b) { return a.x < b.x || (a.x == b.x && a.y < b.y); });
+	std::vector<HullPoint> hull(points.size() * 2);
+	size_t count = 0;
+	for (size_t i = 0; i < points.size(); i++)
+	{
+		while (count >= 2 && cross(hull[count - 2], hull[count - 1], points[i]) <= 0.0f)
+			count--;
+		hull[count++] = points[i];
+	}
+	for (size_t i = points.size() - 1, lower = count + 1; i-- > 0;)
+	{
+		while (count >= lower && cross(hull[count - 2], hull[count - 1], points[i]) <= 0.0f)
+			count--;
+		hull[count++] = points[i];
+	}
+	hull.resize(count > 1 ? count - 1 : count);
+	return hull;
+}
+
+bool simplifyHull(std::vector<HullPoint>& hull, size_t maxPoints)
+{
+	while (hull.size() > maxPoints)
+	{
+		size_t n = hull.size();
+		size_t best = n;
+		float bestArea = 0.0f;
+		HullPoint bestPoint = {};
+		for (size_t i = 0; i < n; i++)
+		{
+			const HullPoint& before = hull[(i + n - 1) % n];
+			const HullPoint& from = hull[i];
+			const HullPoint& to = hull[(i + 1) % n];
+			const HullPoint& after = hull[(i + 2) % n];
+
+			// Extend before -> from forwards and after -> to backwards until they meet.
+			float d1x = from.x - before.x, d1y = from.y - before.y;
+			float d2x = to.x - after.x, d2y = to.y - after.y;
+			float ex = to.x - from.x, ey = to.y - from.y;
+			float denominator = d1x * d2y - d1y * d2x;
+			if (denominator == 0.0f)
+				continue;
+			float t = (ex * d2y - ey * d2x) / denominator;
+			float s = (ex * d1y - ey * d1x) / denominator;
+			if (t < 0.0f || s < 0.0f)
+				continue;
+
+			HullPoint meet = { from.x + d1x * t, from.y + d1y * t };
+			float area = std::abs(cross(from, meet, to)) * 0.5f;
+			if (best == n || area < bestArea)
+			{
+				best = i;
+				bestArea = area;
+				bestPoint = meet;
+			}
+		}
+		if (best == n)
+			return false;
+
+		hull[best] = bestPoint;
+		hull.erase(hull.begin() + (best + 1) % n);
+	}
+	return true;
+}
+
+void clipHull(std::vector<HullPoint>& hull, float minX, float minY, float maxX, float maxY)
+{
+	// Sutherland-Hodgman, one side at a time: each side is a line x or y = limit with the
+	// inside on one side of it.
+	struct Side
+	{
+		bool vertical;
+		float limit;
+		bool keepBelow;
+	};
+	std::vector<HullPoint> clipped;
+	for (const Side& side : { Side{ true, minX, false }, Side{ true, maxX, true }, Side{ false, minY, false }, Side{ false, maxY, true } })
+	{
+		auto inside = [&](const HullPoint& p) { float v = side.vertical ? p.x : p.y; return side.keepBelow ? v <= side.limit : v >= side.limit; };
+		clipped.clear();
+		for (size_t i = 0; i < hull.size(); i++)
+		{
+			const HullPoint& from = hull[i];
+			const HullPoint& to = hull[(i + 1) % hull.size()];
+			if (inside(from))
+				clipped.push_back(from);
+			if (inside(from) != inside(to))
+			{
+				float t = side.vertical ? (side.limit - from.x) / (to.x - from.x) : (side.limit - from.y) / (to.y - from.y);
+				HullPoint crossing = { from.x + (to.x - from.x) * t, from.y + (to.y - from.y) * t };
+				(side.vertical ? crossing.x : crossing.y) = side.limit;
+				clipped.push_back(crossing);
+			}
+		}
+		hull.swap(clipped);
+	}
+}
+
+float hullArea(const std::vector<HullPoint>& hull)
+{
+	float twice = 0.0f;
+	for (size_t i = 0; i < hull.size(); i++)
+	{
+		const HullPoint& from = hull[i];
+		const HullPoint& to = hull[(i + 1) % hull.size()];
+		twice += from.x * to.y - to.x * from.y;
+	}
+	return std::abs(twice) * 0.5f;
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+// Convex polygons around sets of points, shared by the collision shapes
+// (CollisionShape) and the sprite meshes (SpriteMesh). A hull is its corners in order
+// around it.
+struct HullPoint
+{
+	float x, y;
+};
+
+// Andrew's monotone chain. Points in line with their neighbours are left out.
+std::vector<HullPoint> convexHull(std::vector<HullPoint> points);
+
+// Cuts the hull down to maxPoints by replacing one edge at a time with the point
+// where its neighbouring edges meet. That only ever grows the hull, so it still
+// holds every point; each step takes the edge that grows it least. Returns false if
+// no edge can go, which a convex hull with more than four points never does.
+bool simplifyHull(std::vector<HullPoint>& hull, size_t maxPoints);
+
+// Cuts away whatever is outside the rectangle. Each side can add a point, so a hull
+// can come out with up to four more than it had.
+void clipHull(std::vector<HullPoint>& hull, float minX, float minY, float maxX, float maxY);
+
+float hullArea(const std::vector<HullPoint>& hull);
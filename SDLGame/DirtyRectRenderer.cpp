@@ -0,0 +1,255 @@
+#include "DirtyRectRenderer.h"
+#include <algorithm>
+#include <cmath>
+#include "SoftwareBlitter.h"
+
+namespace
+{
+	// Overlapping or sharing an edge.
+	bool touches(const SDL_Rect& a, const SDL_Rect& b)
+	{
+		return a.x <= b.x + b.w && b.x <= a.x + a.w && a.y <= b.y + b.h && b.y <= a.y + a.h;
+	}
+
+	SDL_Rect unite(const SDL_Rect& a, const SDL_Rect& b)
+	{
+		int x0 = std::min(a.x, b.x), y0 = std::min(a.y, b.y);
+		int x1 = std::max(a.x + a.w, b.x + b.w), y1 = std::max(a.y + a.h, b.y + b.h);
+		return { x0, y0, x1 - x0, y1 - y0 };
+	}
+}
+
+DirtyRectRenderer::DirtyRectRenderer(SpriteAtlas& atlas, SDL_Window* pWindow, int width, int height)
+	: atlas(atlas), pWindow(pWindow), screen{ 0, 0, width, height }
+{
+	SDL_RendererInfo info;
+	if (SDL_GetRendererInfo(atlas.batch().renderer(), &info) == 0)
+		software = (info.flags & SDL_RENDERER_SOFTWARE) != 0;
+}
+
+DirtyRectRenderer::~DirtyRectRenderer()
+{
+	if (pCanvas)
+		SDL_DestroyTexture(pCanvas);
+}
+
+void DirtyRectRenderer::begin()
+{
+	current.clear();
+}
+
+void DirtyRectRenderer::add(const SceneSnapshot& snapshot)
+{
+	for (const SnapshotSprite& item : snapshot.sprites)
+	{
+		Drawn drawn;
+		drawn.sprite = item.sprite;
+		snapshot.place(item, drawn.dst, drawn.angle);
+		drawn.layer = item.layer;
+		drawn.color = item.fallbackColor;
+		drawn.bounds = boundsOf(drawn);
+		current.push_back(drawn);
+	}
+}
+
+bool DirtyRectRenderer::present(SDL_Color background)
+{
+	stats = Stats();
+
+	// A new canvas starts out as garbage, so making one redraws everything.
+	bool kept = software || ensureCanvas();
+	findDirtyRects();
+	previous.swap(current);
+	if (dirty.empty())
+		return false;
+
+	// With nothing keeping the last frame, a change anywhere redraws the lot.
+	if (!kept)
+		dirty.assign(1, screen);
+
+	SDL_Renderer* pRenderer = atlas.batch().renderer();
+	SoftwareBlitter* pBlitter = atlas.batch().blitter();
+	if (pCanvas)
+		SDL_SetRenderTarget(pRenderer, pCanvas);
+	for (const SDL_Rect& rect : dirty)
+		redraw(rect, background);
+	SDL_RenderSetClipRect(pRenderer, nullptr);
+	if (pBlitter)
+		SDL_SetClipRect(pBlitter->target(), nullptr);
+
+	if (pCanvas)
+	{
+		SDL_SetRenderTarget(pRenderer, nullptr);
+		SDL_RenderCopy(pRenderer, pCanvas, nullptr, nullptr);
+		SDL_RenderPresent(pRenderer);
+	}
+	else if (software && pWindow && !everything)
+	{
+		// What SDL_RenderPresent would do, for the dirty rectangles alone.
+#if SDL_VERSION_ATLEAST(2, 0, 10)
+		SDL_RenderFlush(pRenderer);
+#endif
+		SDL_UpdateWindowSurfaceRects(pWindow, dirty.data(), (int)dirty.size());
+	}
+	else
+	{
+		SDL_RenderPresent(pRenderer);
+	}
+
+	everything = false;
+	stats.rects = (int)dirty.size();
+	stats.presented = true;
+	return true;
+}
+
+bool DirtyRectRenderer::sameDraw(const Drawn& a, const Drawn& b)
+{
+	return a.sprite == b.sprite && a.layer == b.layer && a.angle == b.angle
+		&& a.dst.x == b.dst.x && a.dst.y == b.dst.y && a.dst.w == b.dst.w && a.dst.h == b.dst.h
+		&& a.color.r == b.color.r && a.color.g == b.color.g && a.color.b == b.color.b && a.color.a == b.color.a;
+}
+
+SDL_Rect DirtyRectRenderer::boundsOf(const Drawn& drawn) const
+{
+	float minX = drawn.dst.x, minY = drawn.dst.y, maxX = drawn.dst.x + drawn.dst.w, maxY = drawn.dst.y + drawn.dst.h;
+
+	// Plain rectangles are never turned; sprites turn around their pivot.
+	if (drawn.angle != 0.0f && drawn.sprite >= 0)
+	{
+		const SpriteFrame& frame = atlas.frame(drawn.sprite);
+		float pivotX = drawn.dst.x + frame.pivotX * drawn.dst.w, pivotY = drawn.dst.y + frame.pivotY * drawn.dst.h;
+		float radians = drawn.angle * 3.14159265f / 180.0f;
+		float c = std::cos(radians), s = std::sin(radians);
+		minX = minY = INFINITY;
+		maxX = maxY = -INFINITY;
+		for (float x : { drawn.dst.x, drawn.dst.x + drawn.dst.w })
+		{
+			for (float y : { drawn.dst.y, drawn.dst.y + drawn.dst.h })
+			{
+				float dx = x - pivotX, dy = y - pivotY;
+				float turnedX = pivotX + dx * c - dy * s, turnedY = pivotY + dx * s + dy * c;
+				minX = std::min(minX, turnedX);
+				maxX = std::max(maxX, turnedX);
+				minY = std::min(minY, turnedY);
+				maxY = std::max(maxY, turnedY);
+			}
+		}
+	}
+
+	// A pixel more all round for filtering and rounding.
+	SDL_Rect bounds = { (int)std::floor(minX) - 1, (int)std::floor(minY) - 1, 0, 0 };
+	bounds.w = (int)std::ceil(maxX) + 1 - bounds.x;
+	bounds.h = (int)std::ceil(maxY) + 1 - bounds.y;
+	SDL_Rect onScreen;
+	if (!SDL_IntersectRect(&bounds, &screen, &onScreen))
+		return { 0, 0, 0, 0 };
+	return onScreen;
+}
+
+void DirtyRectRenderer::markDirty(const SDL_Rect& rect)
+{
+	if (rect.w <= 0 || rect.h <= 0)
+		return;
+
+	// Merging can make the rectangle reach others it didn't, so look again after each.
+	SDL_Rect merged = rect;
+	for (size_t i = 0; i < dirty.size();)
+	{
+		if (touches(dirty[i], merged))
+		{
+			merged = unite(dirty[i], merged);
+			dirty.erase(dirty.begin() + i);
+			i = 0;
+		}
+		else
+		{
+			i++;
+		}
+	}
+	dirty.push_back(merged);
+
+	if ((int)dirty.size() > maxRects)
+	{
+		SDL_Rect all = dirty[0];
+		for (const SDL_Rect& other : dirty)
+			all = unite(all, other);
+		dirty.assign(1, all);
+	}
+}
+
+void DirtyRectRenderer::findDirtyRects()
+{
+	dirty.clear();
+	std::stable_sort(current.begin(), current.end(), [](const Drawn& a, const Drawn& b) { return a.layer < b.layer; });
+	if (everything)
+	{
+		dirty.push_back(screen);
+		return;
+	}
+
+	// The nth sprite of a layer this frame against the nth of the same layer last frame.
+	size_t i = 0, j = 0;
+	while (i < current.size() || j < previous.size())
+	{
+		if (i < current.size() && j < previous.size() && current[i].layer == previous[j].layer)
+		{
+			if (!sameDraw(current[i], previous[j]))
+			{
+				markDirty(current[i].bounds);
+				markDirty(previous[j].bounds);
+			}
+			i++;
+			j++;
+		}
+		else if (j == previous.size() || (i < current.size() && current[i].layer < previous[j].layer))
+		{
+			markDirty(current[i++].bounds);
+		}
+		else
+		{
+			markDirty(previous[j++].bounds);
+		}
+	}
+}
+
+void DirtyRectRenderer::redraw(const SDL_Rect& rect, SDL_Color background)
+{
+	SpriteBatch& batch = atlas.batch();
+	SDL_Renderer* pRenderer = batch.renderer();
+	SDL_RenderSetClipRect(pRenderer, &rect);
+	if (batch.blitter())
+		SDL_SetClipRect(batch.blitter()->target(), &rect);
+
+	// SDL_RenderClear would ignore the clip rectangle.
+	SDL_SetRenderDrawBlendMode(pRenderer, SDL_BLENDMODE_NONE);
+	SDL_SetRenderDrawColor(pRenderer, background.r, background.g, background.b, background.a);
+	SDL_RenderFillRect(pRenderer, &rect);
+
+	// previous holds this frame's sprites now.
+	for (const Drawn& drawn : previous)
+	{
+		if (!SDL_HasIntersection(&drawn.bounds, &rect))
+			continue;
+		if (drawn.sprite >= 0)
+			atlas.draw(drawn.sprite, drawn.dst, drawn.layer, drawn.angle);
+		else
+			batch.drawRect(drawn.dst, drawn.color, drawn.layer);
+	}
+	batch.flush();
+	stats.pixels += (int64_t)rect.w * rect.h;
+}
+
+bool DirtyRectRenderer::ensureCanvas()
+{
+	if (pCanvas)
+		return true;
+	SDL_Renderer* pRenderer = atlas.batch().renderer();
+	if (!SDL_RenderTargetSupported(pRenderer))
+		return false;
+	pCanvas = SDL_CreateTexture(pRenderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET, screen.w, screen.h);
+	if (pCanvas == nullptr)
+		return false;
+	SDL_SetTextureBlendMode(pCanvas, SDL_BLENDMODE_NONE);
+	everything = true;
+	return true;
+}
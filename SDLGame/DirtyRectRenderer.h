@@ -0,0 +1,83 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <SDL.h>
+#include "SceneSnapshot.h"
+#include "SpriteAtlas.h"
+
+// Draws frames that hardly change, such as menus and the pause screen, by redrawing
+// only what changed since the last frame, and nothing at all when nothing did.
+//
+// Each frame's sprites are compared with the last frame's layer by layer, in the order
+// they were added. A sprite that appeared, went, moved, turned or changed marks where
+// it was and where it is now dirty. Dirty rectangles that touch are merged, and past
+// maxRects they become one around them all. Each one is then filled with the
+// background and the sprites over it are drawn again, clipped to it.
+//
+// That needs the last frame to still be there. The surface of a software renderer
+// keeps it; otherwise frames are drawn into a render target texture, which is copied
+// to the window to present it. A software renderer's window only gets its dirty
+// rectangles updated (SDL_UpdateWindowSurfaceRects).
+class DirtyRectRenderer
+{
+public:
+	static constexpr int maxRects = 8;
+
+	// Draws through atlas onto its batch's renderer, which covers width x height pixels.
+	// pWindow is the renderer's window, or null if it draws into a surface.
+	DirtyRectRenderer(SpriteAtlas& atlas, SDL_Window* pWindow, int width, int height);
+	~DirtyRectRenderer();
+
+	DirtyRectRenderer(const DirtyRectRenderer&) = delete;
+	DirtyRectRenderer& operator=(const DirtyRectRenderer&) = delete;
+
+	// Starts a frame, then add() its snapshots in drawing order.
+	void begin();
+	void add(const SceneSnapshot& snapshot);
+
+	// Redraws what changed since the last frame over background and presents it.
+	// Returns false, having done neither, if nothing changed.
+	bool present(SDL_Color background = { 0, 0, 0, 255 });
+
+	// Redraws everything next frame: the window was exposed or lost its render
+	// targets, something else drew on it, or a sprite's pixels were reloaded.
+	void invalidate() { everything = true; }
+
+	// Counters for the last present().
+	struct Stats
+	{
+		int rects = 0;       // dirty rectangles redrawn
+		int64_t pixels = 0;  // pixels in them
+		bool presented = false;
+	};
+	const Stats& lastStats() const { return stats; }
+
+private:
+	struct Drawn
+	{
+		int sprite; // -1 for a plain rectangle
+		SDL_FRect dst;
+		float angle;
+		uint8_t layer;
+		SDL_Color color;
+		SDL_Rect bounds; // the pixels it can touch
+	};
+
+	static bool sameDraw(const Drawn& a, const Drawn& b);
+	SDL_Rect boundsOf(const Drawn& drawn) const;
+	void markDirty(const SDL_Rect& rect);
+	void findDirtyRects();
+	void redraw(const SDL_Rect& rect, SDL_Color background);
+	bool ensureCanvas();
+
+	SpriteAtlas& atlas;
+	SDL_Window* pWindow;
+	SDL_Rect screen;
+	SDL_Texture* pCanvas = nullptr;
+	bool software = false;
+	bool everything = true;
+	std::vector<Drawn> current;
+	std::vector<Drawn> previous;
+	std::vector<SDL_Rect> dirty;
+	Stats stats;
+};
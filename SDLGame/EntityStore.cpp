@@ -0,0 +1,116 @@
+#include "EntityStore.h"
+#include "Hash.h"
+
+EntityHandle EntityStore::create()
+{
+	uint32_t slot;
+	if (!freeSlots.empty())
+	{
+		slot = freeSlots.back();
+		freeSlots.pop_back();
+	}
+	else
+	{
+		slot = (uint32_t)slots.size();
+		slots.push_back({ 0, 1 });
+	}
+
+	slots[slot].dense = (uint32_t)owners.size();
+	owners.push_back(slot);
+	forEachField(*this, [](auto& field) { field.emplace_back(); });
+	return { slot, slots[slot].generation };
+}
+
+bool EntityStore::destroy(EntityHandle handle)
+{
+	int index = indexOf(handle);
+	if (index < 0)
+		return false;
+	destroyAt((size_t)index);
+	return true;
+}
+
+void EntityStore::destroyAt(size_t index)
+{
+	size_t last = owners.size() - 1;
+	uint32_t slot = owners[index];
+	if (index != last)
+	{
+		forEachField(*this, [index, last](auto& field) { field[index] = field[last]; });
+		owners[index] = owners[last];
+		slots[owners[index]].dense = (uint32_t)index;
+	}
+	forEachField(*this, [](auto& field) { field.pop_back(); });
+	owners.pop_back();
+
+	// Bumping the generation is what makes old handles to this slot stop resolving.
+	slots[slot].generation = slots[slot].generation + 1 != 0 ? slots[slot].generation + 1 : 1;
+	freeSlots.push_back(slot);
+}
+
+int EntityStore::indexOf(EntityHandle handle) const
+{
+	if (handle.index >= slots.size())
+		return -1;
+	const Slot& slot = slots[handle.index];
+	if (slot.generation != handle.generation || slot.dense >= owners.size() || owners[slot.dense] != handle.index)
+		return -1;
+	return (int)slot.dense;
+}
+
+EntityHandle EntityStore::handleAt(size_t index) const
+{
+	uint32_t slot = owners[index];
+	return { slot, slots[slot].generation };
+}
+
+void EntityStore::reserve(size_t count)
+{
+	slots.reserve(count);
+	freeSlots.reserve(count);
+	owners.reserve(count);
+	forEachField(*this, [count](auto& field) { field.reserve(count); });
+}
+
+void EntityStore::clear()
+{
+	while (!owners.empty())
+		destroyAt(owners.size() - 1);
+}
+
+void EntityStore::integrate(Real tickSeconds)
+{
+	// One field pair per loop keeps each loop trivially vectorisable.
+	size_t count = size();
+	Real* pX = x.data();
+	Real* pY = y.data();
+	Real* pAngle = angle.data();
+	Real* pPrevAngle = prevAngle.data();
+	const Real* pVx = vx.data();
+	const Real* pVy = vy.data();
+	const Real* pSpin = spin.data();
+
+	prevX = x;
+	prevY = y;
+	prevAngle = angle;
+	for (size_t i = 0; i < count; i++)
+		pX[i] += pVx[i] * tickSeconds;
+	for (size_t i = 0; i < count; i++)
+		pY[i] += pVy[i] * tickSeconds;
+
+	// Unbounded angles would overflow in fixed point and lose precision as floats.
+	const Real turn = Real(360);
+	for (size_t i = 0; i < count; i++)
+	{
+		Real next = pAngle[i] + pSpin[i] * tickSeconds;
+		Real wrap = next < Real(0) ? turn : next >= turn ? -turn : Real(0);
+		pAngle[i] = next + wrap;
+		pPrevAngle[i] += wrap;
+	}
+}
+
+uint64_t EntityStore::checksum(uint64_t hash) const
+{
+	forEachField(*this, [&hash](const auto& field) { hash = fnv1a64Words(field.data(), field.size() * sizeof(field[0]), hash); });
+	return hash;
+}
@@ -0,0 +1,95 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Real.h"
+
+// Refers to one entity in an EntityStore. Stays valid while the entity lives, however
+// often the store shuffles its arrays; once the entity is destroyed the handle stops
+// resolving, even if its slot is reused.
+struct EntityHandle
+{
+	uint32_t index = 0;
+	uint32_t generation = 0; // 0 = no entity
+
+	bool isValid() const { return generation != 0; }
+};
+
+// Structure-of-arrays storage for one kind of object (meteors, lasers, enemies...).
+// Every field lives in its own contiguous array and live entities always occupy
+// [0, size()), so a loop that only needs positions streams through positions and
+// nothing else, and simple loops vectorise. Destroying an entity moves the last one
+// into its place: dense indices change, handles don't.
+//
+// The field arrays are public so update loops can run over them directly. Read and
+// write their elements, but never resize them yourself; create() and destroy() keep
+// them all the same length.
+class EntityStore
+{
+public:
+	// Adds an entity with every field zeroed and returns its handle. Its dense index is size() - 1.
+	EntityHandle create();
+
+	// Returns false if the handle no longer refers to a live entity.
+	bool destroy(EntityHandle handle);
+
+	// Destroys the entity at a dense index, for use inside update loops. The last entity
+	// moves into index, so process index again instead of moving on.
+	void destroyAt(size_t index);
+
+	bool isAlive(EntityHandle handle) const { return indexOf(handle) >= 0; }
+
+	// Dense index of a live entity, or -1.
+	int indexOf(EntityHandle handle) const;
+
+	EntityHandle handleAt(size_t index) const;
+
+	size_t size() const { return owners.size(); }
+
+	// Makes room for count entities: until there are more, create() and destroy() never allocate.
+	void reserve(size_t count);
+
+	// Destroys everything. Outstanding handles stop resolving.
+	void clear();
+
+	// Copies position and angle into prev*, then moves every entity by one tick.
+	// Angles are kept within [0, 360), prevAngle moving with them.
+	void integrate(Real tickSeconds);
+
+	// Hash of every field of every entity, to check that two runs are in the same state.
+	uint64_t checksum(uint64_t hash) const;
+
+	std::vector<Real> x, y;           // top-left corner, pixels
+	std::vector<Real> prevX, prevY;   // position at the previous tick, for interpolation
+	std::vector<Real> vx, vy;         // pixels per second
+	std::vector<Real> w, h;           // size, pixels
+	std::vector<Real> angle, prevAngle; // degrees
+	std::vector<Real> spin;           // degrees per second
+	std::vector<Real> life;           // seconds left, for things that expire
+	std::vector<int32_t> sprite;
+
+private:
+	// Store is EntityStore or const EntityStore.
+	template <typename Store, typename Function>
+	static void forEachField(Store& store, Function function)
+	{
+		function(store.x); function(store.y);
+		function(store.prevX); function(store.prevY);
+		function(store.vx); function(store.vy);
+		function(store.w); function(store.h);
+		function(store.angle); function(store.prevAngle);
+		function(store.spin);
+		function(store.life);
+		function(store.sprite);
+	}
+
+	struct Slot
+	{
+		uint32_t dense;
+		uint32_t generation;
+	};
+
+	std::vector<Slot> slots;          // handle index -> dense index
+	std::vector<uint32_t> owners;     // dense index -> handle index
+	std::vector<uint32_t> freeSlots;
+};
@@ -0,0 +1,162 @@
+#include "FileWatcher.h"
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+
+#if defined(__linux__)
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+FileWatcher::~FileWatcher()
+{
+	stop();
+}
+
+bool FileWatcher::start(const std::string& root)
+{
+	stop();
+	std::error_code error;
+	if (!fs::is_directory(root, error))
+		return false;
+	rootDir = root;
+	while (!rootDir.empty() && (rootDir.back() == '/' || rootDir.back() == '\\'))
+		rootDir.pop_back();
+
+#if defined(__linux__)
+	notifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (notifyFd < 0)
+		return false;
+	watchTree("");
+	if (watchedDirs.empty())
+	{
+		close(notifyFd);
+		notifyFd = -1;
+		return false;
+	}
+#endif
+
+	stopping = false;
+	worker = std::thread(&FileWatcher::run, this);
+	return true;
+}
+
+void FileWatcher::stop()
+{
+	if (!worker.joinable())
+		return;
+	stopping = true;
+	worker.join();
+#if defined(__linux__)
+	close(notifyFd);
+	notifyFd = -1;
+	watchedDirs.clear();
+#endif
+}
+
+std::vector<std::string> FileWatcher::takeChanges()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	std::vector<std::string> taken;
+	taken.swap(changes);
+	return taken;
+}
+
+void FileWatcher::addChange(const std::string& path)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	if (std::find(changes.begin(), changes.end(), path) == changes.end())
+		changes.push_back(path);
+}
+
+#if defined(__linux__)
+
+void FileWatcher::watchTree(const std::string& relative)
+{
+	std::string dir = relative.empty() ? rootDir : rootDir + "/" + relative;
+	int watch = inotify_add_watch(notifyFd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_ONLYDIR);
+	if (watch < 0)
+		return;
+	watchedDirs[watch] = relative;
+
+	std::error_code error;
+	for (const fs::directory_entry& entry : fs::directory_iterator(dir, error))
+	{
+		if (entry.is_directory(error))
+			watchTree(relative.empty() ? entry.path().filename().string() : relative + "/" + entry.path().filename().string());
+	}
+}
+
+void FileWatcher::run()
+{
+	// Big enough for many events at once; inotify_event has to be suitably aligned.
+	alignas(inotify_event) char buffer[16 * 1024];
+	while (!stopping)
+	{
+		// Wake up now and then to notice stop().
+		pollfd waitFor = { notifyFd, POLLIN, 0 };
+		if (poll(&waitFor, 1, 100) <= 0)
+			continue;
+
+		ssize_t length = read(notifyFd, buffer, sizeof(buffer));
+		for (ssize_t offset = 0; offset < length;)
+		{
+			const inotify_event* pEvent = (const inotify_event*)(buffer + offset);
+			offset += sizeof(inotify_event) + pEvent->len;
+
+			auto dir = watchedDirs.find(pEvent->wd);
+			if (dir == watchedDirs.end() || pEvent->len == 0)
+				continue;
+			std::string path = dir->second.empty() ? pEvent->name : dir->second + "/" + pEvent->name;
+
+			if (pEvent->mask & IN_ISDIR)
+			{
+				if (pEvent->mask & (IN_CREATE | IN_MOVED_TO))
+					watchTree(path);
+			}
+			else if (pEvent->mask & (IN_CLOSE_WRITE | IN_MOVED_TO))
+			{
+				// Covers both saving in place and the write-then-rename most editors do.
+				addChange(path);
+			}
+		}
+	}
+}
+
+#else
+
+void FileWatcher::run()
+{
+	auto scan = [this]()
+	{
+		std::unordered_map<std::string, fs::file_time_type> times;
+		std::error_code error;
+		for (fs::recursive_directory_iterator it(rootDir, error), end; !error && it != end; it.increment(error))
+		{
+			if (it->is_regular_file(error))
+				times[fs::relative(it->path(), rootDir, error).generic_string()] = it->last_write_time(error);
+		}
+		return times;
+	};
+
+	std::unordered_map<std::string, fs::file_time_type> known = scan();
+	while (!stopping)
+	{
+		for (int i = 0; i < 10 && !stopping; i++)
+			std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+		std::unordered_map<std::string, fs::file_time_type> current = scan();
+		for (const auto& file : current)
+		{
+			auto previous = known.find(file.first);
+			if (previous == known.end() || previous->second != file.second)
+				addChange(file.first);
+		}
+		known.swap(current);
+	}
+}
+
+#endif
@@ -0,0 +1,47 @@
+#pragma once
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Reports files that were written under a directory tree, from a background thread.
+// On Linux this uses inotify, so changes arrive as soon as the file is closed; elsewhere
+// it compares modification times twice a second. Either way the game only sees the
+// result through takeChanges(), once per frame.
+class FileWatcher
+{
+public:
+	FileWatcher() = default;
+	~FileWatcher();
+
+	FileWatcher(const FileWatcher&) = delete;
+	FileWatcher& operator=(const FileWatcher&) = delete;
+
+	// Starts watching root and everything under it. Returns false if it can't.
+	bool start(const std::string& root);
+	void stop();
+	bool isWatching() const { return worker.joinable(); }
+
+	// Files written since the last call, relative to root with '/' separators, each listed once.
+	// A save that touches a file several times in a row shows up as one change.
+	std::vector<std::string> takeChanges();
+
+private:
+	void run();
+	void addChange(const std::string& path);
+#if defined(__linux__)
+	void watchTree(const std::string& relative);
+#endif
+
+	std::string rootDir;
+	std::thread worker;
+	std::atomic<bool> stopping{ false };
+	std::mutex mutex;
+	std::vector<std::string> changes;
+#if defined(__linux__)
+	int notifyFd = -1;
+	std::unordered_map<int, std::string> watchedDirs; // inotify watch -> directory relative to root
+#endif
+};
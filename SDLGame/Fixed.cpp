@@ -0,0 +1,85 @@
+#include "Fixed.h"
+
+namespace
+{
+	const int quarterBits = 10;
+	const int quarterSteps = 1 << quarterBits; // table steps per quarter turn
+	const int64_t turn = 360ll * Fixed::one;
+
+	// sin() of every step across a quarter turn, in Fixed's raw units. Worked out from
+	// the Taylor series with 30 fraction bits in 64-bit integers, not with the C
+	// library's sin(), so the table is the same wherever it's built.
+	struct SineTable
+	{
+		int32_t values[quarterSteps + 1];
+
+		SineTable()
+		{
+			const int64_t unit = 1ll << 30;
+			const int64_t halfPi = 1686629713; // pi / 2 * 2^30
+			for (int i = 0; i <= quarterSteps; i++)
+			{
+				int64_t x = halfPi * i / quarterSteps;
+				int64_t xSquared = (x * x) >> 30;
+				int64_t term = x, sum = x;
+				for (int n = 2; n < 20; n += 2)
+				{
+					term = -((term * xSquared) >> 30) / (n * (n + 1));
+					sum += term;
+				}
+				values[i] = (int32_t)((sum + (unit >> 17)) >> 14);
+			}
+		}
+	};
+
+	const SineTable& sineTable()
+	{
+		static const SineTable table;
+		return table;
+	}
+}
+
+Fixed sinDegrees(Fixed degrees)
+{
+	// Where in the turn, as quarter turns, table steps and 16 bits between steps.
+	const int64_t stepsPerTurn = 4 * quarterSteps;
+	int64_t inTurn = ((int64_t)degrees.raw % turn + turn) % turn;
+	int64_t position = (inTurn * (stepsPerTurn << 16) + turn / 2) / turn;
+	int quarter = (int)(position >> (quarterBits + 16)) & 3;
+	int64_t step = position & (((int64_t)quarterSteps << 16) - 1);
+
+	// The second and fourth quarters run the table backwards; the last two are negative.
+	if (quarter % 2 == 1)
+		step = ((int64_t)quarterSteps << 16) - step;
+	const int32_t* pValues = sineTable().values;
+	int index = (int)(step >> 16), fraction = (int)(step & 0xFFFF);
+	int32_t value = pValues[index];
+	if (fraction != 0)
+		value += (int32_t)(((int64_t)(pValues[index + 1] - value) * fraction + 0x8000) >> 16);
+	return Fixed::fromRaw(quarter >= 2 ? -value : value);
+}
+
+Fixed cosDegrees(Fixed degrees)
+{
+	return sinDegrees(degrees + Fixed(90));
+}
+
+Fixed length(Fixed x, Fixed y)
+{
+	// Integer square root of the sum of squares, a bit at a time; the result is in raw units.
+	uint64_t square = (uint64_t)((int64_t)x.raw * x.raw) + (uint64_t)((int64_t)y.raw * y.raw);
+	uint64_t root = 0;
+	for (uint64_t bit = 1ull << 62; bit != 0; bit >>= 2)
+	{
+		if (square >= root + bit)
+		{
+			square -= root + bit;
+			root = (root >> 1) + bit;
+		}
+		else
+		{
+			root >>= 1;
+		}
+	}
+	return Fixed::fromRaw((int32_t)root);
+}
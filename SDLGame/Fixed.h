@@ -0,0 +1,73 @@
+#pragma once
+#include <cstdint>
+
+// A number with 16 integer and 16 fraction bits in an int32_t: about +-32767 in steps
+// of 1/65536. Everything it does is integer arithmetic, so the same inputs give the
+// same bits with any compiler, optimisation level and CPU. Floats don't promise that:
+// compilers may fuse a multiply and an add, and every C library has its own sin().
+//
+// The simulation runs on it instead of float when SDLGAME_FIXED_POINT is defined (see
+// Real.h). Nothing checks for overflow, so keep values well inside the range: angles
+// are wrapped to a turn and lengths go through length(), which works in 64 bits.
+struct Fixed
+{
+	static constexpr int fractionBits = 16;
+	static constexpr int32_t one = 1 << fractionBits;
+
+	int32_t raw = 0;
+
+	constexpr Fixed() = default;
+	constexpr explicit Fixed(int value) : raw(value * one) {}
+	// Rounds to the nearest step. Only as deterministic as value: fine for constants and
+	// settings, but not for the result of float arithmetic the simulation depends on.
+	constexpr explicit Fixed(double value) : raw((int32_t)(value * one + (value < 0.0 ? -0.5 : 0.5))) {}
+
+	static constexpr Fixed fromRaw(int32_t raw)
+	{
+		Fixed result;
+		result.raw = raw;
+		return result;
+	}
+
+	// The nearest float: the same float everywhere, for drawing and the float collision code.
+	float toFloat() const { return (float)raw * (1.0f / one); }
+
+	// Largest integer not above the value.
+	int floor() const { return raw >> fractionBits; }
+
+	constexpr Fixed operator-() const { return fromRaw(-raw); }
+	Fixed& operator+=(Fixed other);
+	Fixed& operator-=(Fixed other);
+	Fixed& operator*=(Fixed other);
+	Fixed& operator/=(Fixed other);
+};
+
+// Products and quotients round toward negative infinity and toward zero, like the shift
+// and the integer division they are.
+inline Fixed operator+(Fixed a, Fixed b) { return Fixed::fromRaw(a.raw + b.raw); }
+inline Fixed operator-(Fixed a, Fixed b) { return Fixed::fromRaw(a.raw - b.raw); }
+inline Fixed operator*(Fixed a, Fixed b) { return Fixed::fromRaw((int32_t)(((int64_t)a.raw * b.raw) >> Fixed::fractionBits)); }
+inline Fixed operator/(Fixed a, Fixed b) { return Fixed::fromRaw((int32_t)((int64_t)a.raw * Fixed::one / b.raw)); }
+inline Fixed operator*(Fixed a, int b) { return Fixed::fromRaw(a.raw * b); }
+inline Fixed operator*(int a, Fixed b) { return Fixed::fromRaw(a * b.raw); }
+inline Fixed operator/(Fixed a, int b) { return Fixed::fromRaw(a.raw / b); }
+
+inline Fixed& Fixed::operator+=(Fixed other) { return *this = *this + other; }
+inline Fixed& Fixed::operator-=(Fixed other) { return *this = *this - other; }
+inline Fixed& Fixed::operator*=(Fixed other) { return *this = *this * other; }
+inline Fixed& Fixed::operator/=(Fixed other) { return *this = *this / other; }
+
+inline bool operator==(Fixed a, Fixed b) { return a.raw == b.raw; }
+inline bool operator!=(Fixed a, Fixed b) { return a.raw != b.raw; }
+inline bool operator<(Fixed a, Fixed b) { return a.raw < b.raw; }
+inline bool operator>(Fixed a, Fixed b) { return a.raw > b.raw; }
+inline bool operator<=(Fixed a, Fixed b) { return a.raw <= b.raw; }
+inline bool operator>=(Fixed a, Fixed b) { return a.raw >= b.raw; }
+
+// Sine and cosine of an angle in degrees, any number of turns, from a table built with
+// integer arithmetic the first time either is called. Within a step (1/65536) or so.
+Fixed sinDegrees(Fixed degrees);
+Fixed cosDegrees(Fixed degrees);
+
+// sqrt(x * x + y * y), rounded down, without the squares overflowing.
+Fixed length(Fixed x, Fixed y);
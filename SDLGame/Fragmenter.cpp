@@ -0,0 +1,84 @@
+#include "Fragmenter.h"
+#include <algorithm>
+#include "EntityStore.h"
+
+Fragmenter::Fragmenter(std::vector<MeteorKind> kinds, uint32_t seed) : kinds(std::move(kinds)), rng(seed)
+{
+}
+
+void Fragmenter::reserve(EntityStore& meteors, size_t capacity)
+{
+	meteors.reserve(capacity);
+	pending.reserve(capacity);
+	limit = capacity;
+}
+
+void Fragmenter::queue(uint32_t meteor, Real pushX, Real pushY)
+{
+	// Only reached by queuing the same meteors over and over; those are dropped in apply() anyway.
+	if (pending.size() == limit)
+		return;
+	pending.push_back({ meteor, (uint32_t)pending.size(), pushX, pushY });
+}
+
+size_t Fragmenter::apply(EntityStore& meteors)
+{
+	// Highest index first: destroying a meteor only moves the last one, which is either
+	// a piece or a meteor already broken. Ties go by queue order, so a meteor queued twice
+	// breaks by the knock queued first whatever the standard library's sort does.
+	std::sort(pending.begin(), pending.end(), [](const Break& a, const Break& b) { return a.meteor != b.meteor ? a.meteor > b.meteor : a.order < b.order; });
+
+	size_t created = 0;
+	size_t previous = SIZE_MAX;
+	for (const Break& hit : pending)
+	{
+		size_t i = hit.meteor;
+		if (i == previous || i >= meteors.size())
+			continue;
+		previous = i;
+
+		// The pieces need the meteor's state after its slot has been reused.
+		int32_t kind = meteors.sprite[i];
+		Real centerX = meteors.x[i] + meteors.w[i] / 2, centerY = meteors.y[i] + meteors.h[i] / 2;
+		Real vx = meteors.vx[i] + hit.pushX, vy = meteors.vy[i] + hit.pushY;
+		Real angle = meteors.angle[i], parentSpin = meteors.spin[i], life = meteors.life[i];
+		Real reach = std::min(meteors.w[i], meteors.h[i]) / 4;
+		meteors.destroyAt(i);
+
+		if (kind < 0 || kind >= (int32_t)kinds.size())
+			continue;
+		const MeteorKind& parent = kinds[kind];
+		if (parent.pieces <= 0 || parent.pieceKind < 0 || parent.pieceKind >= (int32_t)kinds.size())
+			continue;
+		const MeteorKind& piece = kinds[parent.pieceKind];
+
+		// Evenly spaced directions from a random start, so the pushes apart sum to zero.
+		Real start = randomReal(rng, Real(0), Real(360));
+		for (int k = 0; k < parent.pieces; k++)
+		{
+			if (meteors.size() >= limit)
+			{
+				dropped += parent.pieces - k;
+				break;
+			}
+			Real direction = start + Real(360) * k / parent.pieces;
+			Real dirX = cosDegrees(direction), dirY = sinDegrees(direction);
+
+			meteors.create();
+			size_t j = meteors.size() - 1;
+			meteors.sprite[j] = parent.pieceKind;
+			meteors.w[j] = piece.w;
+			meteors.h[j] = piece.h;
+			meteors.x[j] = meteors.prevX[j] = centerX + dirX * reach - piece.w / 2;
+			meteors.y[j] = meteors.prevY[j] = centerY + dirY * reach - piece.h / 2;
+			meteors.vx[j] = vx + dirX * parent.scatter;
+			meteors.vy[j] = vy + dirY * parent.scatter;
+			meteors.angle[j] = meteors.prevAngle[j] = angle;
+			meteors.spin[j] = parentSpin + randomReal(rng, Real(-90), Real(90));
+			meteors.life[j] = life;
+			created++;
+		}
+	}
+	pending.clear();
+	return created;
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+#include "Real.h"
+
+class EntityStore;
+
+// One kind of meteor, by its index in the store's sprite field, and what it breaks into.
+struct MeteorKind
+{
+	Real w = Real(0), h = Real(0); // size, pixels
+	int pieces = 0;           // how many pieces it breaks into; 0 means it is just destroyed
+	int32_t pieceKind = -1;   // the kind of each piece
+	Real scatter = Real(60);  // pixels per second the pieces fly apart at
+};
+
+// Breaks meteors into smaller ones: big into medium, medium into small, small into tiny.
+//
+// Pieces keep the meteor's velocity and spin, take the knock from whatever hit it, and
+// fly apart evenly around the centre. The pushes apart cancel out, so together the
+// pieces carry on as the meteor would have.
+//
+// Pieces are created in the meteors' own EntityStore, which reserve() sizes up front
+// along with the queue of meteors to break. After that breaking never allocates, however
+// many meteors break in one tick; pieces that don't fit are dropped instead.
+class Fragmenter
+{
+public:
+	Fragmenter() = default;
+	Fragmenter(std::vector<MeteorKind> kinds, uint32_t seed);
+
+	// Makes room for capacity meteors in meteors, and for all of them breaking in one tick.
+	void reserve(EntityStore& meteors, size_t capacity);
+
+	// Queues the meteor at dense index meteor to break in the next apply(), knocked by
+	// (pushX, pushY) pixels per second. Queued twice, it still breaks once, by the knock queued first.
+	void queue(uint32_t meteor, Real pushX, Real pushY);
+
+	// Replaces every queued meteor with its pieces and returns how many pieces were
+	// created. Dense indices change, as with EntityStore::destroyAt.
+	size_t apply(EntityStore& meteors);
+
+	size_t capacity() const { return limit; }
+
+	// Pieces dropped because the store was full, since construction.
+	size_t droppedCount() const { return dropped; }
+
+private:
+	struct Break
+	{
+		uint32_t meteor;
+		uint32_t order; // place in the queue
+		Real pushX, pushY;
+	};
+
+	std::vector<MeteorKind> kinds;
+	std::vector<Break> pending;
+	size_t limit = 0;
+	size_t dropped = 0;
+	std::mt19937 rng;
+};
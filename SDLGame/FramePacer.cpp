@@ -0,0 +1,155 @@
+#include "FramePacer.h"
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SDLGAME_SPIN_PAUSE() _mm_pause()
+#else
+#define SDLGAME_SPIN_PAUSE() ((void)0)
+#endif
+
+namespace
+{
+	const double minSpinMargin = 0.00025; // never trust SDL_Delay closer than this to a deadline
+	const double maxSpinMargin = 0.004;   // never spin longer than this
+	const double errorBinMicroseconds = 50.0;
+	const int errorBinCount = 80;         // 0..4 ms, later frames land in the overflow bin
+}
+
+const char* pacingModeName(PacingMode mode)
+{
+	switch (mode)
+	{
+	case PacingMode::Vsync: return "vsync";
+	case PacingMode::Capped: return "capped";
+	case PacingMode::Uncapped: return "uncapped";
+	}
+	return "?";
+}
+
+FramePacer::FramePacer(double targetFps)
+	: spinMargin(0.001), countsPerSecond((double)SDL_GetPerformanceFrequency()), errors(errorBinMicroseconds, errorBinCount)
+{
+	setTargetFps(targetFps);
+	periodSeconds = capPeriodSeconds;
+}
+
+void FramePacer::setTargetFps(double fps)
+{
+	capPeriodSeconds = 1.0 / (fps > 0.0 ? fps : 60.0);
+	if (currentMode == PacingMode::Capped)
+	{
+		periodSeconds = capPeriodSeconds;
+		restartDeadline();
+	}
+}
+
+void FramePacer::setMode(PacingMode newMode, SDL_Renderer* pRenderer, SDL_Window* pWindow)
+{
+	bool wantVsync = newMode == PacingMode::Vsync;
+
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+	bool vsyncFailed = pRenderer == nullptr || SDL_RenderSetVSync(pRenderer, wantVsync ? 1 : 0) != 0;
+	vsyncEmulated = wantVsync && vsyncFailed;
+#else
+	(void)pRenderer;
+	vsyncEmulated = wantVsync;
+#endif
+
+	periodSeconds = capPeriodSeconds;
+	if (vsyncEmulated)
+	{
+		int displayIndex = pWindow ? SDL_GetWindowDisplayIndex(pWindow) : 0;
+		SDL_DisplayMode displayMode;
+		if (SDL_GetCurrentDisplayMode(displayIndex >= 0 ? displayIndex : 0, &displayMode) == 0 && displayMode.refresh_rate > 0)
+			periodSeconds = 1.0 / displayMode.refresh_rate;
+	}
+
+	currentMode = newMode;
+	restartDeadline();
+	errors.clear();
+}
+
+void FramePacer::cycleMode(SDL_Renderer* pRenderer, SDL_Window* pWindow)
+{
+	switch (currentMode)
+	{
+	case PacingMode::Vsync: setMode(PacingMode::Capped, pRenderer, pWindow); break;
+	case PacingMode::Capped: setMode(PacingMode::Uncapped, pRenderer, pWindow); break;
+	case PacingMode::Uncapped: setMode(PacingMode::Vsync, pRenderer, pWindow); break;
+	}
+}
+
+void FramePacer::restartDeadline()
+{
+	deadline = 0;
+	lastFrameStart = 0;
+}
+
+void FramePacer::waitForNextFrame()
+{
+	Uint64 now = SDL_GetPerformanceCounter();
+
+	if (currentMode == PacingMode::Uncapped)
+	{
+		lastFrameStart = now;
+		return;
+	}
+
+	if (currentMode == PacingMode::Vsync && !vsyncEmulated)
+	{
+		// SDL_RenderPresent already waited; all we can do is measure.
+		if (lastFrameStart != 0)
+			errors.add(((now - lastFrameStart) / countsPerSecond - periodSeconds) * 1e6);
+		lastFrameStart = now;
+		return;
+	}
+
+	Uint64 periodCounts = (Uint64)(periodSeconds * countsPerSecond);
+	if (deadline == 0)
+		deadline = now;
+	deadline += periodCounts;
+
+	if (now >= deadline)
+	{
+		// Already late. If we fell more than a whole frame behind, start counting from
+		// now instead of rushing out several frames back to back.
+		errors.add((now - deadline) / countsPerSecond * 1e6);
+		if (now - deadline > periodCounts)
+			deadline = now;
+		lastFrameStart = now;
+		return;
+	}
+
+	waitUntil(deadline);
+	lastFrameStart = SDL_GetPerformanceCounter();
+	errors.add((lastFrameStart - deadline) / countsPerSecond * 1e6);
+}
+
+void FramePacer::waitUntil(Uint64 target)
+{
+	// Coarse part: sleep in whole milliseconds while we're comfortably early.
+	for (;;)
+	{
+		Uint64 now = SDL_GetPerformanceCounter();
+		if (now >= target)
+			return;
+
+		double remaining = (target - now) / countsPerSecond;
+		Uint32 sleepMs = (Uint32)((remaining - spinMargin) * 1000.0);
+		if (remaining <= spinMargin || sleepMs == 0)
+			break;
+
+		SDL_Delay(sleepMs);
+
+		// Learn how much SDL_Delay oversleeps: jump up to the worst overshoot we see,
+		// then relax slowly so one bad sleep doesn't make us spin forever.
+		double overshoot = (SDL_GetPerformanceCounter() - now) / countsPerSecond - sleepMs / 1000.0;
+		spinMargin = std::max(overshoot * 1.25, spinMargin * 0.98);
+		spinMargin = std::min(std::max(spinMargin, minSpinMargin), maxSpinMargin);
+	}
+
+	// Fine part: spin for the last stretch.
+	while (SDL_GetPerformanceCounter() < target)
+		SDLGAME_SPIN_PAUSE();
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include <SDL.h>
+#include "BenchStats.h"
+
+enum class PacingMode
+{
+	Vsync,    // let SDL_RenderPresent wait for the display
+	Capped,   // we wait ourselves until the next frame is due
+	Uncapped, // never wait
+};
+
+const char* pacingModeName(PacingMode mode);
+
+// Keeps frames to a target rate without burning a core.
+// Waiting is done in two parts: a coarse SDL_Delay while there is plenty of
+// time left, then a spin on SDL_GetPerformanceCounter for the last stretch.
+// How early to stop sleeping is learned from how much SDL_Delay actually
+// oversleeps on this machine, so a loaded machine spins a bit longer instead of
+// missing the deadline.
+class FramePacer
+{
+public:
+	FramePacer(double targetFps = 60.0);
+
+	// Frame rate used in Capped mode.
+	void setTargetFps(double fps);
+	double targetFps() const { return 1.0 / capPeriodSeconds; }
+
+	// Switches mode at runtime. Vsync needs SDL_RenderSetVSync (SDL 2.0.18+). On older SDL,
+	// or if the renderer refuses, Vsync falls back to Capped at the display's refresh rate.
+	void setMode(PacingMode newMode, SDL_Renderer* pRenderer, SDL_Window* pWindow);
+	void cycleMode(SDL_Renderer* pRenderer, SDL_Window* pWindow);
+	PacingMode mode() const { return currentMode; }
+
+	// Call once per frame, right after SDL_RenderPresent. Returns when the next frame should start.
+	void waitForNextFrame();
+
+	// How late each frame started compared to when it was due, in microseconds.
+	// In Vsync mode this is the frame interval minus the display period.
+	const Histogram& errorHistogram() const { return errors; }
+	void resetStats() { errors.clear(); }
+
+	// Current spin margin: how long before the deadline we stop sleeping.
+	double spinMarginSeconds() const { return spinMargin; }
+
+private:
+	void waitUntil(Uint64 target);
+	void restartDeadline();
+
+	PacingMode currentMode = PacingMode::Uncapped;
+	bool vsyncEmulated = false; // Vsync was requested but we are capping at the refresh rate instead
+	double periodSeconds;    // period we are pacing to right now
+	double capPeriodSeconds; // period asked for with setTargetFps
+	double spinMargin;
+	double countsPerSecond;
+	Uint64 deadline = 0;
+	Uint64 lastFrameStart = 0;
+	Histogram errors;
+};
@@ -0,0 +1,31 @@
+#include "GameLoop.h"
+#include <cmath>
+
+FixedTimestep::FixedTimestep(double tickRate, int maxTicksPerFrame)
+	: tickLength(1.0 / tickRate), maxTicks(maxTicksPerFrame > 0 ? maxTicksPerFrame : 1)
+{
+}
+
+int FixedTimestep::advance(double elapsedSeconds)
+{
+	if (elapsedSeconds > 0.0)
+		accumulator += elapsedSeconds;
+
+	// Owe at most maxTicks whole ticks. Keep the fraction of a tick so alpha() stays smooth.
+	double limit = maxTicks * tickLength;
+	if (accumulator >= limit + tickLength)
+	{
+		double keep = limit + std::fmod(accumulator, tickLength);
+		dropped += accumulator - keep;
+		accumulator = keep;
+	}
+
+	int owed = 0;
+	while (accumulator >= tickLength)
+	{
+		accumulator -= tickLength;
+		owed++;
+	}
+	ticks += owed;
+	return owed;
+}
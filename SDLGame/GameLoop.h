@@ -0,0 +1,39 @@
+#pragma once
+#include <cstdint>
+
+// Fixed-timestep accumulator.
+// Each frame, feed it the real time that passed and run the simulation tick
+// as many times as advance() says. Rendering then blends the last two
+// simulation states using alpha(), so the simulation costs the same no matter
+// how fast the display refreshes.
+class FixedTimestep
+{
+public:
+	// tickRate: simulation ticks per second.
+	// maxTicksPerFrame: catch-up limit. If a frame took so long that more ticks
+	// than this are owed, the extra time is dropped instead of simulated, so a
+	// slow frame can't cause an even slower one (the "spiral of death").
+	FixedTimestep(double tickRate = 120.0, int maxTicksPerFrame = 8);
+
+	// Adds elapsedSeconds of real time. Returns the number of ticks to run now.
+	int advance(double elapsedSeconds);
+
+	// Length of one tick in seconds.
+	double tickSeconds() const { return tickLength; }
+
+	// How far we are between the previous tick and the next one, in [0, 1).
+	float alpha() const { return (float)(accumulator / tickLength); }
+
+	// Ticks run since construction.
+	uint64_t tickCount() const { return ticks; }
+
+	// Real time thrown away by the catch-up limit since construction.
+	double droppedSeconds() const { return dropped; }
+
+private:
+	double tickLength;
+	int maxTicks;
+	double accumulator = 0.0;
+	uint64_t ticks = 0;
+	double dropped = 0.0;
+};
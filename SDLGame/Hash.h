@@ -0,0 +1,41 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+// 64-bit FNV-1a. Fast, tiny and stable across platforms and runs, which is all we
+// need for asset names and content change detection (not for anything adversarial).
+// Pass an earlier result as hash to carry on from it.
+const uint64_t fnv1a64Seed = 14695981039346656037ull;
+
+inline uint64_t fnv1a64(const void* data, size_t size, uint64_t hash = fnv1a64Seed)
+{
+	const unsigned char* bytes = (const unsigned char*)data;
+	for (size_t i = 0; i < size; i++)
+	{
+		hash ^= bytes[i];
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+// The same over 64-bit words, the last one padded with zeros: a different hash, but an
+// eighth of the steps, for arrays big enough that hashing them bytewise would show up.
+inline uint64_t fnv1a64Words(const void* data, size_t size, uint64_t hash = fnv1a64Seed)
+{
+	const unsigned char* bytes = (const unsigned char*)data;
+	for (size_t i = 0; i < size; i += 8)
+	{
+		uint64_t word = 0;
+		memcpy(&word, bytes + i, size - i < 8 ? size - i : 8);
+		hash ^= word;
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+inline uint64_t fnv1a64(const std::string& text)
+{
+	return fnv1a64(text.data(), text.size());
+}
@@ -0,0 +1,82 @@
+#include "HotReloader.h"
+#include <chrono>
+#include <iostream>
+#include "ImageLoader.h"
+#include "SpriteAtlas.h"
+
+HotReloader::~HotReloader()
+{
+	watcher.stop();
+	for (Pending& image : pending)
+		SDL_FreeSurface(image.surface.get());
+}
+
+bool HotReloader::start()
+{
+	return watcher.start(loader.root());
+}
+
+int HotReloader::update()
+{
+	int reloaded = 0;
+	for (const std::string& path : watcher.takeChanges())
+	{
+		if (path == atlas.tableFile())
+		{
+			switch (atlas.reloadTable())
+			{
+			case SpriteAtlas::ReloadResult::Updated:
+				std::cout << "Reloaded " << path << std::endl;
+				reloaded++;
+				break;
+			case SpriteAtlas::ReloadResult::NeedsRepack:
+				std::cout << "Could not reload " << path << ": the number of atlas pages changed, restart to pick it up" << std::endl;
+				break;
+			case SpriteAtlas::ReloadResult::Failed:
+				// Often a table the packer is still writing; the next change event retries it.
+				std::cout << "Could not reload " << path << ": it can't be read, or the game isn't using a packed atlas" << std::endl;
+				break;
+			case SpriteAtlas::ReloadResult::NotUsed:
+				break;
+			}
+			continue;
+		}
+		if (path.size() < 4 || path.compare(path.size() - 4, 4, ".png") != 0)
+			continue;
+
+		// The pack still has the old pixels, so anything that loads this image later must decode the file.
+		loader.bypassPack(path);
+		Uint32 format = atlas.textureFormat();
+		pending.push_back({ path, decodePool.submit([this, path, format]() { return loader.decodeSurface(path, format); }), SDL_GetPerformanceCounter() });
+	}
+
+	for (size_t i = 0; i < pending.size();)
+	{
+		Pending& image = pending[i];
+		if (image.surface.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+		{
+			i++;
+			continue;
+		}
+
+		SpriteAtlas::ReloadResult result = atlas.reloadImage(image.path, image.surface.get());
+		double ms = (SDL_GetPerformanceCounter() - image.changedAt) * 1000.0 / SDL_GetPerformanceFrequency();
+		switch (result)
+		{
+		case SpriteAtlas::ReloadResult::Updated:
+			std::cout << "Reloaded " << image.path << " in " << ms << " ms" << std::endl;
+			reloaded++;
+			break;
+		case SpriteAtlas::ReloadResult::NeedsRepack:
+			std::cout << image.path << " no longer fits its place in the atlas; rebuild the atlas target to see all of it" << std::endl;
+			break;
+		case SpriteAtlas::ReloadResult::Failed:
+			std::cout << "Could not reload " << image.path << ": " << SDL_GetError() << std::endl;
+			break;
+		case SpriteAtlas::ReloadResult::NotUsed:
+			break;
+		}
+		pending.erase(pending.begin() + i);
+	}
+	return reloaded;
+}
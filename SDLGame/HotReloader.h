@@ -0,0 +1,45 @@
+#pragma once
+#include <future>
+#include <string>
+#include <vector>
+#include <SDL.h>
+#include "FileWatcher.h"
+#include "ThreadPool.h"
+
+class ImageLoader;
+class SpriteAtlas;
+
+// Watches the asset directory and puts edited images back on screen without a restart.
+// A changed PNG is decoded on a background thread; update() then patches the one
+// texture or atlas rectangle that uses it, so sprite ids and asset handles all stay
+// valid. Saving a repacked atlas.txt moves sprites to their new rectangles.
+class HotReloader
+{
+public:
+	HotReloader(SpriteAtlas& atlas, ImageLoader& loader) : atlas(atlas), loader(loader), decodePool(1) {}
+	~HotReloader();
+
+	HotReloader(const HotReloader&) = delete;
+	HotReloader& operator=(const HotReloader&) = delete;
+
+	// Starts watching the loader's asset root. Returns false if the platform or directory doesn't allow it.
+	bool start();
+
+	// Call once per frame on the render thread, before drawing. Returns how many images, and
+	// sprite tables, were reloaded.
+	int update();
+
+private:
+	struct Pending
+	{
+		std::string path;
+		std::future<SDL_Surface*> surface;
+		Uint64 changedAt;
+	};
+
+	SpriteAtlas& atlas;
+	ImageLoader& loader;
+	FileWatcher watcher;
+	ThreadPool decodePool;
+	std::vector<Pending> pending;
+};
@@ -0,0 +1,171 @@
+#include "ImageLoader.h"
+#include <algorithm>
+#include <filesystem>
+#include <SDL_image.h>
+#include "ThreadPool.h"
+#include "TraceLog.h"
+
+namespace fs = std::filesystem;
+
+namespace
+{
+	SDL_Surface* convertTo(SDL_Surface* pSurface, Uint32 format)
+	{
+		if (pSurface == nullptr || format == SDL_PIXELFORMAT_UNKNOWN || pSurface->format->format == format)
+			return pSurface;
+		SDL_Surface* pConverted = SDL_ConvertSurfaceFormat(pSurface, format, 0);
+		SDL_FreeSurface(pSurface);
+		return pConverted;
+	}
+}
+
+bool ImageLoader::openPack(const std::string& packFile)
+{
+	return pack.open(assetRoot + packFile);
+}
+
+const AssetPack::Entry* ImageLoader::packEntry(const std::string& path)
+{
+	const AssetPack::Entry* pEntry = pack.find(path);
+	if (pEntry)
+	{
+		std::lock_guard<std::mutex> lock(staleMutex);
+		if (stalePaths.count(path))
+			pEntry = nullptr;
+	}
+	return pEntry;
+}
+
+SDL_Surface* ImageLoader::loadSurface(const std::string& path, Uint32 format)
+{
+	const AssetPack::Entry* pEntry = packEntry(path);
+	if (pEntry == nullptr)
+		return decodeSurface(path, format);
+
+	TraceScope trace(pTrace, path, "decode");
+	SDL_Surface* pSurface = SDL_CreateRGBSurfaceWithFormatFrom((void*)pack.pixels(*pEntry), (int)pEntry->width, (int)pEntry->height,
+		SDL_BITSPERPIXEL(pack.pixelFormat()), (int)pEntry->pitch, pack.pixelFormat());
+	if (pSurface == nullptr)
+		return nullptr;
+	packCount++;
+	return convertTo(pSurface, format);
+}
+
+SDL_Surface* ImageLoader::decodeSurface(const std::string& path, Uint32 format)
+{
+	TraceScope trace(pTrace, path, "decode");
+	SDL_Surface* pSurface = IMG_Load((assetRoot + path).c_str());
+	if (pSurface == nullptr)
+		return nullptr;
+	decodeCount++;
+	return convertTo(pSurface, format);
+}
+
+void ImageLoader::bypassPack(const std::string& path)
+{
+	std::lock_guard<std::mutex> lock(staleMutex);
+	stalePaths.insert(path);
+}
+
+bool ImageLoader::loadCollisionMask(const std::string& path, CollisionMask& mask)
+{
+	const AssetPack::Entry* pEntry = packEntry(path);
+	if (pEntry && pack.collisionMask(*pEntry, mask))
+		return true;
+
+	// ARGB8888 keeps alpha in the top byte, where CollisionMask::build reads it. Use the
+	// pack's threshold so masks match whichever way they were made.
+	SDL_Surface* pSurface = decodeSurface(path, SDL_PIXELFORMAT_ARGB8888);
+	if (pSurface == nullptr)
+	{
+		mask.clear();
+		return false;
+	}
+	mask.build(pSurface->pixels, pSurface->w, pSurface->h, pSurface->pitch, pack.maskThreshold());
+	SDL_FreeSurface(pSurface);
+	return true;
+}
+
+bool ImageLoader::buildCollisionMask(const SDL_Surface* pSurface, CollisionMask& mask) const
+{
+	SDL_Surface* pConverted = nullptr;
+	if (pSurface && pSurface->format->format != SDL_PIXELFORMAT_ARGB8888)
+		pSurface = pConverted = SDL_ConvertSurfaceFormat(const_cast<SDL_Surface*>(pSurface), SDL_PIXELFORMAT_ARGB8888, 0);
+	if (pSurface == nullptr)
+	{
+		mask.clear();
+		return false;
+	}
+	mask.build(pSurface->pixels, pSurface->w, pSurface->h, pSurface->pitch, pack.maskThreshold());
+	SDL_FreeSurface(pConverted);
+	return true;
+}
+
+bool ImageLoader::loadSpriteRuns(const std::string& path, SpriteRuns& runs)
+{
+	const AssetPack::Entry* pEntry = packEntry(path);
+	if (pEntry && pack.spriteRuns(*pEntry, runs))
+		return true;
+	runs.clear();
+	return false;
+}
+
+bool ImageLoader::loadAlphaKind(const std::string& path, AlphaKind& kind)
+{
+	const AssetPack::Entry* pEntry = packEntry(path);
+	return pEntry && pack.alphaKind(*pEntry, kind);
+}
+
+std::future<SDL_Surface*> ImageLoader::loadSurfaceAsync(const std::string& path, ThreadPool& pool, Uint32 format)
+{
+	return pool.submit([this, path, format]() { return loadSurface(path, format); });
+}
+
+SDL_Texture* ImageLoader::upload(SDL_Renderer* pRenderer, SDL_Surface* pSurface, const std::string& path, bool keepSurface)
+{
+	if (pSurface == nullptr)
+		return nullptr;
+
+	TraceScope trace(pTrace, path, "upload");
+	SDL_Texture* pTexture = SDL_CreateTextureFromSurface(pRenderer, pSurface);
+	if (!keepSurface)
+		SDL_FreeSurface(pSurface);
+	return pTexture;
+}
+
+SDL_Texture* ImageLoader::loadTexture(SDL_Renderer* pRenderer, const std::string& path)
+{
+	// When the pack was built for this renderer's format this is a straight upload.
+	return upload(pRenderer, loadSurface(path), path);
+}
+
+std::vector<std::string> ImageLoader::listImages() const
+{
+	std::vector<std::string> paths;
+	std::error_code error;
+	for (fs::recursive_directory_iterator it(assetRoot, error), end; !error && it != end; it.increment(error))
+	{
+		fs::path relative = fs::relative(it->path(), assetRoot);
+		if (it->is_directory() && relative == "Atlas")
+			it.disable_recursion_pending();
+		else if (it->is_regular_file() && relative.extension() == ".png")
+			paths.push_back(relative.generic_string());
+	}
+	std::sort(paths.begin(), paths.end());
+	return paths;
+}
+
+Uint32 ImageLoader::textureFormat(SDL_Renderer* pRenderer)
+{
+	SDL_RendererInfo info;
+	if (SDL_GetRendererInfo(pRenderer, &info) == 0)
+	{
+		for (Uint32 i = 0; i < info.num_texture_formats; i++)
+		{
+			Uint32 format = info.texture_formats[i];
+			if (!SDL_ISPIXELFORMAT_FOURCC(format) && SDL_ISPIXELFORMAT_ALPHA(format))
+				return format;
+		}
+	}
+	return SDL_PIXELFORMAT_ARGB8888;
+}
@@ -0,0 +1,96 @@
+#pragma once
+#include <atomic>
+#include <future>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <vector>
+#include <SDL.h>
+#include "AssetPack.h"
+#include "CollisionMask.h"
+#include "SpriteRuns.h"
+
+class ThreadPool;
+class TraceLog;
+
+// Loads images by their path under the asset root, e.g. "Meteors/meteorBrown_big1.png".
+// If an asset pack is open and has the image, the surface wraps the pack's
+// memory-mapped pixels directly: no decode, no copy. Otherwise the PNG is decoded
+// with SDL_image as before.
+//
+// loadSurface() and loadSurfaceAsync() are safe to call from worker threads;
+// upload() and loadTexture() must run on the render thread.
+class ImageLoader
+{
+public:
+	ImageLoader(const std::string& assetRoot) : assetRoot(assetRoot) {}
+
+	// Maps assetRoot + packFile. Returns false if there is no usable pack; loading then goes to the PNGs.
+	bool openPack(const std::string& packFile = "assets.pack");
+	bool hasPack() const { return pack.isOpen(); }
+
+	const std::string& root() const { return assetRoot; }
+
+	// Records a "decode" span per image and an "upload" span per texture. Null turns it off.
+	void setTrace(TraceLog* pLog) { pTrace = pLog; }
+
+	// Caller frees the surface with SDL_FreeSurface. A surface from the pack is only
+	// valid while this loader is alive; turn it into a texture or copy it if it must outlive it.
+	// If format isn't SDL_PIXELFORMAT_UNKNOWN the surface is converted to it.
+	SDL_Surface* loadSurface(const std::string& path, Uint32 format = SDL_PIXELFORMAT_UNKNOWN);
+
+	// Always decodes the PNG, even if the pack has the image.
+	SDL_Surface* decodeSurface(const std::string& path, Uint32 format = SDL_PIXELFORMAT_UNKNOWN);
+
+	// The PNG for path changed after the pack was built: from now on load it from the file.
+	void bypassPack(const std::string& path);
+
+	// The image's collision mask, from the pack if it has one, otherwise built from the
+	// decoded PNG. Returns false (and an empty mask) if the image can't be loaded.
+	// Safe on worker threads, like loadSurface().
+	bool loadCollisionMask(const std::string& path, CollisionMask& mask);
+
+	// The same mask built from an image already decoded, such as a hot-reloaded one, so
+	// it isn't decoded again. Returns false (and an empty mask) if it can't be converted.
+	bool buildCollisionMask(const SDL_Surface* pSurface, CollisionMask& mask) const;
+
+	// The image's sprite runs from the pack. Returns false (and empty runs) if the pack
+	// doesn't have them: build them from the pixels instead, which callers usually hold.
+	bool loadSpriteRuns(const std::string& path, SpriteRuns& runs);
+
+	// How the image uses alpha, from the pack. Returns false if the pack doesn't say.
+	bool loadAlphaKind(const std::string& path, AlphaKind& kind);
+
+	// loadSurface() on a pool thread. Decoding and format conversion both happen
+	// there, so all that's left for the render thread is upload().
+	std::future<SDL_Surface*> loadSurfaceAsync(const std::string& path, ThreadPool& pool, Uint32 format = SDL_PIXELFORMAT_UNKNOWN);
+
+	// Creates a texture from the surface and frees the surface (even on failure), unless
+	// keepSurface is set: then the caller still owns it.
+	SDL_Texture* upload(SDL_Renderer* pRenderer, SDL_Surface* pSurface, const std::string& path, bool keepSurface = false);
+
+	SDL_Texture* loadTexture(SDL_Renderer* pRenderer, const std::string& path);
+
+	// Every .png under the asset root except generated atlas pages, as loadable paths, sorted.
+	std::vector<std::string> listImages() const;
+
+	// The pixel format SDL_CreateTextureFromSurface would pick for an image with alpha,
+	// so surfaces converted to it upload without another conversion.
+	static Uint32 textureFormat(SDL_Renderer* pRenderer);
+
+	// How many images came from the pack and how many had to be decoded.
+	int packLoads() const { return packCount; }
+	int decodedLoads() const { return decodeCount; }
+
+private:
+	// The pack's entry for path, or nullptr if it has none or it went stale.
+	const AssetPack::Entry* packEntry(const std::string& path);
+
+	std::string assetRoot;
+	AssetPack pack;
+	TraceLog* pTrace = nullptr;
+	std::mutex staleMutex;
+	std::unordered_set<std::string> stalePaths;
+	std::atomic<int> packCount{ 0 };
+	std::atomic<int> decodeCount{ 0 };
+};
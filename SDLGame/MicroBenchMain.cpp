@@ -0,0 +1,1180 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <new>
+#include <random>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+#include "BenchStats.h"
+#include "BlitKernels.h"
+#include "CollisionKernels.h"
+#include "CollisionMask.h"
+#include "CollisionShape.h"
+#include "ContactEvents.h"
+#include "EntityStore.h"
+#include "Fragmenter.h"
+#include "SpatialHash.h"
+#include "SpriteRuns.h"
+#include "Sweep.h"
+
+// SDLGame_microbench: times the engine's inner loops on their own, without SDL.
+//
+//   SDLGame_microbench [--bench <name>|all] [--count N] [--ticks N] [--seed N] [--out report.json]
+//
+// Each bench runs the same work over the same random data in two or more ways and
+// reports nanoseconds per item (median and p90 over --ticks runs). Benches:
+//
+//   entities  EntityStore (structure of arrays) against a plain vector of structs
+//             holding the same fields: moving everything, a bounds query that only
+//             reads positions and sizes, and destroying/creating 1% per tick.
+//   broadphase  SpatialHash against testing every pair, then one 120 Hz tick (move,
+//             rebuild, find pairs) at growing object counts up to --count, with the
+//             world growing too so density stays the same. ns per object should stay
+//             flat; tick_ms is against the 8.33 ms a 120 Hz tick has. Last, boxes on
+//             every collision layer at once, paired unfiltered and through the game's
+//             LayerMatrix into ContactEvents; kept_mismatch must be 0.
+//   masks     CollisionMask tests on pairs whose boxes overlap, against the box test
+//             alone: unrotated (exact), then rotated at every level, then the convex
+//             hulls (CollisionShape) rotated the same way. The hit rates are the share
+//             of box contacts each test keeps; shape_missed counts pairs the level 0
+//             masks say touch that the hulls turned away, and should be 0.
+//   sweep     Laser bolts moving 40 to 120 pixels a tick through a field of 18-pixel
+//             targets: one tick testing where each bolt ends up (which misses the
+//             targets it jumps over), the same tick split into enough sub-steps that
+//             nothing is missed, and one tick with swept bounds and path tests.
+//             tunnelled_share is the share of hits the plain tick misses.
+//   kernels   The narrow-phase box and circle kernels at every SIMD level this CPU
+//             runs (scalar, SSE2, AVX2) on --count candidate pairs, about half of them
+//             overlapping. mpairs_per_s is millions of pairs a second at each level.
+//   fragments Breaking about --count / 12 big meteors into medium, small and tiny pieces
+//             and those into nothing, every meteor at once at each step: in a store
+//             reserved up front (pooled) and in one that grows as pieces are created.
+//             allocations_per_run counts heap allocations while breaking; pooled is 0.
+//   blit      The software blitter's row kernels (copy, blend, add, modulate) at every
+//             SIMD level on --count pixels of sprite-like runs: transparent, opaque and
+//             translucent. mpixels_per_s is millions of pixels a second at each level;
+//             mismatch counts pixels where a level and the scalar code differ, and is 0.
+//
+// The fields that must be 0 (kept_mismatch, shape_missed, pooled_allocations_per_run and
+// mismatch) are checked too: if one isn't, it says so and exits with 1. ctest runs a
+// short pass of every bench for that.
+
+namespace
+{
+	// Every heap allocation, so a bench can check a loop makes none.
+	size_t allocationCount = 0;
+}
+
+void* operator new(size_t size)
+{
+	allocationCount++;
+	if (void* p = std::malloc(size ? size : 1))
+		return p;
+	throw std::bad_alloc();
+}
+
+void* operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+// GCC sees free() take a pointer from operator new once these are inlined, not that the
+// operator new above is the one that got it from malloc().
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void operator delete(void* p) noexcept
+{
+	std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+	std::free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+	std::free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept
+{
+	std::free(p);
+}
+
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic pop
+#endif
+
+namespace
+{
+	struct MicroOptions
+	{
+		std::string bench = "all";
+		int count = 100000;
+		int ticks = 200;
+		unsigned int seed = 1007;
+		std::string outPath;
+	};
+
+	// One timed variant of a bench: ns per item for every tick.
+	struct Variant
+	{
+		std::string name;
+		SampleStats nsPerItem;
+	};
+
+	struct Workload
+	{
+		std::string name;
+		std::vector<Variant> variants;
+		std::vector<std::pair<std::string, double>> extras; // written as extra fields
+		std::vector<std::pair<std::string, double>> checks; // likewise, but must be 0 or the run fails
+	};
+
+	struct BenchResult
+	{
+		std::string name;
+		std::vector<Workload> workloads;
+		double checksum = 0.0;
+	};
+
+	// Runs work once per tick and records how long each run took per item.
+	void timeTicks(Variant& variant, int ticks, size_t items, const std::function<void()>& work)
+	{
+		variant.nsPerItem.reserve(ticks);
+		for (int tick = 0; tick < ticks; tick++)
+		{
+			auto start = std::chrono::steady_clock::now();
+			work();
+			std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+			variant.nsPerItem.add(elapsed.count() / (items ? items : 1));
+		}
+	}
+
+	// The array-of-structs baseline: every field of one entity next to each other.
+	struct EntityObject
+	{
+		Real x, y;
+		Real prevX, prevY;
+		Real vx, vy;
+		Real w, h;
+		Real angle, prevAngle;
+		Real spin;
+		Real life;
+		int32_t sprite;
+	};
+
+	BenchResult benchEntities(const MicroOptions& options)
+	{
+		const Real tickSeconds = Real(1.0f / 120.0f);
+		const float width = 4096.0f, height = 4096.0f;
+		std::mt19937 rng(options.seed);
+		std::uniform_real_distribution<float> position(0.0f, width);
+		std::uniform_real_distribution<float> velocity(-200.0f, 200.0f);
+		std::uniform_real_distribution<float> size(8.0f, 100.0f);
+
+		std::vector<EntityObject> objects;
+		EntityStore store;
+		objects.reserve(options.count);
+		store.reserve(options.count);
+		auto randomEntity = [&]()
+		{
+			EntityObject e = {};
+			e.x = e.prevX = Real(position(rng));
+			e.y = e.prevY = Real(position(rng));
+			e.vx = Real(velocity(rng));
+			e.vy = Real(velocity(rng));
+			e.w = e.h = Real(size(rng));
+			e.spin = Real(velocity(rng));
+			e.life = Real(4);
+			e.sprite = (int32_t)(rng() % 48);
+			return e;
+		};
+		auto addToStore = [&store](const EntityObject& e)
+		{
+			store.create();
+			size_t i = store.size() - 1;
+			store.x[i] = store.prevX[i] = e.x;
+			store.y[i] = store.prevY[i] = e.y;
+			store.vx[i] = e.vx;
+			store.vy[i] = e.vy;
+			store.w[i] = e.w;
+			store.h[i] = e.h;
+			store.spin[i] = e.spin;
+			store.life[i] = e.life;
+			store.sprite[i] = e.sprite;
+		};
+		for (int i = 0; i < options.count; i++)
+		{
+			objects.push_back(randomEntity());
+			addToStore(objects.back());
+		}
+
+		BenchResult result;
+		result.name = "entities";
+		size_t count = (size_t)options.count;
+
+		Workload integrate = { "integrate", { { "aos", {} }, { "soa", {} } }, {}, {} };
+		timeTicks(integrate.variants[0], options.ticks, count, [&]()
+		{
+			for (EntityObject& e : objects)
+			{
+				e.prevX = e.x;
+				e.prevY = e.y;
+				e.prevAngle = e.angle;
+				e.x += e.vx * tickSeconds;
+				e.y += e.vy * tickSeconds;
+				Real angle = e.angle + e.spin * tickSeconds;
+				Real wrap = angle < Real(0) ? Real(360) : angle >= Real(360) ? -Real(360) : Real(0);
+				e.angle = angle + wrap;
+				e.prevAngle += wrap;
+			}
+		});
+		timeTicks(integrate.variants[1], options.ticks, count, [&]() { store.integrate(tickSeconds); });
+		result.workloads.push_back(integrate);
+
+		// What a broadphase or culling pass does: look at bounds and nothing else.
+		const Real qx0 = Real(width * 0.25f), qy0 = Real(height * 0.25f), qx1 = Real(width * 0.75f), qy1 = Real(height * 0.75f);
+		int hitsAos = 0, hitsSoa = 0;
+		Workload query = { "bounds_query", { { "aos", {} }, { "soa", {} } }, {}, {} };
+		timeTicks(query.variants[0], options.ticks, count, [&]()
+		{
+			int hits = 0;
+			for (const EntityObject& e : objects)
+				hits += (e.x < qx1) & (e.x + e.w > qx0) & (e.y < qy1) & (e.y + e.h > qy0);
+			hitsAos += hits;
+		});
+		timeTicks(query.variants[1], options.ticks, count, [&]()
+		{
+			const Real* pX = store.x.data();
+			const Real* pY = store.y.data();
+			const Real* pW = store.w.data();
+			const Real* pH = store.h.data();
+			int hits = 0;
+			for (size_t i = 0; i < count; i++)
+				hits += (pX[i] < qx1) & (pX[i] + pW[i] > qx0) & (pY[i] < qy1) & (pY[i] + pH[i] > qy0);
+			hitsSoa += hits;
+		});
+		result.workloads.push_back(query);
+
+		// Short-lived objects: 1% die and get replaced every tick.
+		size_t churn = count / 100;
+		std::vector<size_t> victims(churn);
+		Workload lifecycle = { "destroy_create_1pct", { { "aos", {} }, { "soa", {} } }, {}, {} };
+		timeTicks(lifecycle.variants[0], options.ticks, churn, [&]()
+		{
+			for (size_t& victim : victims)
+				victim = rng() % objects.size();
+			for (size_t victim : victims)
+			{
+				objects[victim] = objects.back();
+				objects.pop_back();
+			}
+			for (size_t i = 0; i < churn; i++)
+				objects.push_back(randomEntity());
+		});
+		timeTicks(lifecycle.variants[1], options.ticks, churn, [&]()
+		{
+			for (size_t& victim : victims)
+				victim = rng() % store.size();
+			for (size_t victim : victims)
+				store.destroyAt(victim);
+			for (size_t i = 0; i < churn; i++)
+				addToStore(randomEntity());
+		});
+		result.workloads.push_back(lifecycle);
+
+		double checksum = hitsAos - hitsSoa;
+		for (size_t i = 0; i < store.size(); i++)
+			checksum += toFloat(store.x[i]) * 1e-6;
+		for (const EntityObject& e : objects)
+			checksum += toFloat(e.x) * 1e-6;
+		result.checksum = checksum;
+		return result;
+	}
+
+	BenchResult benchBroadphase(const MicroOptions& options)
+	{
+		const float tickSeconds = 1.0f / 120.0f;
+		std::mt19937 rng(options.seed);
+		std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+		std::uniform_real_distribution<float> velocity(-200.0f, 200.0f);
+		std::uniform_real_distribution<float> size(8.0f, 100.0f);
+
+		// Boxes spread over a square world, one per 80x80 pixels on average.
+		auto randomStore = [&](EntityStore& store, int count)
+		{
+			float side = 80.0f * std::sqrt((float)count);
+			store.clear();
+			store.reserve(count);
+			for (int i = 0; i < count; i++)
+			{
+				store.create();
+				store.x[i] = Real(unit(rng) * side);
+				store.y[i] = Real(unit(rng) * side);
+				store.vx[i] = Real(velocity(rng));
+				store.vy[i] = Real(velocity(rng));
+				store.w[i] = store.h[i] = Real(size(rng));
+			}
+			return side;
+		};
+
+		std::vector<float> sizes(1000);
+		for (float& s : sizes)
+			s = size(rng);
+		SpatialHash hash(SpatialHash::cellSizeFor(sizes));
+
+		BenchResult result;
+		result.name = "broadphase";
+		std::vector<BoxPair> pairs;
+		size_t bruteForcePairs = 0, hashPairs = 0;
+
+		// Small enough for testing every pair to finish.
+		EntityStore store;
+		int smallCount = std::min(options.count, 2000);
+		randomStore(store, smallCount);
+		Workload compare = { "pairs_" + std::to_string(smallCount), { { "brute_force", {} }, { "spatial_hash", {} } }, {}, {} };
+		timeTicks(compare.variants[0], options.ticks, store.size(), [&]()
+		{
+			pairs.clear();
+			for (uint32_t a = 0; a < store.size(); a++)
+			{
+				for (uint32_t b = a + 1; b < store.size(); b++)
+				{
+					if (store.x[a] < store.x[b] + store.w[b] && store.x[b] < store.x[a] + store.w[a]
+						&& store.y[a] < store.y[b] + store.h[b] && store.y[b] < store.y[a] + store.h[a])
+						pairs.push_back({ a, b });
+				}
+			}
+			bruteForcePairs += pairs.size();
+		});
+		timeTicks(compare.variants[1], options.ticks, store.size(), [&]()
+		{
+			hash.clear();
+			hash.add(store, CollisionLayer::Meteor);
+			hash.build();
+			hash.findPairs(pairs);
+			hashPairs += pairs.size();
+		});
+		result.workloads.push_back(compare);
+
+		// The whole broadphase part of a tick, at 1/8, 1/4, 1/2 and all of --count.
+		double checksum = (double)bruteForcePairs - (double)hashPairs;
+		for (int divisor : { 8, 4, 2, 1 })
+		{
+			int count = options.count / divisor;
+			if (count < 1)
+				continue;
+			Real side = Real(randomStore(store, count));
+			size_t tickPairs = 0;
+			Workload tick = { "tick_" + std::to_string(count), { { "spatial_hash", {} } }, {}, {} };
+			timeTicks(tick.variants[0], options.ticks, store.size(), [&]()
+			{
+				store.integrate(Real(tickSeconds));
+				for (size_t i = 0; i < store.size(); i++)
+				{
+					if (store.x[i] < Real(0))
+						store.x[i] += side;
+					else if (store.x[i] >= side)
+						store.x[i] -= side;
+					if (store.y[i] < Real(0))
+						store.y[i] += side;
+					else if (store.y[i] >= side)
+						store.y[i] -= side;
+				}
+				hash.clear();
+				hash.add(store, CollisionLayer::Meteor);
+				hash.build();
+				hash.findPairs(pairs);
+				tickPairs += pairs.size();
+			});
+			double tickMs = tick.variants[0].nsPerItem.percentile(50) * count / 1e6;
+			tick.extras.push_back({ "tick_ms", tickMs });
+			tick.extras.push_back({ "budget_120hz", tickMs * 120.0 / 1000.0 });
+			tick.extras.push_back({ "pairs_per_tick", (double)tickPairs / options.ticks });
+			tick.extras.push_back({ "cells_per_object", (double)hash.entryCount() / count });
+			result.workloads.push_back(tick);
+			checksum += tickPairs * 1e-6;
+		}
+
+		// Every layer mixed at --count, as a shooter would have them: most boxes are
+		// lasers and meteors, and most of their overlaps (laser on laser, meteor on a
+		// power-up) matter to nobody. Unfiltered, those go into the contact events to be
+		// skipped there; with the game's matrix the broadphase never makes them.
+		const std::pair<CollisionLayer, int> mix[] = {
+			{ CollisionLayer::Player, 0 }, { CollisionLayer::PlayerLaser, 25 }, { CollisionLayer::Enemy, 8 },
+			{ CollisionLayer::EnemyLaser, 25 }, { CollisionLayer::Meteor, 40 }, { CollisionLayer::PowerUp, 2 },
+		};
+		std::vector<EntityStore> layerStores(collisionLayerCount);
+		int mixedCount = 0;
+		float mixedSide = 80.0f * std::sqrt((float)options.count);
+		for (const auto& share : mix)
+		{
+			EntityStore& layerStore = layerStores[(int)share.first];
+			int count = std::max(options.count * share.second / 100, 1);
+			for (int i = 0; i < count; i++)
+			{
+				layerStore.create();
+				layerStore.x[i] = Real(unit(rng) * mixedSide);
+				layerStore.y[i] = Real(unit(rng) * mixedSide);
+				layerStore.w[i] = layerStore.h[i] = Real(size(rng));
+			}
+			mixedCount += count;
+		}
+		const LayerMatrix gameLayers = LayerMatrix::game();
+		ContactEvents events;
+		size_t unfilteredPairs = 0, unfilteredKept = 0, filteredPairs = 0;
+		auto findMixedPairs = [&]()
+		{
+			hash.clear();
+			for (int layer = 0; layer < collisionLayerCount; layer++)
+				hash.add(layerStores[layer], (CollisionLayer)layer);
+			hash.build();
+			hash.findPairs(pairs);
+			events.collect(hash, pairs);
+		};
+		Workload layers = { "layers_" + std::to_string(mixedCount), { { "unfiltered", {} }, { "layer_matrix", {} } }, {}, {} };
+		hash.setLayers(LayerMatrix());
+		timeTicks(layers.variants[0], options.ticks, mixedCount, [&]()
+		{
+			findMixedPairs();
+			unfilteredPairs += events.size();
+			for (int a = 0; a < collisionLayerCount; a++)
+			{
+				for (int b = a; b < collisionLayerCount; b++)
+				{
+					if (gameLayers.collides((CollisionLayer)a, (CollisionLayer)b))
+						unfilteredKept += events.between((CollisionLayer)a, (CollisionLayer)b).size();
+				}
+			}
+		});
+		hash.setLayers(gameLayers);
+		timeTicks(layers.variants[1], options.ticks, mixedCount, [&]()
+		{
+			findMixedPairs();
+			filteredPairs += events.size();
+		});
+		layers.extras.push_back({ "pairs_unfiltered", (double)unfilteredPairs / options.ticks });
+		layers.extras.push_back({ "pairs_kept", (double)filteredPairs / options.ticks });
+		layers.checks.push_back({ "kept_mismatch", (double)unfilteredKept - (double)filteredPairs });
+		result.workloads.push_back(layers);
+		checksum += filteredPairs * 1e-6;
+
+		result.checksum = checksum;
+		return result;
+	}
+
+	BenchResult benchMasks(const MicroOptions& options)
+	{
+		std::mt19937 rng(options.seed);
+		std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+		// Rough discs with bumpy edges, like the meteor sprites, at a few sizes.
+		std::vector<CollisionMask> shapes;
+		for (int size : { 18, 28, 43, 64, 84, 101 })
+		{
+			std::vector<uint32_t> pixels((size_t)size * size, 0);
+			float radius = size * 0.5f;
+			float bumps = 3.0f + unit(rng) * 4.0f, phase = unit(rng) * 6.28f;
+			for (int y = 0; y < size; y++)
+			{
+				for (int x = 0; x < size; x++)
+				{
+					float dx = x + 0.5f - radius, dy = y + 0.5f - radius;
+					float edge = radius * (0.85f + 0.15f * std::sin(std::atan2(dy, dx) * bumps + phase));
+					if (dx * dx + dy * dy < edge * edge)
+						pixels[(size_t)y * size + x] = 0xFF000000u;
+				}
+			}
+			shapes.emplace_back();
+			shapes.back().build(pixels.data(), size, size, size * 4);
+		}
+		std::vector<CollisionShape> hulls(shapes.size());
+		for (size_t i = 0; i < shapes.size(); i++)
+			hulls[i].build(shapes[i]);
+
+		// Pairs placed so their boxes always overlap: all of them reach the narrow phase.
+		struct MaskPair
+		{
+			const CollisionMask* pA;
+			const CollisionMask* pB;
+			const CollisionShape* pHullA;
+			const CollisionShape* pHullB;
+			MaskPlacement placeA, placeB;
+		};
+		size_t pairCount = (size_t)std::min(options.count, 20000);
+		std::vector<MaskPair> maskPairs(pairCount);
+		for (MaskPair& pair : maskPairs)
+		{
+			size_t a = rng() % shapes.size(), b = rng() % shapes.size();
+			pair.pA = &shapes[a];
+			pair.pB = &shapes[b];
+			pair.pHullA = &hulls[a];
+			pair.pHullB = &hulls[b];
+			pair.placeA.angle = unit(rng) * 360.0f;
+			pair.placeB.angle = unit(rng) * 360.0f;
+			pair.placeB.x = 1.0f - pair.pB->width() + unit(rng) * (pair.pA->width() + pair.pB->width() - 2);
+			pair.placeB.y = 1.0f - pair.pB->height() + unit(rng) * (pair.pA->height() + pair.pB->height() - 2);
+		}
+
+		BenchResult result;
+		result.name = "masks";
+		Workload workload = { "pairs_" + std::to_string(pairCount), { { "aabb", {} }, { "mask", {} } }, {}, {} };
+		for (int level = 0; level < CollisionMask::levelCount; level++)
+			workload.variants.push_back({ "rotated_level" + std::to_string(level), {} });
+		workload.variants.push_back({ "rotated_shape", {} });
+
+		size_t boxHits = 0, maskHits = 0;
+		std::vector<size_t> rotatedHits(CollisionMask::levelCount, 0);
+		timeTicks(workload.variants[0], options.ticks, pairCount, [&]()
+		{
+			for (const MaskPair& pair : maskPairs)
+			{
+				boxHits += pair.placeB.x < pair.pA->width() && pair.placeA.x < pair.placeB.x + pair.pB->width()
+					&& pair.placeB.y < pair.pA->height() && pair.placeA.y < pair.placeB.y + pair.pB->height();
+			}
+		});
+		timeTicks(workload.variants[1], options.ticks, pairCount, [&]()
+		{
+			for (const MaskPair& pair : maskPairs)
+				maskHits += CollisionMask::overlaps(*pair.pA, *pair.pB, (int)std::floor(pair.placeB.x), (int)std::floor(pair.placeB.y));
+		});
+		for (int level = 0; level < CollisionMask::levelCount; level++)
+		{
+			timeTicks(workload.variants[2 + level], options.ticks, pairCount, [&]()
+			{
+				for (const MaskPair& pair : maskPairs)
+					rotatedHits[level] += CollisionMask::overlapsRotated(*pair.pA, pair.placeA, *pair.pB, pair.placeB, level);
+			});
+		}
+		size_t shapeHits = 0;
+		timeTicks(workload.variants.back(), options.ticks, pairCount, [&]()
+		{
+			for (const MaskPair& pair : maskPairs)
+				shapeHits += CollisionShape::overlaps(*pair.pHullA, pair.placeA, *pair.pHullB, pair.placeB);
+		});
+		size_t shapeMissed = 0;
+		for (const MaskPair& pair : maskPairs)
+		{
+			shapeMissed += CollisionMask::overlapsRotated(*pair.pA, pair.placeA, *pair.pB, pair.placeB, 0)
+				&& !CollisionShape::overlaps(*pair.pHullA, pair.placeA, *pair.pHullB, pair.placeB);
+		}
+
+		double tests = (double)pairCount * options.ticks;
+		workload.extras.push_back({ "mask_hit_rate", maskHits / tests });
+		for (int level = 0; level < CollisionMask::levelCount; level++)
+			workload.extras.push_back({ "rotated_level" + std::to_string(level) + "_hit_rate", rotatedHits[level] / tests });
+		workload.extras.push_back({ "shape_hit_rate", shapeHits / tests });
+		workload.checks.push_back({ "shape_missed", (double)shapeMissed });
+		result.workloads.push_back(workload);
+		result.checksum = (double)boxHits + (double)maskHits + (double)shapeHits;
+		for (size_t hits : rotatedHits)
+			result.checksum += (double)hits;
+		return result;
+	}
+
+	BenchResult benchSweep(const MicroOptions& options)
+	{
+		const float tickSeconds = 1.0f / 120.0f;
+		const float boltLength = 54.0f, boltWidth = 9.0f, targetSize = 18.0f;
+		const float minMove = 40.0f, maxMove = 120.0f; // pixels per tick
+		std::mt19937 rng(options.seed);
+		std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+		// Still targets, one per 40x40 pixels on average, and a bolt for every 16 of them.
+		int targetCount = std::max(options.count, 16);
+		float side = 40.0f * std::sqrt((float)targetCount);
+		EntityStore targets;
+		targets.reserve(targetCount);
+		for (int i = 0; i < targetCount; i++)
+		{
+			targets.create();
+			targets.x[i] = targets.prevX[i] = Real(unit(rng) * side);
+			targets.y[i] = targets.prevY[i] = Real(unit(rng) * side);
+			targets.w[i] = targets.h[i] = Real(targetSize);
+		}
+
+		// Bolts are stored by the bounds of their rotated sprite; halfX/halfY run from
+		// the centre to the nose.
+		EntityStore startBolts;
+		std::vector<float> halfX, halfY;
+		int boltCount = targetCount / 16;
+		for (int i = 0; i < boltCount; i++)
+		{
+			float angle = unit(rng) * 2.0f * 3.14159265f;
+			float dirX = std::cos(angle), dirY = std::sin(angle);
+			float speed = (minMove + unit(rng) * (maxMove - minMove)) / tickSeconds;
+			startBolts.create();
+			startBolts.w[i] = Real(std::abs(dirY) * boltWidth + std::abs(dirX) * boltLength);
+			startBolts.h[i] = Real(std::abs(dirX) * boltWidth + std::abs(dirY) * boltLength);
+			startBolts.x[i] = startBolts.prevX[i] = Real(unit(rng) * side);
+			startBolts.y[i] = startBolts.prevY[i] = Real(unit(rng) * side);
+			startBolts.vx[i] = Real(dirX * speed);
+			startBolts.vy[i] = Real(dirY * speed);
+			halfX.push_back(dirX * boltLength * 0.5f);
+			halfY.push_back(dirY * boltLength * 0.5f);
+		}
+
+		SpatialHash hash(boltLength * 2.0f);
+		std::vector<BoxPair> pairs;
+		EntityStore bolts;
+		std::vector<uint8_t> boltHit;
+
+		// Whether the centre line of a bolt, from its tail at (tailX, tailY) to its nose
+		// at (noseX, noseY), crosses the target.
+		auto lineHits = [&](float tailX, float tailY, float noseX, float noseY, uint32_t target)
+		{
+			Bounds box = { toFloat(targets.x[target]), toFloat(targets.y[target]), toFloat(targets.x[target]) + targetSize, toFloat(targets.y[target]) + targetSize };
+			float hitTime;
+			return sweepBounds({ tailX, tailY, tailX, tailY }, noseX - tailX, noseY - tailY, box, hitTime);
+		};
+
+		// Marks the bolts whose centre line crosses a target where they are now.
+		auto collideAtEnd = [&]()
+		{
+			hash.clear();
+			hash.add(bolts, CollisionLayer::PlayerLaser);
+			uint32_t firstTarget = hash.add(targets, CollisionLayer::Meteor);
+			hash.build();
+			hash.findPairsBetween(firstTarget, pairs);
+			for (const BoxPair& pair : pairs)
+			{
+				float centerX = toFloat(bolts.x[pair.a]) + toFloat(bolts.w[pair.a]) * 0.5f, centerY = toFloat(bolts.y[pair.a]) + toFloat(bolts.h[pair.a]) * 0.5f;
+				if (lineHits(centerX - halfX[pair.a], centerY - halfY[pair.a], centerX + halfX[pair.a], centerY + halfY[pair.a], pair.b - firstTarget))
+					boltHit[pair.a] = 1;
+			}
+		};
+
+		auto countHits = [&]()
+		{
+			size_t hits = 0;
+			for (uint8_t hit : boltHit)
+				hits += hit;
+			return hits;
+		};
+
+		// A sub-step shorter than a bolt leaves no gap between where it was and where it is.
+		int substeps = (int)std::ceil(maxMove / boltLength);
+		size_t items = (size_t)targetCount + boltCount;
+		size_t endHits = 0, substepHits = 0, sweptHits = 0;
+
+		BenchResult result;
+		result.name = "sweep";
+		Workload workload = { "tick_" + std::to_string(items), { { "end_position", {} }, { "substeps", {} }, { "swept", {} } }, {}, {} };
+		timeTicks(workload.variants[0], options.ticks, items, [&]()
+		{
+			bolts = startBolts;
+			boltHit.assign(boltCount, 0);
+			bolts.integrate(Real(tickSeconds));
+			collideAtEnd();
+			endHits += countHits();
+		});
+		timeTicks(workload.variants[1], options.ticks, items, [&]()
+		{
+			bolts = startBolts;
+			boltHit.assign(boltCount, 0);
+			for (int step = 0; step < substeps; step++)
+			{
+				bolts.integrate(Real(tickSeconds / substeps));
+				collideAtEnd();
+			}
+			substepHits += countHits();
+		});
+		timeTicks(workload.variants[2], options.ticks, items, [&]()
+		{
+			bolts = startBolts;
+			boltHit.assign(boltCount, 0);
+			bolts.integrate(Real(tickSeconds));
+			hash.clear();
+			hash.addSwept(bolts, CollisionLayer::PlayerLaser);
+			uint32_t firstTarget = hash.addSwept(targets, CollisionLayer::Meteor);
+			hash.build();
+			hash.findPairsBetween(firstTarget, pairs);
+			for (const BoxPair& pair : pairs)
+			{
+				// Tail where the tick started to nose where it ended.
+				float fromX = toFloat(bolts.prevX[pair.a]) + toFloat(bolts.w[pair.a]) * 0.5f, fromY = toFloat(bolts.prevY[pair.a]) + toFloat(bolts.h[pair.a]) * 0.5f;
+				float toX = toFloat(bolts.x[pair.a]) + toFloat(bolts.w[pair.a]) * 0.5f, toY = toFloat(bolts.y[pair.a]) + toFloat(bolts.h[pair.a]) * 0.5f;
+				if (lineHits(fromX - halfX[pair.a], fromY - halfY[pair.a], toX + halfX[pair.a], toY + halfY[pair.a], pair.b - firstTarget))
+					boltHit[pair.a] = 1;
+			}
+			sweptHits += countHits();
+		});
+
+		workload.extras.push_back({ "substeps", (double)substeps });
+		workload.extras.push_back({ "hits_per_tick", (double)sweptHits / options.ticks });
+		workload.extras.push_back({ "tunnelled_share", sweptHits > 0 ? 1.0 - (double)endHits / sweptHits : 0.0 });
+		result.workloads.push_back(workload);
+		result.checksum = (double)endHits + (double)substepHits + (double)sweptHits;
+		return result;
+	}
+
+	BenchResult benchKernels(const MicroOptions& options)
+	{
+		std::mt19937 rng(options.seed);
+		std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+		// Candidate pairs as a broadphase hands them over: near each other, about half touching.
+		size_t count = (size_t)options.count;
+		std::vector<float> boxFields[8], circleFields[6];
+		for (std::vector<float>& field : boxFields)
+			field.resize(count);
+		for (std::vector<float>& field : circleFields)
+			field.resize(count);
+		for (size_t i = 0; i < count; i++)
+		{
+			float x = unit(rng) * 1000.0f, y = unit(rng) * 1000.0f;
+			float w = 8.0f + unit(rng) * 92.0f, h = 8.0f + unit(rng) * 92.0f;
+			float otherX = x + (unit(rng) * 2.0f - 1.0f) * 100.0f, otherY = y + (unit(rng) * 2.0f - 1.0f) * 100.0f;
+			float otherW = 8.0f + unit(rng) * 92.0f, otherH = 8.0f + unit(rng) * 92.0f;
+			boxFields[0][i] = x;
+			boxFields[1][i] = y;
+			boxFields[2][i] = x + w;
+			boxFields[3][i] = y + h;
+			boxFields[4][i] = otherX;
+			boxFields[5][i] = otherY;
+			boxFields[6][i] = otherX + otherW;
+			boxFields[7][i] = otherY + otherH;
+			circleFields[0][i] = x;
+			circleFields[1][i] = y;
+			circleFields[2][i] = w * 0.5f;
+			circleFields[3][i] = otherX;
+			circleFields[4][i] = otherY;
+			circleFields[5][i] = otherW * 0.5f;
+		}
+		BoxArrays boxA = { boxFields[0].data(), boxFields[1].data(), boxFields[2].data(), boxFields[3].data() };
+		BoxArrays boxB = { boxFields[4].data(), boxFields[5].data(), boxFields[6].data(), boxFields[7].data() };
+		CircleArrays circleA = { circleFields[0].data(), circleFields[1].data(), circleFields[2].data() };
+		CircleArrays circleB = { circleFields[3].data(), circleFields[4].data(), circleFields[5].data() };
+
+		// Levels this CPU can't run come back as a lower one; skip those.
+		std::vector<const CollisionKernels*> levels;
+		for (SimdLevel level : { SimdLevel::Scalar, SimdLevel::SSE2, SimdLevel::AVX2 })
+		{
+			const CollisionKernels& kernels = collisionKernels(level);
+			if (kernels.level == level)
+				levels.push_back(&kernels);
+		}
+
+		BenchResult result;
+		result.name = "kernels";
+		std::vector<uint32_t> overlapping(count);
+		Workload boxes = { "boxes_" + std::to_string(count), {}, {}, {} };
+		Workload circles = { "circles_" + std::to_string(count), {}, {}, {} };
+		std::vector<size_t> boxHits, circleHits;
+		for (const CollisionKernels* pKernels : levels)
+		{
+			std::string name = simdLevelName(pKernels->level);
+			size_t hits = 0;
+			boxes.variants.push_back({ name, {} });
+			timeTicks(boxes.variants.back(), options.ticks, count, [&]()
+			{
+				hits = pKernels->overlapBoxes(boxA, boxB, count, overlapping.data());
+			});
+			boxHits.push_back(hits);
+			circles.variants.push_back({ name, {} });
+			timeTicks(circles.variants.back(), options.ticks, count, [&]()
+			{
+				hits = pKernels->overlapCircles(circleA, circleB, count, overlapping.data());
+			});
+			circleHits.push_back(hits);
+		}
+
+		for (Workload* pWorkload : { &boxes, &circles })
+		{
+			for (const Variant& variant : pWorkload->variants)
+			{
+				double ns = variant.nsPerItem.percentile(50);
+				pWorkload->extras.push_back({ variant.name + "_mpairs_per_s", ns > 0.0 ? 1000.0 / ns : 0.0 });
+			}
+		}
+		boxes.extras.push_back({ "overlap_rate", (double)boxHits[0] / count });
+		circles.extras.push_back({ "overlap_rate", (double)circleHits[0] / count });
+		result.workloads.push_back(boxes);
+		result.workloads.push_back(circles);
+
+		// Every level has to agree with the scalar one.
+		double checksum = 0.0;
+		for (size_t i = 1; i < levels.size(); i++)
+			checksum += std::abs((double)boxHits[i] - (double)boxHits[0]) + std::abs((double)circleHits[i] - (double)circleHits[0]);
+		result.checksum = checksum;
+		return result;
+	}
+
+	BenchResult benchFragments(const MicroOptions& options)
+	{
+		// Big into three medium, medium into two small, small into two tiny, tiny into nothing.
+		std::vector<MeteorKind> kinds(4);
+		const float sizes[] = { 98.0f, 43.0f, 28.0f, 18.0f };
+		const int pieces[] = { 3, 2, 2, 0 };
+		for (int i = 0; i < 4; i++)
+		{
+			kinds[i].w = kinds[i].h = Real(sizes[i]);
+			kinds[i].pieces = pieces[i];
+			kinds[i].pieceKind = i + 1 < 4 ? i + 1 : -1;
+		}
+
+		const size_t bigCount = std::max<size_t>((size_t)options.count / 12, 1);
+		const size_t capacity = bigCount * 12; // all the tiny pieces at once
+		const size_t items = bigCount * (1 + 3 + 6 + 12);
+		std::mt19937 rng(options.seed);
+		std::uniform_real_distribution<float> position(0.0f, 4096.0f);
+		std::uniform_real_distribution<float> velocity(-60.0f, 60.0f);
+
+		// Breaks every meteor in store, four times over, from a fresh set of big ones.
+		size_t created = 0;
+		auto breakAll = [&](EntityStore& store, Fragmenter& fragmenter)
+		{
+			store.clear();
+			for (size_t i = 0; i < bigCount; i++)
+			{
+				store.create();
+				store.sprite[i] = 0;
+				store.w[i] = store.h[i] = Real(sizes[0]);
+				store.x[i] = store.prevX[i] = Real(position(rng));
+				store.y[i] = store.prevY[i] = Real(position(rng));
+				store.vx[i] = Real(velocity(rng));
+				store.vy[i] = Real(velocity(rng));
+			}
+			for (int step = 0; step < 4; step++)
+			{
+				for (size_t i = 0; i < store.size(); i++)
+					fragmenter.queue((uint32_t)i, Real(velocity(rng)), Real(velocity(rng)));
+				created += fragmenter.apply(store);
+			}
+		};
+
+		BenchResult result;
+		result.name = "fragments";
+		Workload workload = { "chain_" + std::to_string(bigCount), { { "growing", {} }, { "pooled", {} } }, {}, {} };
+
+		// The queue is sized either way; only the store differs.
+		size_t growingAllocations = 0, pooledAllocations = 0;
+		EntityStore sizingStore;
+		Fragmenter growingFragmenter(kinds, options.seed);
+		growingFragmenter.reserve(sizingStore, capacity);
+		timeTicks(workload.variants[0], options.ticks, items, [&]()
+		{
+			size_t before = allocationCount;
+			EntityStore store;
+			breakAll(store, growingFragmenter);
+			growingAllocations += allocationCount - before;
+		});
+
+		EntityStore pool;
+		Fragmenter pooledFragmenter(kinds, options.seed);
+		pooledFragmenter.reserve(pool, capacity);
+		timeTicks(workload.variants[1], options.ticks, items, [&]()
+		{
+			size_t before = allocationCount;
+			breakAll(pool, pooledFragmenter);
+			pooledAllocations += allocationCount - before;
+		});
+
+		workload.extras.push_back({ "growing_allocations_per_run", (double)growingAllocations / options.ticks });
+		workload.checks.push_back({ "pooled_allocations_per_run", (double)pooledAllocations / options.ticks });
+		workload.extras.push_back({ "dropped", (double)(growingFragmenter.droppedCount() + pooledFragmenter.droppedCount()) });
+		result.workloads.push_back(workload);
+		result.checksum = (double)created;
+		return result;
+	}
+
+	BenchResult benchBlit(const MicroOptions& options)
+	{
+		std::mt19937 rng(options.seed);
+		size_t count = (size_t)options.count;
+
+		// Sprite rows are runs: clear around the edges, solid in the middle, soft in between.
+		std::vector<uint32_t> source(count), destination(count);
+		for (size_t i = 0; i < count;)
+		{
+			size_t run = std::min<size_t>(1 + rng() % 32, count - i);
+			uint32_t kind = rng() % 5;
+			for (size_t end = i + run; i < end; i++)
+			{
+				uint32_t color = rng() & 0x00FFFFFF;
+				uint32_t alpha = kind < 2 ? 0 : kind < 4 ? 255 : 1 + rng() % 254;
+				source[i] = alpha << 24 | color;
+			}
+		}
+		for (uint32_t& pixel : destination)
+			pixel = 0xFF000000 | (rng() & 0x00FFFFFF);
+		const uint32_t tint = 0xFFE0C0FF;
+
+		std::vector<const BlitKernels*> levels;
+		for (SimdLevel level : { SimdLevel::Scalar, SimdLevel::SSE2, SimdLevel::AVX2 })
+		{
+			const BlitKernels& kernels = blitKernels(level);
+			if (kernels.level == level)
+				levels.push_back(&kernels);
+		}
+
+		struct Operation
+		{
+			const char* name;
+			BlitKernel BlitKernels::*kernel;
+		};
+		const Operation operations[] = {
+			{ "copy", &BlitKernels::copy },
+			{ "blend", &BlitKernels::blend },
+			{ "add", &BlitKernels::add },
+			{ "modulate", &BlitKernels::modulate },
+			{ "masked_copy", &BlitKernels::maskedCopy },
+		};
+
+		BenchResult result;
+		result.name = "blit";
+		std::vector<uint32_t> target(count), expected(count);
+		double mismatched = 0.0;
+		for (const Operation& operation : operations)
+		{
+			// The timed runs draw over their own output; only the first pass is compared.
+			Workload workload = { std::string(operation.name) + "_" + std::to_string(count), {}, {}, {} };
+			size_t mismatch = 0;
+			for (const BlitKernels* pKernels : levels)
+			{
+				BlitKernel kernel = pKernels->*operation.kernel;
+				target = destination;
+				kernel(target.data(), source.data(), count, tint);
+				if (pKernels == levels[0])
+					expected = target;
+				for (size_t i = 0; i < count; i++)
+					mismatch += target[i] != expected[i];
+
+				workload.variants.push_back({ simdLevelName(pKernels->level), {} });
+				timeTicks(workload.variants.back(), options.ticks, count, [&]()
+				{
+					kernel(target.data(), source.data(), count, tint);
+				});
+			}
+			for (const Variant& variant : workload.variants)
+			{
+				double ns = variant.nsPerItem.percentile(50);
+				workload.extras.push_back({ variant.name + "_mpixels_per_s", ns > 0.0 ? 1000.0 / ns : 0.0 });
+			}
+			workload.checks.push_back({ "mismatch", (double)mismatch });
+			mismatched += mismatch;
+			result.workloads.push_back(workload);
+		}
+
+		// Whole sprites with the best kernels: blending every row of the box against
+		// drawing only the sprite's runs, for discs that cover less and less of it. The
+		// time per box pixel with runs should shrink with the coverage.
+		const BlitKernels& best = blitKernels();
+		const int side = 64;
+		const size_t boxPixels = (size_t)side * side;
+		size_t draws = std::max<size_t>(1, count / boxPixels);
+		std::vector<uint32_t> sprite(boxPixels), canvas(boxPixels), byRows, byRuns;
+		for (uint32_t& pixel : canvas)
+			pixel = 0xFF000000 | (rng() & 0x00FFFFFF);
+		for (float radius : { 32.0f, 24.0f, 16.0f, 8.0f })
+		{
+			// Solid inside, a one-pixel soft edge, clear outside.
+			for (int y = 0; y < side; y++)
+			{
+				for (int x = 0; x < side; x++)
+				{
+					float distance = std::hypot(x + 0.5f - side * 0.5f, y + 0.5f - side * 0.5f);
+					float cover = std::min(1.0f, std::max(0.0f, radius - distance));
+					sprite[(size_t)y * side + x] = (uint32_t)std::lround(cover * 255.0f) << 24 | (rng() & 0x00FFFFFF);
+				}
+			}
+			SpriteRuns runs;
+			runs.build(sprite.data(), side, side, side * (int)sizeof(uint32_t));
+			double coverage = (double)runs.coveredPixels() / boxPixels;
+
+			auto drawRows = [&](std::vector<uint32_t>& target)
+			{
+				for (int y = 0; y < side; y++)
+					best.blend(target.data() + (size_t)y * side, sprite.data() + (size_t)y * side, side, 0xFFFFFFFF);
+			};
+			auto drawRuns = [&](std::vector<uint32_t>& target)
+			{
+				for (int y = 0; y < side; y++)
+					runs.drawRow(target.data() + (size_t)y * side, sprite.data() + (size_t)y * side, y, 0, side, best.copy, best.blend, 0xFFFFFFFF);
+			};
+			byRows = canvas;
+			byRuns = canvas;
+			drawRows(byRows);
+			drawRuns(byRuns);
+			size_t mismatch = 0;
+			for (size_t i = 0; i < boxPixels; i++)
+				mismatch += byRows[i] != byRuns[i];
+
+			Workload workload = { "sprite_" + std::to_string((int)std::lround(coverage * 100.0)) + "pct", {}, {}, {} };
+			workload.variants.push_back({ "rows", {} });
+			timeTicks(workload.variants.back(), options.ticks, draws * boxPixels, [&]()
+			{
+				for (size_t i = 0; i < draws; i++)
+					drawRows(byRows);
+			});
+			workload.variants.push_back({ "runs", {} });
+			timeTicks(workload.variants.back(), options.ticks, draws * boxPixels, [&]()
+			{
+				for (size_t i = 0; i < draws; i++)
+					drawRuns(byRuns);
+			});
+			workload.extras.push_back({ "coverage", coverage });
+			workload.checks.push_back({ "mismatch", (double)mismatch });
+			mismatched += mismatch;
+			result.workloads.push_back(workload);
+		}
+		result.checksum = mismatched;
+		return result;
+	}
+
+	struct Bench
+	{
+		const char* name;
+		BenchResult (*run)(const MicroOptions&);
+	};
+
+	const Bench benches[] = {
+		{ "entities", benchEntities },
+		{ "broadphase", benchBroadphase },
+		{ "masks", benchMasks },
+		{ "sweep", benchSweep },
+		{ "kernels", benchKernels },
+		{ "fragments", benchFragments },
+		{ "blit", benchBlit },
+	};
+
+	void printUsage()
+	{
+		std::cerr << "usage: SDLGame_microbench [--bench <name>|all] [--count N] [--ticks N] [--seed N] [--out report.json]\n"
+			"benches:";
+		for (const Bench& bench : benches)
+			std::cerr << " " << bench.name;
+		std::cerr << "\n";
+	}
+
+	bool parseOptions(int argc, char* args[], MicroOptions& options)
+	{
+		for (int i = 1; i < argc; i++)
+		{
+			const char* arg = args[i];
+			const char* value = i + 1 < argc ? args[i + 1] : nullptr;
+			if (value == nullptr)
+				return false;
+
+			if (strcmp(arg, "--bench") == 0)
+				options.bench = value;
+			else if (strcmp(arg, "--count") == 0)
+				options.count = atoi(value);
+			else if (strcmp(arg, "--ticks") == 0)
+				options.ticks = atoi(value);
+			else if (strcmp(arg, "--seed") == 0)
+				options.seed = (unsigned int)strtoul(value, nullptr, 10);
+			else if (strcmp(arg, "--out") == 0)
+				options.outPath = value;
+			else
+				return false;
+			i++;
+		}
+		return options.count > 0 && options.ticks > 0;
+	}
+
+	void writeReport(std::ostream& out, const MicroOptions& options, const std::vector<BenchResult>& results)
+	{
+		out << "{\n";
+		out << "  \"count\": " << options.count << ",\n";
+		out << "  \"ticks\": " << options.ticks << ",\n";
+		out << "  \"seed\": " << options.seed << ",\n";
+		out << "  \"benches\": [\n";
+		for (size_t b = 0; b < results.size(); b++)
+		{
+			const BenchResult& result = results[b];
+			out << "    {\n";
+			out << "      \"name\": " << jsonString(result.name) << ",\n";
+			out << "      \"checksum\": " << result.checksum << ",\n";
+			out << "      \"workloads\": [\n";
+			for (size_t w = 0; w < result.workloads.size(); w++)
+			{
+				const Workload& workload = result.workloads[w];
+				out << "        {\"name\": " << jsonString(workload.name);
+				for (const Variant& variant : workload.variants)
+				{
+					out << ", " << jsonString(variant.name + "_ns") << ": ";
+					variant.nsPerItem.writeJson(out);
+				}
+				// Speedup of every variant over the first one, by median.
+				for (size_t v = 1; v < workload.variants.size(); v++)
+				{
+					double baseline = workload.variants[0].nsPerItem.percentile(50);
+					double median = workload.variants[v].nsPerItem.percentile(50);
+					out << ", " << jsonString(workload.variants[v].name + "_speedup") << ": " << (median > 0.0 ? baseline / median : 0.0);
+				}
+				for (const auto& extra : workload.extras)
+					out << ", " << jsonString(extra.first) << ": " << extra.second;
+				for (const auto& check : workload.checks)
+					out << ", " << jsonString(check.first) << ": " << check.second;
+				out << "}" << (w + 1 < result.workloads.size() ? "," : "") << "\n";
+			}
+			out << "      ]\n";
+			out << "    }" << (b + 1 < results.size() ? "," : "") << "\n";
+		}
+		out << "  ]\n";
+		out << "}\n";
+	}
+
+	// Reports every check that isn't 0 and returns how many there were.
+	int countFailedChecks(const std::vector<BenchResult>& results)
+	{
+		int failed = 0;
+		for (const BenchResult& result : results)
+		{
+			for (const Workload& workload : result.workloads)
+			{
+				for (const auto& check : workload.checks)
+				{
+					if (check.second == 0.0)
+						continue;
+					std::cerr << result.name << "/" << workload.name << ": " << check.first << " is " << check.second << ", should be 0\n";
+					failed++;
+				}
+			}
+		}
+		return failed;
+	}
+}
+
+int main(int argc, char* args[])
+{
+	MicroOptions options;
+	if (!parseOptions(argc, args, options))
+	{
+		printUsage();
+		return 1;
+	}
+
+	std::vector<BenchResult> results;
+	for (const Bench& bench : benches)
+	{
+		if (options.bench == "all" || options.bench == bench.name)
+			results.push_back(bench.run(options));
+	}
+	if (results.empty())
+	{
+		std::cerr << "unknown bench: " << options.bench << "\n";
+		printUsage();
+		return 1;
+	}
+
+	std::ostringstream report;
+	writeReport(report, options, results);
+	std::cout << report.str();
+	if (!options.outPath.empty())
+		std::ofstream(options.outPath) << report.str();
+	return countFailedChecks(results) > 0 ? 1 : 0;
+}
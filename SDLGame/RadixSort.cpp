@@ -0,0 +1,57 @@
+#include "RadixSort.h"
+#include <cstring>
+
+void radixSortByHighWord(std::vector<uint64_t>& items, std::vector<uint64_t>& scratch)
+{
+	const size_t count = items.size();
+	if (count < 2)
+		return;
+
+	// One pass over the data builds the histograms for all four key bytes.
+	size_t histograms[4][256];
+	memset(histograms, 0, sizeof(histograms));
+	for (uint64_t item : items)
+	{
+		uint32_t key = (uint32_t)(item >> 32);
+		histograms[0][key & 0xFF]++;
+		histograms[1][(key >> 8) & 0xFF]++;
+		histograms[2][(key >> 16) & 0xFF]++;
+		histograms[3][key >> 24]++;
+	}
+
+	scratch.resize(count);
+	uint64_t* pSource = items.data();
+	uint64_t* pDest = scratch.data();
+
+	for (int pass = 0; pass < 4; pass++)
+	{
+		size_t* histogram = histograms[pass];
+		int shift = 32 + pass * 8;
+
+		// Every item has the same byte here: this pass wouldn't move anything.
+		if (histogram[(pSource[0] >> shift) & 0xFF] == count)
+			continue;
+
+		size_t offset = 0;
+		for (int bucket = 0; bucket < 256; bucket++)
+		{
+			size_t bucketCount = histogram[bucket];
+			histogram[bucket] = offset;
+			offset += bucketCount;
+		}
+
+		for (size_t i = 0; i < count; i++)
+		{
+			uint64_t item = pSource[i];
+			pDest[histogram[(item >> shift) & 0xFF]++] = item;
+		}
+
+		uint64_t* pTemp = pSource;
+		pSource = pDest;
+		pDest = pTemp;
+	}
+
+	// An odd number of passes leaves the result in scratch.
+	if (pSource != items.data())
+		items.swap(scratch);
+}
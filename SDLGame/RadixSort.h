@@ -0,0 +1,11 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+// Stable LSD radix sort of 64-bit items by their high 32 bits.
+// The low 32 bits are carried along untouched, which is handy for packing a sort
+// key and an array index into one item: (uint64_t)key << 32 | index.
+// Byte passes where every item has the same byte are skipped, so keys that only
+// use a few distinct bits sort in one or two passes.
+// scratch is resized as needed and can be reused between calls to avoid allocating.
+void radixSortByHighWord(std::vector<uint64_t>& items, std::vector<uint64_t>& scratch);
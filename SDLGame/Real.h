@@ -0,0 +1,62 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include "Fixed.h"
+
+// The number type of the simulation: positions, velocities, angles, timers. float,
+// unless SDLGAME_FIXED_POINT is defined (cmake -DSDLGAME_FIXED_POINT=ON), when it is
+// Fixed and a run gives the same bits with every compiler and optimisation level, for
+// replays, lockstep and benchmarks. SDLGame_bench reports a checksum of the state to
+// compare builds by.
+//
+// Simulation code uses the functions below instead of <cmath> and <random>, and
+// Real(...) for constants, so it compiles either way. Drawing and the float collision
+// code take toFloat() of it.
+#ifdef SDLGAME_FIXED_POINT
+using Real = Fixed;
+#else
+using Real = float;
+#endif
+
+inline float toFloat(float value) { return value; }
+inline float toFloat(Fixed value) { return value.toFloat(); }
+
+inline int floorToInt(float value) { return (int)std::floor(value); }
+inline int floorToInt(Fixed value) { return value.floor(); }
+
+inline float sinDegrees(float degrees) { return std::sin(degrees * (3.14159265f / 180.0f)); }
+inline float cosDegrees(float degrees) { return std::cos(degrees * (3.14159265f / 180.0f)); }
+inline float length(float x, float y) { return std::sqrt(x * x + y * y); }
+
+// For the float collision code. In fixed point it reads the same tables as
+// sinDegrees(Fixed), so rotated tests agree between builds as well.
+inline void sinCosDegrees(float degrees, float& s, float& c)
+{
+#ifdef SDLGAME_FIXED_POINT
+	Fixed angle(degrees);
+	s = sinDegrees(angle).toFloat();
+	c = cosDegrees(angle).toFloat();
+#else
+	s = sinDegrees(degrees);
+	c = cosDegrees(degrees);
+#endif
+}
+
+// Uniform in [lo, hi). The std distributions give different numbers with each standard
+// library; these give the same ones everywhere for the same seed.
+inline float randomReal(std::mt19937& rng, float lo, float hi)
+{
+	return lo + (hi - lo) * ((float)(rng() >> 8) * (1.0f / 16777216.0f));
+}
+
+inline Fixed randomReal(std::mt19937& rng, Fixed lo, Fixed hi)
+{
+	return lo + Fixed::fromRaw((int32_t)(((int64_t)(hi - lo).raw * (rng() >> 16)) >> 16));
+}
+
+// Uniform in [0, count).
+inline int randomBelow(std::mt19937& rng, int count)
+{
+	return (int)(((uint64_t)rng() * (uint32_t)count) >> 32);
+}
@@ -0,0 +1,146 @@
+#include "RectPacker.h"
+#include <algorithm>
+#include <climits>
+#include <numeric>
+
+namespace
+{
+	bool contains(const MaxRectsBin::Rect& outer, const MaxRectsBin::Rect& inner)
+	{
+		return inner.x >= outer.x && inner.y >= outer.y && inner.x + inner.w <= outer.x + outer.w && inner.y + inner.h <= outer.y + outer.h;
+	}
+}
+
+MaxRectsBin::MaxRectsBin(int width, int height) : binWidth(width), binHeight(height)
+{
+	freeRects.push_back({ 0, 0, width, height });
+}
+
+bool MaxRectsBin::insert(int w, int h, Rect& placed)
+{
+	int bestShortSide = INT_MAX;
+	int bestLongSide = INT_MAX;
+	const Rect* pBest = nullptr;
+
+	for (const Rect& free : freeRects)
+	{
+		if (free.w < w || free.h < h)
+			continue;
+
+		int leftoverX = free.w - w;
+		int leftoverY = free.h - h;
+		int shortSide = std::min(leftoverX, leftoverY);
+		int longSide = std::max(leftoverX, leftoverY);
+		if (shortSide < bestShortSide || (shortSide == bestShortSide && longSide < bestLongSide))
+		{
+			bestShortSide = shortSide;
+			bestLongSide = longSide;
+			pBest = &free;
+		}
+	}
+
+	if (pBest == nullptr)
+		return false;
+
+	placed = { pBest->x, pBest->y, w, h };
+	splitFreeRects(placed);
+	pruneFreeRects();
+
+	maxRight = std::max(maxRight, placed.x + w);
+	maxBottom = std::max(maxBottom, placed.y + h);
+	usedArea += (long long)w * h;
+	return true;
+}
+
+float MaxRectsBin::occupancy() const
+{
+	long long area = (long long)maxRight * maxBottom;
+	return area > 0 ? (float)usedArea / area : 0.0f;
+}
+
+void MaxRectsBin::splitFreeRects(const Rect& used)
+{
+	newFreeRects.clear();
+	for (const Rect& free : freeRects)
+	{
+		bool overlaps = used.x < free.x + free.w && used.x + used.w > free.x && used.y < free.y + free.h && used.y + used.h > free.y;
+		if (!overlaps)
+		{
+			newFreeRects.push_back(free);
+			continue;
+		}
+
+		// Up to four maximal rectangles survive around the used one.
+		if (used.x > free.x)
+			newFreeRects.push_back({ free.x, free.y, used.x - free.x, free.h });
+		if (used.x + used.w < free.x + free.w)
+			newFreeRects.push_back({ used.x + used.w, free.y, free.x + free.w - (used.x + used.w), free.h });
+		if (used.y > free.y)
+			newFreeRects.push_back({ free.x, free.y, free.w, used.y - free.y });
+		if (used.y + used.h < free.y + free.h)
+			newFreeRects.push_back({ free.x, used.y + used.h, free.w, free.y + free.h - (used.y + used.h) });
+	}
+	freeRects.swap(newFreeRects);
+}
+
+void MaxRectsBin::pruneFreeRects()
+{
+	// Drop free rectangles that are inside another one.
+	for (size_t i = 0; i < freeRects.size(); i++)
+	{
+		for (size_t j = i + 1; j < freeRects.size(); j++)
+		{
+			if (contains(freeRects[j], freeRects[i]))
+			{
+				freeRects.erase(freeRects.begin() + i);
+				i--;
+				break;
+			}
+			if (contains(freeRects[i], freeRects[j]))
+			{
+				freeRects.erase(freeRects.begin() + j);
+				j--;
+			}
+		}
+	}
+}
+
+PackedBins packRects(const std::vector<PackInput>& inputs, int maxWidth, int maxHeight)
+{
+	PackedBins packed;
+	packed.placements.resize(inputs.size());
+
+	// Largest first: big rectangles are the hard ones, small ones fill the gaps.
+	std::vector<size_t> order(inputs.size());
+	std::iota(order.begin(), order.end(), 0);
+	std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b)
+	{
+		int sideA = std::max(inputs[a].w, inputs[a].h);
+		int sideB = std::max(inputs[b].w, inputs[b].h);
+		if (sideA != sideB)
+			return sideA > sideB;
+		return inputs[a].w * inputs[a].h > inputs[b].w * inputs[b].h;
+	});
+
+	for (size_t index : order)
+	{
+		const PackInput& input = inputs[index];
+		PackResult& result = packed.placements[index];
+		if (input.w > maxWidth || input.h > maxHeight)
+			continue;
+
+		MaxRectsBin::Rect placed;
+		for (size_t bin = 0; bin < packed.bins.size() && result.bin < 0; bin++)
+		{
+			if (packed.bins[bin].insert(input.w, input.h, placed))
+				result = { (int)bin, placed.x, placed.y };
+		}
+		if (result.bin < 0)
+		{
+			packed.bins.emplace_back(maxWidth, maxHeight);
+			packed.bins.back().insert(input.w, input.h, placed);
+			result = { (int)packed.bins.size() - 1, placed.x, placed.y };
+		}
+	}
+	return packed;
+}
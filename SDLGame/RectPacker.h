@@ -0,0 +1,66 @@
+#pragma once
+#include <vector>
+
+// MaxRects bin packer (Jukka Jylänki's "best short side fit" variant).
+// Keeps a list of maximal free rectangles for one bin; each insert picks the
+// free rectangle that leaves the smallest leftover on its short side, then
+// splits every free rectangle the new one overlaps. No rotation: SDL can't
+// draw a rotated sub-rectangle back upright for free.
+class MaxRectsBin
+{
+public:
+	struct Rect
+	{
+		int x, y, w, h;
+	};
+
+	MaxRectsBin(int width, int height);
+
+	// Places a w x h rectangle. Returns false if it doesn't fit anywhere.
+	bool insert(int w, int h, Rect& placed);
+
+	int width() const { return binWidth; }
+	int height() const { return binHeight; }
+
+	// Smallest width/height that still contains everything placed so far.
+	int usedWidth() const { return maxRight; }
+	int usedHeight() const { return maxBottom; }
+
+	// Fraction of the used area covered by placed rectangles.
+	float occupancy() const;
+
+private:
+	void splitFreeRects(const Rect& used);
+	void pruneFreeRects();
+
+	int binWidth;
+	int binHeight;
+	int maxRight = 0;
+	int maxBottom = 0;
+	long long usedArea = 0;
+	std::vector<Rect> freeRects;
+	std::vector<Rect> newFreeRects;
+};
+
+// Packs many rectangles into as few bins of at most maxWidth x maxHeight as possible.
+// Rectangles are placed largest first. Each input gets its bin index and position;
+// an input that is bigger than a whole bin gets bin -1.
+struct PackInput
+{
+	int w, h;
+};
+
+struct PackResult
+{
+	int bin = -1;
+	int x = 0;
+	int y = 0;
+};
+
+struct PackedBins
+{
+	std::vector<PackResult> placements; // one per input, same order
+	std::vector<MaxRectsBin> bins;
+};
+
+PackedBins packRects(const std::vector<PackInput>& inputs, int maxWidth, int maxHeight);
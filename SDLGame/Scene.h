@@ -0,0 +1,31 @@
+#pragma once
+#include <cstdint>
+#include "SceneSnapshot.h"
+
+// A scene owns a set of game objects, moves them and draws them.
+// The game runs one scene at a time; the benchmark drives them by name.
+class Scene
+{
+public:
+	virtual ~Scene() = default;
+
+	virtual const char* name() const = 0;
+
+	// Advance the simulation by one fixed tick of tickSeconds.
+	virtual void tick(float tickSeconds) = 0;
+
+	// Add the scene's sprites as of the previous tick and the latest one to snapshot,
+	// which draws them blended between the two.
+	virtual void capture(SceneSnapshot& snapshot) const = 0;
+
+	// Number of live objects, reported by the benchmark.
+	virtual int entityCount() const = 0;
+
+	// Pairs of objects touching in the latest tick, reported by the benchmark.
+	virtual int contactCount() const { return 0; }
+
+	// Hash of the simulation state after the latest tick. Runs with the same config
+	// match tick for tick; built with SDLGAME_FIXED_POINT (see Real.h) they match
+	// between compilers and optimisation levels too.
+	virtual uint64_t checksum() const = 0;
+};
@@ -0,0 +1,33 @@
+#include "SceneSnapshot.h"
+
+namespace
+{
+	float blend(float previous, float latest, float alpha)
+	{
+		return previous + (latest - previous) * alpha;
+	}
+}
+
+void SceneSnapshot::draw(SpriteAtlas& atlas) const
+{
+	for (const SnapshotSprite& item : sprites)
+	{
+		SDL_FRect dst;
+		float angle;
+		place(item, dst, angle);
+		// A sprite that couldn't be found is drawn as a plain rectangle.
+		if (item.sprite >= 0)
+			atlas.draw(item.sprite, dst, item.layer, angle);
+		else
+			atlas.batch().drawRect(dst, item.fallbackColor, item.layer);
+	}
+}
+
+void SceneSnapshot::place(const SnapshotSprite& item, SDL_FRect& dst, float& angle) const
+{
+	dst = {
+		blend(item.previous.x, item.latest.x, alpha), blend(item.previous.y, item.latest.y, alpha),
+		blend(item.previous.w, item.latest.w, alpha), blend(item.previous.h, item.latest.h, alpha),
+	};
+	angle = blend(item.previousAngle, item.angle, alpha);
+}
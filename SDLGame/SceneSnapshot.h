@@ -0,0 +1,35 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <SDL.h>
+#include "SpriteAtlas.h"
+
+// A sprite as a scene wants it drawn: where it was after the previous tick and where
+// it is after the latest one, so drawing can blend between the two.
+struct SnapshotSprite
+{
+	int sprite;               // sprite id, -1 to draw a plain rectangle instead
+	SDL_FRect previous;
+	SDL_FRect latest;
+	float previousAngle;      // degrees
+	float angle;
+	uint8_t layer;
+	SDL_Color fallbackColor;  // the rectangle's colour if sprite is -1
+};
+
+// Everything a scene draws, copied out of it after a tick (Scene::capture). Nothing in
+// it points back into the scene, so one snapshot can be drawn while the scene is busy
+// with its next tick on another thread (SimulationThread).
+struct SceneSnapshot
+{
+	std::vector<SnapshotSprite> sprites;
+	float alpha = 1.0f; // where between the previous tick (0) and the latest one (1) to draw
+
+	void clear() { sprites.clear(); }
+
+	// Queues every sprite with atlas, blended by alpha.
+	void draw(SpriteAtlas& atlas) const;
+
+	// Where item is drawn, blended by alpha.
+	void place(const SnapshotSprite& item, SDL_FRect& dst, float& angle) const;
+};
@@ -0,0 +1,845 @@
+#include "Scenes.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include "Broadphase.h"
+#include "CollisionKernels.h"
+#include "CollisionMask.h"
+#include "CollisionShape.h"
+#include "ContactEvents.h"
+#include "EntityStore.h"
+#include "Fragmenter.h"
+#include "Hash.h"
+#include "Real.h"
+#include "Sweep.h"
+
+namespace
+{
+	// An entity's box after the previous tick and after the latest one, for drawing.
+	void boxesOf(const EntityStore& store, size_t i, SDL_FRect& previous, SDL_FRect& latest)
+	{
+		float w = toFloat(store.w[i]), h = toFloat(store.h[i]);
+		previous = { toFloat(store.prevX[i]), toFloat(store.prevY[i]), w, h };
+		latest = { toFloat(store.x[i]), toFloat(store.y[i]), w, h };
+	}
+
+	// Adds a value's bytes to a checksum.
+	template <typename T>
+	uint64_t hashValue(const T& value, uint64_t hash)
+	{
+		return fnv1a64Words(&value, sizeof(value), hash);
+	}
+
+	// The broadphase config names, or the default one if there's no such backend,
+	// tuned for the sprites in atlas and filtering by the game's layers.
+	std::unique_ptr<Broadphase> createSceneBroadphase(const SceneConfig& config, const SpriteAtlas& atlas)
+	{
+		std::unique_ptr<Broadphase> broadphase = createBroadphase(config.broadphase);
+		if (!broadphase)
+			broadphase = createBroadphase(broadphaseNames().front());
+		broadphase->fitSizes(atlas.spriteSizes());
+		broadphase->setLayers(LayerMatrix::game());
+		return broadphase;
+	}
+
+	// A field of tumbling meteors drifting down the screen and wrapping back to the top.
+	class MeteorFieldScene : public Scene
+	{
+	public:
+		MeteorFieldScene(const SceneConfig& config, SpriteAtlas& atlas) : config(config), rng(config.seed)
+		{
+			const char* names[] = {
+				"Meteors/meteorBrown_big1", "Meteors/meteorBrown_big2", "Meteors/meteorBrown_med1", "Meteors/meteorBrown_small1",
+				"Meteors/meteorBrown_tiny1", "Meteors/meteorGrey_big3", "Meteors/meteorGrey_med2", "Meteors/meteorGrey_small2",
+				"Meteors/meteorGrey_tiny2",
+			};
+			for (const char* name : names)
+			{
+				int sprite = atlas.find(name);
+				sprites.push_back(sprite);
+				masks.push_back(atlas.collisionMask(sprite));
+				shapes.push_back(atlas.collisionShape(sprite));
+				pivots.push_back(sprite >= 0 ? SDL_FPoint{ atlas.frame(sprite).pivotX, atlas.frame(sprite).pivotY } : SDL_FPoint{ 0.5f, 0.5f });
+
+				// How far the rock reaches from its pivot. Without a mask, every size is
+				// made up below, so radii are worked out per meteor instead.
+				const CollisionMask* pMask = masks.back();
+				bool hasMask = pMask != nullptr && !pMask->isEmpty();
+				radii.push_back(hasMask ? pMask->radiusAround(pivots.back().x * pMask->width(), pivots.back().y * pMask->height()) : 0.0f);
+			}
+
+			meteors.reserve(config.entityCount);
+			for (int i = 0; i < config.entityCount; i++)
+			{
+				meteors.create();
+				int variantIndex = randomBelow(rng, (int)sprites.size());
+				int sprite = sprites[variantIndex];
+				Real w = sprite >= 0 ? Real(atlas.frame(sprite).sourceW) : randomReal(rng, Real(8), Real(48));
+				Real h = sprite >= 0 ? Real(atlas.frame(sprite).sourceH) : w;
+				meteors.sprite[i] = variantIndex;
+				meteors.x[i] = meteors.prevX[i] = randomReal(rng, Real(0), Real(config.width));
+				meteors.y[i] = meteors.prevY[i] = randomReal(rng, Real(0), Real(config.height));
+				meteors.w[i] = w;
+				meteors.h[i] = h;
+				meteors.vx[i] = randomReal(rng, Real(-20), Real(20));
+				meteors.vy[i] = randomReal(rng, Real(40), Real(160));
+				meteors.spin[i] = randomReal(rng, Real(-90), Real(90));
+			}
+
+			broadphase = createSceneBroadphase(config, atlas);
+		}
+
+		const char* name() const override { return "meteor-field"; }
+
+		void tick(float tickSeconds) override
+		{
+			meteors.integrate(Real(tickSeconds));
+
+			const Real width = Real(config.width), height = Real(config.height);
+			for (size_t i = 0; i < meteors.size(); i++)
+			{
+				// Wrapping is a teleport: don't interpolate across it.
+				bool wrapped = false;
+				if (meteors.y[i] > height)
+				{
+					meteors.y[i] -= height + meteors.h[i];
+					wrapped = true;
+				}
+				if (meteors.x[i] < -meteors.w[i])
+				{
+					meteors.x[i] += width + meteors.w[i];
+					wrapped = true;
+				}
+				else if (meteors.x[i] > width)
+				{
+					meteors.x[i] -= width + meteors.w[i];
+					wrapped = true;
+				}
+				if (wrapped)
+				{
+					meteors.prevX[i] = meteors.x[i];
+					meteors.prevY[i] = meteors.y[i];
+				}
+			}
+
+			// Meteors pass through each other, but finding where they touch is the
+			// broadphase's worst case: every object moving, everything against everything.
+			broadphase->clear();
+			broadphase->add(meteors, CollisionLayer::Meteor);
+			broadphase->build();
+			broadphase->findPairs(contacts);
+
+			// Round rocks in square boxes: many boxes overlap where the rocks don't. A circle
+			// around each pivot, out to the rock's farthest solid pixel, holds it however it
+			// spins; testing those for every contact at once leaves fewer for the masks.
+			size_t count = contacts.size();
+			for (std::vector<float>& field : pairCircles)
+				field.resize(count);
+			for (size_t i = 0; i < count; i++)
+			{
+				circleOf(contacts[i].a, pairCircles[0][i], pairCircles[1][i], pairCircles[2][i]);
+				circleOf(contacts[i].b, pairCircles[3][i], pairCircles[4][i], pairCircles[5][i]);
+			}
+			CircleArrays circlesA = { pairCircles[0].data(), pairCircles[1].data(), pairCircles[2].data() };
+			CircleArrays circlesB = { pairCircles[3].data(), pairCircles[4].data(), pairCircles[5].data() };
+			circleHits.resize(count);
+			size_t circleCount = collisionKernels().overlapCircles(circlesA, circlesB, count, circleHits.data());
+
+			// circleHits is ascending, so compacting in place never overwrites a contact still to read.
+			size_t kept = 0;
+			for (size_t i = 0; i < circleCount; i++)
+			{
+				const BoxPair contact = contacts[circleHits[i]];
+				if (touching(contact.a, contact.b))
+					contacts[kept++] = contact;
+			}
+			contacts.resize(kept);
+		}
+
+		void capture(SceneSnapshot& snapshot) const override
+		{
+			for (size_t i = 0; i < meteors.size(); i++)
+			{
+				SnapshotSprite item;
+				item.sprite = sprites[meteors.sprite[i]];
+				boxesOf(meteors, i, item.previous, item.latest);
+				item.previousAngle = toFloat(meteors.prevAngle[i]);
+				item.angle = toFloat(meteors.angle[i]);
+				item.layer = 0;
+				item.fallbackColor = { 140, 110, 80, 255 };
+				snapshot.sprites.push_back(item);
+			}
+		}
+
+		int entityCount() const override { return (int)meteors.size(); }
+		int contactCount() const override { return (int)contacts.size(); }
+
+		uint64_t checksum() const override
+		{
+			return hashValue((uint32_t)contacts.size(), meteors.checksum(fnv1a64Seed));
+		}
+
+	private:
+		// Meteors spin, so their masks are compared rotated, four pixels to a cell.
+		static constexpr int maskLevel = 2;
+
+		bool touching(uint32_t i, uint32_t j) const
+		{
+			// Most pairs the circles let through really touch, so running the hulls before
+			// the masks costs more than it saves: it's one or the other.
+			const CollisionShape* pShapeI = shapes[meteors.sprite[i]];
+			const CollisionShape* pShapeJ = shapes[meteors.sprite[j]];
+			if (!config.pixelMasks && pShapeI != nullptr && pShapeJ != nullptr)
+				return CollisionShape::overlaps(*pShapeI, placement(i), *pShapeJ, placement(j));
+
+			const CollisionMask* pMaskI = masks[meteors.sprite[i]];
+			const CollisionMask* pMaskJ = masks[meteors.sprite[j]];
+			if (pMaskI == nullptr || pMaskJ == nullptr || pMaskI->isEmpty() || pMaskJ->isEmpty())
+				return true;
+
+			// The test walks the first mask's cells, so give it the smaller one.
+			if (pMaskI->width() * pMaskI->height() > pMaskJ->width() * pMaskJ->height())
+			{
+				std::swap(i, j);
+				std::swap(pMaskI, pMaskJ);
+			}
+			return CollisionMask::overlapsRotated(*pMaskI, placement(i), *pMaskJ, placement(j), maskLevel);
+		}
+
+		MaskPlacement placement(uint32_t i) const
+		{
+			const SDL_FPoint& pivot = pivots[meteors.sprite[i]];
+			return { toFloat(meteors.x[i]), toFloat(meteors.y[i]), toFloat(meteors.angle[i]), pivot.x, pivot.y };
+		}
+
+		void circleOf(uint32_t i, float& x, float& y, float& radius) const
+		{
+			const SDL_FPoint& pivot = pivots[meteors.sprite[i]];
+			x = toFloat(meteors.x[i]) + toFloat(meteors.w[i]) * pivot.x;
+			y = toFloat(meteors.y[i]) + toFloat(meteors.h[i]) * pivot.y;
+			radius = radii[meteors.sprite[i]];
+			if (radius == 0.0f)
+			{
+				// No mask: out to the farthest corner of the box.
+				float reachX = toFloat(meteors.w[i]) * std::max(pivot.x, 1.0f - pivot.x);
+				float reachY = toFloat(meteors.h[i]) * std::max(pivot.y, 1.0f - pivot.y);
+				radius = std::sqrt(reachX * reachX + reachY * reachY);
+			}
+		}
+
+		SceneConfig config;
+		std::mt19937 rng;
+		std::vector<int> sprites; // sprite ids, -1 if missing
+		std::vector<const CollisionMask*> masks;   // by index into sprites, null if missing
+		std::vector<const CollisionShape*> shapes; // likewise
+		std::vector<SDL_FPoint> pivots;            // likewise
+		std::vector<float> radii;                  // likewise, 0 if there's no mask
+		EntityStore meteors;      // sprite holds an index into sprites
+		std::unique_ptr<Broadphase> broadphase;
+		std::vector<BoxPair> contacts;
+		std::vector<float> pairCircles[6]; // per contact: x, y and radius of a, then of b
+		std::vector<uint32_t> circleHits;
+	};
+
+	// Emitters along the top of the screen spraying rings of bullets at enemy ships
+	// patrolling below them. Ships absorb the bullets that hit them.
+	class BulletHellScene : public Scene
+	{
+	public:
+		BulletHellScene(const SceneConfig& config, SpriteAtlas& atlas) : config(config), rng(config.seed)
+		{
+			const char* names[] = { "Lasers/laserRed10", "Lasers/laserBlue10", "Lasers/laserGreen16" };
+			for (const char* name : names)
+				sprites.push_back(atlas.find(name));
+
+			const char* enemyNames[] = { "Enemies/enemyBlack1", "Enemies/enemyBlue2", "Enemies/enemyGreen3", "Enemies/enemyRed4" };
+			for (const char* name : enemyNames)
+			{
+				enemySprites.push_back(atlas.find(name));
+				enemyMasks.push_back(atlas.collisionMask(enemySprites.back()));
+			}
+
+			bullets.reserve(config.entityCount);
+			for (int i = 0; i < enemyCount; i++)
+			{
+				enemies.create();
+				int sprite = enemySprites[i % enemySprites.size()];
+				enemies.sprite[i] = i % (int)enemySprites.size();
+				enemies.w[i] = Real(sprite >= 0 ? atlas.frame(sprite).sourceW : 90);
+				enemies.h[i] = Real(sprite >= 0 ? atlas.frame(sprite).sourceH : 80);
+				enemies.x[i] = enemies.prevX[i] = (Real(config.width) - enemies.w[i]) * (2 * i + 1) / (2 * enemyCount);
+				enemies.y[i] = enemies.prevY[i] = Real(config.height) * Real(i % 2 == 0 ? 0.6f : 0.78f);
+				enemies.vx[i] = Real(i % 2 == 0 ? 60 : -60);
+			}
+
+			broadphase = createSceneBroadphase(config, atlas);
+		}
+
+		const char* name() const override { return "bullet-hell"; }
+
+		void tick(float tickSeconds) override
+		{
+			const Real tick = Real(tickSeconds);
+			const Real width = Real(config.width), height = Real(config.height);
+
+			// Every ring starts about a radian round from the one before, and they all turn
+			// 1.7 radians a second on top of that.
+			ringTurn += tick * Real(97.4f);
+			if (ringTurn >= Real(360))
+				ringTurn -= Real(360);
+
+			// Move bullets and drop the ones that left the screen or expired.
+			bullets.integrate(tick);
+			for (size_t i = 0; i < bullets.size();)
+			{
+				bullets.life[i] -= tick;
+				bool offscreen = bullets.x[i] < -Real(bulletSize) || bullets.x[i] > width || bullets.y[i] < -Real(bulletSize) || bullets.y[i] > height;
+				if (offscreen || bullets.life[i] <= Real(0))
+					bullets.destroyAt(i);
+				else
+					i++;
+			}
+
+			// Ships sweep from side to side.
+			enemies.integrate(tick);
+			for (size_t i = 0; i < enemies.size(); i++)
+			{
+				bool turnRight = enemies.x[i] < Real(0) && enemies.vx[i] < Real(0);
+				bool turnLeft = enemies.x[i] + enemies.w[i] > width && enemies.vx[i] > Real(0);
+				if (turnRight || turnLeft)
+					enemies.vx[i] = -enemies.vx[i];
+			}
+
+			// The layers keep bullets from pairing with each other; adding them first and
+			// ships after means the broadphase doesn't even look at those pairs.
+			broadphase->clear();
+			broadphase->add(bullets, CollisionLayer::PlayerLaser);
+			uint32_t firstEnemy = broadphase->add(enemies, CollisionLayer::Enemy);
+			broadphase->build();
+			broadphase->findPairsBetween(firstEnemy, contacts);
+			contactEvents.collect(*broadphase, contacts);
+
+			// Ships are far from rectangular: a hit has to land on one of their solid pixels.
+			hits.clear();
+			for (const BoxPair& contact : contactEvents.between(CollisionLayer::PlayerLaser, CollisionLayer::Enemy))
+			{
+				uint32_t bullet = contact.a, enemy = contact.b;
+				const CollisionMask* pMask = enemyMasks[enemies.sprite[enemy]];
+				if (pMask && !pMask->isEmpty())
+				{
+					int x0 = floorToInt(bullets.x[bullet] - enemies.x[enemy]);
+					int y0 = floorToInt(bullets.y[bullet] - enemies.y[enemy]);
+					if (!pMask->overlapsRect(x0, y0, x0 + bulletSize, y0 + bulletSize))
+						continue;
+				}
+				hits.push_back(contact);
+			}
+
+			hitBullets.clear();
+			for (const BoxPair& hit : hits)
+				hitBullets.push_back(hit.a);
+			std::sort(hitBullets.begin(), hitBullets.end());
+			hitBullets.erase(std::unique(hitBullets.begin(), hitBullets.end()), hitBullets.end());
+
+			// Highest index first: the bullet destroyAt moves down is never one still to go.
+			for (auto it = hitBullets.rbegin(); it != hitBullets.rend(); ++it)
+				bullets.destroyAt(*it);
+
+			// Fire rings so that roughly entityCount bullets are alive at once.
+			spawnBudget += tick * config.entityCount / bulletLifetime;
+			while (spawnBudget >= Real(ringSize) && (int)bullets.size() + ringSize <= config.entityCount)
+			{
+				int emitter = nextEmitter % emitterCount;
+				Real originX = width * (Real(0.1f) + Real(0.8f) * emitter / (emitterCount - 1));
+				Real originY = height * Real(0.15f);
+				Real spin = ringTurn + Real(nextEmitter % 360 * 57 % 360);
+				Real ringSpeed = randomReal(rng, Real(90), Real(220));
+				int sprite = emitter % (int)sprites.size();
+				for (int i = 0; i < ringSize; i++)
+				{
+					Real angle = spin + Real(360) * i / ringSize;
+					bullets.create();
+					size_t index = bullets.size() - 1;
+					bullets.x[index] = bullets.prevX[index] = originX;
+					bullets.y[index] = bullets.prevY[index] = originY;
+					bullets.w[index] = bullets.h[index] = Real(bulletSize);
+					bullets.vx[index] = cosDegrees(angle) * ringSpeed;
+					bullets.vy[index] = sinDegrees(angle) * ringSpeed;
+					bullets.life[index] = Real(bulletLifetime);
+					bullets.sprite[index] = sprite;
+				}
+				spawnBudget -= Real(ringSize);
+				nextEmitter++;
+			}
+		}
+
+		void capture(SceneSnapshot& snapshot) const override
+		{
+			for (size_t i = 0; i < enemies.size(); i++)
+			{
+				SnapshotSprite item;
+				item.sprite = enemySprites[enemies.sprite[i]];
+				boxesOf(enemies, i, item.previous, item.latest);
+				item.previousAngle = item.angle = 0.0f;
+				item.layer = 0;
+				item.fallbackColor = { 90, 160, 255, 255 };
+				snapshot.sprites.push_back(item);
+			}
+			for (size_t i = 0; i < bullets.size(); i++)
+			{
+				SnapshotSprite item;
+				item.sprite = sprites[bullets.sprite[i]];
+				boxesOf(bullets, i, item.previous, item.latest);
+				item.previousAngle = item.angle = 0.0f;
+				item.layer = 1;
+				item.fallbackColor = { 255, 80, 60, 255 };
+				snapshot.sprites.push_back(item);
+			}
+		}
+
+		int entityCount() const override { return (int)(bullets.size() + enemies.size()); }
+		int contactCount() const override { return (int)hits.size(); }
+
+		uint64_t checksum() const override
+		{
+			uint64_t hash = enemies.checksum(bullets.checksum(fnv1a64Seed));
+			hash = hashValue((uint32_t)hits.size(), hash);
+			return hashValue(spawnBudget, hashValue(ringTurn, hash));
+		}
+
+	private:
+		static constexpr int emitterCount = 8;
+		static constexpr int enemyCount = 6;
+		static constexpr int ringSize = 24;
+		static constexpr int bulletLifetime = 4; // seconds
+		static constexpr int bulletSize = 12;    // pixels
+
+		SceneConfig config;
+		std::mt19937 rng;
+		std::vector<int> sprites; // sprite ids, -1 if missing
+		EntityStore bullets;      // sprite holds an index into sprites
+		std::vector<int> enemySprites;
+		std::vector<const CollisionMask*> enemyMasks; // by index into enemySprites, null if missing
+		EntityStore enemies;      // sprite holds an index into enemySprites
+		std::unique_ptr<Broadphase> broadphase;
+		std::vector<BoxPair> contacts;
+		ContactEvents contactEvents;
+		std::vector<BoxPair> hits;       // (bullet, ship) that really touch
+		std::vector<uint32_t> hitBullets;
+		Real ringTurn = Real(0);  // degrees
+		Real spawnBudget = Real(0);
+		int nextEmitter = 0;
+	};
+
+	// Turrets along the bottom firing laser bolts up into a field of falling meteors.
+	// The bolts cover more than their own length every tick, far more than a tiny
+	// meteor is wide, so hits are found along the path each bolt swept through.
+	class LaserBarrageScene : public Scene
+	{
+	public:
+		LaserBarrageScene(const SceneConfig& config, SpriteAtlas& atlas) : config(config), rng(config.seed)
+		{
+			const char* laserNames[] = { "Lasers/laserBlue01", "Lasers/laserGreen11", "Lasers/laserRed16" };
+			for (const char* name : laserNames)
+			{
+				int sprite = atlas.find(name);
+				laserSprites.push_back(sprite);
+				laserSizes.push_back(sprite >= 0 ? SDL_FPoint{ (float)atlas.frame(sprite).sourceW, (float)atlas.frame(sprite).sourceH } : SDL_FPoint{ 9.0f, 54.0f });
+			}
+
+			// Two chains, each size breaking into the next one down.
+			const char* meteorNames[] = {
+				"Meteors/meteorGrey_big1", "Meteors/meteorGrey_med1", "Meteors/meteorGrey_small1", "Meteors/meteorGrey_tiny1",
+				"Meteors/meteorBrown_big1", "Meteors/meteorBrown_med1", "Meteors/meteorBrown_small1", "Meteors/meteorBrown_tiny1",
+			};
+			const int piecesBySize[sizesPerChain] = { 3, 2, 2, 0 };
+			const float fallbackSizes[sizesPerChain] = { 98.0f, 43.0f, 28.0f, 18.0f };
+			std::vector<MeteorKind> kinds;
+			for (const char* name : meteorNames)
+			{
+				int sprite = atlas.find(name);
+				int size = (int)meteorSprites.size() % sizesPerChain;
+				float fallbackSize = fallbackSizes[size];
+				meteorSprites.push_back(sprite);
+				meteorMasks.push_back(atlas.collisionMask(sprite));
+				meteorPivots.push_back(sprite >= 0 ? SDL_FPoint{ atlas.frame(sprite).pivotX, atlas.frame(sprite).pivotY } : SDL_FPoint{ 0.5f, 0.5f });
+				meteorSizes.push_back(sprite >= 0 ? SDL_FPoint{ (float)atlas.frame(sprite).sourceW, (float)atlas.frame(sprite).sourceH } : SDL_FPoint{ fallbackSize, fallbackSize });
+
+				MeteorKind kind;
+				kind.w = Real(meteorSizes.back().x);
+				kind.h = Real(meteorSizes.back().y);
+				kind.pieces = piecesBySize[size];
+				kind.pieceKind = size + 1 < sizesPerChain ? (int32_t)meteorSprites.size() : -1;
+				kinds.push_back(kind);
+			}
+
+			// Most of the objects are meteors; bolts don't live long enough to be many.
+			// Breaking them can triple that, which the pool has room for.
+			meteorTarget = std::max(config.entityCount - config.entityCount / 8, 1);
+			fragmenter = Fragmenter(std::move(kinds), config.seed);
+			fragmenter.reserve(meteors, (size_t)meteorTarget * 3);
+			for (int i = 0; i < meteorTarget; i++)
+			{
+				Real y = randomReal(rng, Real(0), Real(config.height) * Real(0.8f));
+				spawnMeteor(y, randomBelow(rng, (int)meteorSprites.size()));
+			}
+
+			broadphase = createSceneBroadphase(config, atlas);
+		}
+
+		const char* name() const override { return "laser-barrage"; }
+
+		void tick(float tickSeconds) override
+		{
+			const Real tick = Real(tickSeconds);
+			const Real width = Real(config.width), height = Real(config.height);
+
+			// The turrets sway a radian a second.
+			swayTurn += tick * Real(57.29578f);
+			if (swayTurn >= Real(360))
+				swayTurn -= Real(360);
+
+			meteors.integrate(tick);
+			for (size_t i = 0; i < meteors.size();)
+			{
+				// Pieces knocked up or sideways off the screen are gone; the rest wrap.
+				bool leaving = (meteors.y[i] + meteors.h[i] < Real(0) && meteors.vy[i] < Real(0)) ||
+					(meteors.x[i] + meteors.w[i] < Real(0) && meteors.vx[i] < Real(0)) || (meteors.x[i] > width && meteors.vx[i] > Real(0));
+				if (leaving)
+				{
+					meteors.destroyAt(i);
+					continue;
+				}
+				if (meteors.y[i] > height)
+				{
+					meteors.y[i] = meteors.prevY[i] = -meteors.h[i];
+					meteors.prevX[i] = meteors.x[i];
+				}
+				i++;
+			}
+
+			lasers.integrate(tick);
+			for (size_t i = 0; i < lasers.size();)
+			{
+				if (lasers.y[i] + lasers.h[i] < Real(0) || lasers.x[i] + lasers.w[i] < Real(0) || lasers.x[i] > width)
+					lasers.destroyAt(i);
+				else
+					i++;
+			}
+
+			// Each bolt goes in as the box it swept through this tick, not where it ended
+			// up, so it meets every meteor along the way however fast it flies.
+			broadphase->clear();
+			broadphase->addSwept(lasers, CollisionLayer::PlayerLaser);
+			uint32_t firstMeteor = broadphase->addSwept(meteors, CollisionLayer::Meteor);
+			broadphase->build();
+			broadphase->findPairsBetween(firstMeteor, contacts);
+			contactEvents.collect(*broadphase, contacts);
+
+			// A bolt stops at the first meteor on its path. Ties (a bolt starting inside two
+			// meteors) go to the lower index, whatever order the broadphase found them in.
+			firstHit.assign(lasers.size(), { 2.0f, 0 });
+			for (const BoxPair& contact : contactEvents.between(CollisionLayer::PlayerLaser, CollisionLayer::Meteor))
+			{
+				uint32_t meteor = contact.b;
+				float hitTime;
+				if (!hitAlongPath(contact.a, meteor, hitTime))
+					continue;
+				const LaserHit& best = firstHit[contact.a];
+				if (hitTime < best.time || (hitTime == best.time && meteor < best.meteor))
+					firstHit[contact.a] = { hitTime, meteor };
+			}
+
+			hits.clear();
+			for (uint32_t laser = 0; laser < firstHit.size(); laser++)
+			{
+				if (firstHit[laser].time <= 1.0f)
+					hits.push_back({ laser, firstHit[laser].meteor });
+			}
+
+			// Hit meteors break into smaller ones, knocked along by the bolt. hits is in laser
+			// order, so going backwards destroys the highest index first.
+			for (auto it = hits.rbegin(); it != hits.rend(); ++it)
+			{
+				fragmenter.queue(it->b, lasers.vx[it->a] * Real(knock), lasers.vy[it->a] * Real(knock));
+				lasers.destroyAt(it->a);
+			}
+			fragmenter.apply(meteors);
+
+			// Once the pieces have been shot away too, new big meteors come in from above.
+			for (int i = (int)meteors.size(); i < meteorTarget; i++)
+			{
+				int variant = randomBelow(rng, (int)meteorSprites.size() / sizesPerChain) * sizesPerChain;
+				spawnMeteor(-Real(meteorSizes[variant].y), variant);
+			}
+
+			fire(tick);
+		}
+
+		void capture(SceneSnapshot& snapshot) const override
+		{
+			for (size_t i = 0; i < meteors.size(); i++)
+			{
+				SnapshotSprite item;
+				item.sprite = meteorSprites[meteors.sprite[i]];
+				boxesOf(meteors, i, item.previous, item.latest);
+				item.previousAngle = toFloat(meteors.prevAngle[i]);
+				item.angle = toFloat(meteors.angle[i]);
+				item.layer = 0;
+				item.fallbackColor = { 140, 110, 80, 255 };
+				snapshot.sprites.push_back(item);
+			}
+			for (size_t i = 0; i < lasers.size(); i++)
+			{
+				// Lasers are stored by their rotated bounds; the sprite is drawn upright around the centre.
+				SnapshotSprite item;
+				item.sprite = laserSprites[lasers.sprite[i]];
+				boxesOf(lasers, i, item.previous, item.latest);
+				const SDL_FPoint& size = laserSizes[lasers.sprite[i]];
+				for (SDL_FRect* pBox : { &item.previous, &item.latest })
+					*pBox = { pBox->x + (pBox->w - size.x) * 0.5f, pBox->y + (pBox->h - size.y) * 0.5f, size.x, size.y };
+				item.previousAngle = item.angle = toFloat(lasers.angle[i]);
+				item.layer = 1;
+				item.fallbackColor = { 255, 80, 60, 255 };
+				snapshot.sprites.push_back(item);
+			}
+		}
+
+		int entityCount() const override { return (int)(lasers.size() + meteors.size()); }
+		int contactCount() const override { return (int)hits.size(); }
+
+		uint64_t checksum() const override
+		{
+			uint64_t hash = meteors.checksum(lasers.checksum(fnv1a64Seed));
+			hash = hashValue((uint32_t)hits.size(), hash);
+			return hashValue(fireBudget, hashValue(swayTurn, hash));
+		}
+
+	private:
+		static constexpr int turretCount = 12;
+		static constexpr float fireInterval = 0.05f;   // seconds between bolts from one turret
+		static constexpr float minSpeed = 4800.0f;     // pixels per second: 40 to 120 a tick at 120 Hz
+		static constexpr float maxSpeed = 14400.0f;
+		static constexpr float spreadDegrees = 25.0f;
+		// 4-pixel cells stand in for the bolt's width around its centre line.
+		static constexpr int maskLevel = 2;
+		static constexpr int sizesPerChain = 4;        // big, medium, small, tiny
+		static constexpr float knock = 0.01f;          // share of a bolt's velocity a meteor it hits takes
+
+		struct LaserHit
+		{
+			float time;
+			uint32_t meteor;
+		};
+
+		void spawnMeteor(Real y, int variant)
+		{
+			meteors.create();
+			size_t i = meteors.size() - 1;
+			meteors.sprite[i] = variant;
+			meteors.w[i] = Real(meteorSizes[meteors.sprite[i]].x);
+			meteors.h[i] = Real(meteorSizes[meteors.sprite[i]].y);
+			meteors.x[i] = meteors.prevX[i] = randomReal(rng, Real(0), Real(config.width));
+			meteors.y[i] = meteors.prevY[i] = y;
+			meteors.vx[i] = randomReal(rng, Real(-20), Real(20));
+			meteors.vy[i] = randomReal(rng, Real(30), Real(90));
+			meteors.spin[i] = randomReal(rng, Real(-90), Real(90));
+		}
+
+		void fire(Real tickSeconds)
+		{
+			fireBudget += tickSeconds * Real(turretCount / fireInterval);
+			for (; fireBudget >= Real(1); fireBudget -= Real(1))
+			{
+				int turret = nextTurret++ % turretCount;
+				int sprite = turret % (int)laserSprites.size();
+				Real sizeX = Real(laserSizes[sprite].x), sizeY = Real(laserSizes[sprite].y);
+				Real spread = randomReal(rng, Real(-spreadDegrees), Real(spreadDegrees));
+				Real angle = spread + Real(10) * sinDegrees(swayTurn + Real(turret) * Real(57.29578f));
+				Real dirX = sinDegrees(angle), dirY = -cosDegrees(angle);
+
+				// Stored by the bounds of the rotated bolt, so the broadphase sees all of it.
+				Real absX = dirX < Real(0) ? -dirX : dirX, absY = dirY < Real(0) ? -dirY : dirY;
+				Real boundsW = absY * sizeX + absX * sizeY;
+				Real boundsH = absX * sizeX + absY * sizeY;
+				Real centerX = Real(config.width) * (2 * turret + 1) / (2 * turretCount);
+				Real centerY = Real(config.height) - sizeY / 2;
+				Real boltSpeed = randomReal(rng, Real(minSpeed), Real(maxSpeed));
+
+				lasers.create();
+				size_t i = lasers.size() - 1;
+				lasers.sprite[i] = sprite;
+				lasers.w[i] = boundsW;
+				lasers.h[i] = boundsH;
+				lasers.x[i] = lasers.prevX[i] = centerX - boundsW / 2;
+				lasers.y[i] = lasers.prevY[i] = centerY - boundsH / 2;
+				lasers.vx[i] = dirX * boltSpeed;
+				lasers.vy[i] = dirY * boltSpeed;
+				lasers.angle[i] = lasers.prevAngle[i] = angle;
+			}
+		}
+
+		// Whether the bolt's centre line, from its tail at the start of the tick to its
+		// nose at the end, crosses the meteor. Worked out in the meteor's frame, so the
+		// meteor's own move is taken off the bolt's.
+		bool hitAlongPath(uint32_t laser, uint32_t meteor, float& hitTime) const
+		{
+			// Half the bolt, along the way it flies.
+			Real speed = length(lasers.vx[laser], lasers.vy[laser]);
+			Real halfLength = Real(laserSizes[lasers.sprite[laser]].y) / 2;
+			Real reachX = speed > Real(0) ? lasers.vx[laser] / speed * halfLength : Real(0);
+			Real reachY = speed > Real(0) ? lasers.vy[laser] / speed * halfLength : Real(0);
+			Real tailX = lasers.prevX[laser] + lasers.w[laser] / 2 - reachX;
+			Real tailY = lasers.prevY[laser] + lasers.h[laser] / 2 - reachY;
+			Real noseX = lasers.x[laser] + lasers.w[laser] / 2 + reachX - (meteors.x[meteor] - meteors.prevX[meteor]);
+			Real noseY = lasers.y[laser] + lasers.h[laser] / 2 + reachY - (meteors.y[meteor] - meteors.prevY[meteor]);
+
+			const CollisionMask* pMask = meteorMasks[meteors.sprite[meteor]];
+			if (pMask == nullptr || pMask->isEmpty())
+			{
+				Bounds box = { toFloat(meteors.prevX[meteor]), toFloat(meteors.prevY[meteor]),
+					toFloat(meteors.prevX[meteor] + meteors.w[meteor]), toFloat(meteors.prevY[meteor] + meteors.h[meteor]) };
+				Bounds tail = { toFloat(tailX), toFloat(tailY), toFloat(tailX), toFloat(tailY) };
+				return sweepBounds(tail, toFloat(noseX - tailX), toFloat(noseY - tailY), box, hitTime);
+			}
+			const SDL_FPoint& pivot = meteorPivots[meteors.sprite[meteor]];
+			MaskPlacement place = { toFloat(meteors.prevX[meteor]), toFloat(meteors.prevY[meteor]), toFloat(meteors.angle[meteor]), pivot.x, pivot.y };
+			return pMask->raycast(place, toFloat(tailX), toFloat(tailY), toFloat(noseX), toFloat(noseY), maskLevel, hitTime);
+		}
+
+		SceneConfig config;
+		std::mt19937 rng;
+		std::vector<int> laserSprites;   // sprite ids, -1 if missing
+		std::vector<SDL_FPoint> laserSizes;
+		std::vector<int> meteorSprites;
+		std::vector<const CollisionMask*> meteorMasks; // by index into meteorSprites, null if missing
+		std::vector<SDL_FPoint> meteorPivots;
+		std::vector<SDL_FPoint> meteorSizes;
+		EntityStore lasers;              // sprite holds an index into laserSprites
+		EntityStore meteors;             // sprite holds an index into meteorSprites
+		Fragmenter fragmenter;           // meteor kinds are the indices into meteorSprites
+		int meteorTarget = 0;
+		std::unique_ptr<Broadphase> broadphase;
+		std::vector<BoxPair> contacts;
+		ContactEvents contactEvents;
+		std::vector<LaserHit> firstHit; // by laser
+		std::vector<BoxPair> hits;       // (laser, meteor)
+		Real swayTurn = Real(0);         // degrees
+		Real fireBudget = Real(0);
+		int nextTurret = 0;
+	};
+
+	// A menu screen: a column of buttons over a tiled background, with the cursor moving
+	// to the next button every so often. Nothing else moves, which is what the
+	// dirty-rectangle renderer (DirtyRectRenderer) is for; the game shows it when paused.
+	class MenuScene : public Scene
+	{
+	public:
+		MenuScene(const SceneConfig& config, SpriteAtlas& atlas)
+		{
+			// The background tiles cover the screen, so the buttons and cursor go on layers above.
+			int tile = atlas.find("Backgrounds/darkPurple");
+			float tileW = tile >= 0 ? (float)atlas.frame(tile).sourceW : 256.0f;
+			float tileH = tile >= 0 ? (float)atlas.frame(tile).sourceH : 256.0f;
+			for (float y = 0.0f; y < config.height; y += tileH)
+			{
+				for (float x = 0.0f; x < config.width; x += tileW)
+					add(tile, { x, y, tileW, tileH }, 0, { 40, 30, 60, 255 });
+			}
+
+			const char* buttonNames[] = { "UI/buttonBlue", "UI/buttonGreen", "UI/buttonYellow", "UI/buttonRed" };
+			const int buttonCount = (int)(sizeof(buttonNames) / sizeof(buttonNames[0]));
+			const float gap = 20.0f;
+			float top = 0.0f;
+			for (int i = 0; i < buttonCount; i++)
+			{
+				int sprite = atlas.find(buttonNames[i]);
+				float w = sprite >= 0 ? (float)atlas.frame(sprite).sourceW : 222.0f;
+				float h = sprite >= 0 ? (float)atlas.frame(sprite).sourceH : 39.0f;
+				if (i == 0)
+					top = (config.height - buttonCount * h - (buttonCount - 1) * gap) * 0.5f;
+				buttons.push_back(items.size());
+				add(sprite, { (config.width - w) * 0.5f, top + i * (h + gap), w, h }, 1, { 90, 120, 200, 255 });
+			}
+
+			cursorSprite = atlas.find("UI/cursor");
+			cursorW = cursorSprite >= 0 ? (float)atlas.frame(cursorSprite).sourceW : 30.0f;
+			cursorH = cursorSprite >= 0 ? (float)atlas.frame(cursorSprite).sourceH : 33.0f;
+		}
+
+		const char* name() const override { return "menu"; }
+
+		void tick(float tickSeconds) override
+		{
+			held += Real(tickSeconds);
+			if (held >= Real(cursorSeconds))
+			{
+				held -= Real(cursorSeconds);
+				selected = (selected + 1) % (int)buttons.size();
+			}
+		}
+
+		void capture(SceneSnapshot& snapshot) const override
+		{
+			snapshot.sprites.insert(snapshot.sprites.end(), items.begin(), items.end());
+
+			// Beside the selected button. It jumps, so there's nothing to blend between.
+			const SDL_FRect& button = items[buttons[selected]].latest;
+			SnapshotSprite cursor;
+			cursor.sprite = cursorSprite;
+			cursor.latest = { button.x - cursorW - 12.0f, button.y + (button.h - cursorH) * 0.5f, cursorW, cursorH };
+			cursor.previous = cursor.latest;
+			cursor.previousAngle = cursor.angle = 0.0f;
+			cursor.layer = 2;
+			cursor.fallbackColor = { 230, 230, 230, 255 };
+			snapshot.sprites.push_back(cursor);
+		}
+
+		int entityCount() const override { return (int)items.size() + 1; }
+
+		uint64_t checksum() const override
+		{
+			return hashValue(held, hashValue(selected, fnv1a64Seed));
+		}
+
+	private:
+		static constexpr float cursorSeconds = 1.5f;
+
+		void add(int sprite, const SDL_FRect& box, uint8_t layer, SDL_Color fallbackColor)
+		{
+			SnapshotSprite item;
+			item.sprite = sprite;
+			item.previous = item.latest = box;
+			item.previousAngle = item.angle = 0.0f;
+			item.layer = layer;
+			item.fallbackColor = fallbackColor;
+			items.push_back(item);
+		}
+
+		std::vector<SnapshotSprite> items; // the background tiles and the buttons, which never move
+		std::vector<size_t> buttons;       // index into items
+		int cursorSprite = -1;
+		float cursorW = 0.0f, cursorH = 0.0f;
+		int selected = 0;
+		Real held = Real(0); // seconds the cursor has been on the selected button
+	};
+}
+
+const std::vector<std::string>& sceneNames()
+{
+	static const std::vector<std::string> names = { "meteor-field", "bullet-hell", "laser-barrage", "menu" };
+	return names;
+}
+
+std::unique_ptr<Scene> createScene(const std::string& name, const SceneConfig& config, SpriteAtlas& atlas)
+{
+	if (name == "meteor-field")
+		return std::make_unique<MeteorFieldScene>(config, atlas);
+	if (name == "bullet-hell")
+		return std::make_unique<BulletHellScene>(config, atlas);
+	if (name == "laser-barrage")
+		return std::make_unique<LaserBarrageScene>(config, atlas);
+	if (name == "menu")
+		return std::make_unique<MenuScene>(config, atlas);
+	return nullptr;
+}
@@ -0,0 +1,24 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <vector>
+#include "Scene.h"
+
+// Settings shared by every scripted scene.
+struct SceneConfig
+{
+	int width = 800;
+	int height = 600;
+	int entityCount = 2000;   // how many objects the scene tries to keep alive
+	unsigned int seed = 1007; // scenes are deterministic for a given seed
+	std::string broadphase = "spatial-hash"; // one of broadphaseNames()
+	bool pixelMasks = false;  // rotated sprites: pixel masks instead of convex hulls (CollisionShape)
+};
+
+// Names of all scripted scenes, in the order the benchmark runs them.
+const std::vector<std::string>& sceneNames();
+
+// Creates a scene by name, or returns nullptr if there is no such scene.
+// The scene looks up its sprites in atlas and draws them through atlas.
+// If a sprite can't be found the scene draws plain rectangles in its place.
+std::unique_ptr<Scene> createScene(const std::string& name, const SceneConfig& config, SpriteAtlas& atlas);
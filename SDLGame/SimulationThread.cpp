@@ -0,0 +1,73 @@
+#include "SimulationThread.h"
+#include <chrono>
+
+namespace
+{
+	// How long the worker spins for its next ticks before it sleeps between looks. When
+	// drawing is the slower half the ticks come within this; when they don't, the main
+	// thread is waiting for vsync and the worker shouldn't hold a core meanwhile.
+	const std::chrono::microseconds spinBeforeSleeping(500);
+	const std::chrono::microseconds sleepStep(100);
+}
+
+SimulationThread::SimulationThread(Scene& scene, std::function<void()> runTick) : scene(scene), runTick(std::move(runTick))
+{
+	scene.capture(snapshots[0]);
+	worker = std::thread(&SimulationThread::run, this);
+}
+
+SimulationThread::~SimulationThread()
+{
+	stopping.store(true, std::memory_order_release);
+	worker.join();
+}
+
+const SceneSnapshot& SimulationThread::finish()
+{
+	uint64_t batch = started.load(std::memory_order_relaxed);
+	if (finished.load(std::memory_order_acquire) != batch)
+	{
+		auto waitStart = std::chrono::steady_clock::now();
+		while (finished.load(std::memory_order_acquire) != batch)
+			std::this_thread::yield();
+		waited += std::chrono::duration<double>(std::chrono::steady_clock::now() - waitStart).count();
+	}
+	return snapshots[batch % 2];
+}
+
+void SimulationThread::start(int ticks, float alpha)
+{
+	// The release makes both settings visible to the worker before it sees the new batch.
+	pendingTicks = ticks;
+	pendingAlpha = alpha;
+	started.store(started.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+void SimulationThread::run()
+{
+	uint64_t done = 0;
+	for (;;)
+	{
+		auto idleSince = std::chrono::steady_clock::now();
+		while (started.load(std::memory_order_acquire) == done)
+		{
+			// Look at started again after stopping: a batch handed over just before the
+			// destructor still runs.
+			if (stopping.load(std::memory_order_acquire) && started.load(std::memory_order_acquire) == done)
+				return;
+			if (std::chrono::steady_clock::now() - idleSince < spinBeforeSleeping)
+				std::this_thread::yield();
+			else
+				std::this_thread::sleep_for(sleepStep);
+		}
+
+		done++;
+		for (int i = 0; i < pendingTicks; i++)
+			runTick();
+		SceneSnapshot& snapshot = snapshots[done % 2];
+		snapshot.clear();
+		scene.capture(snapshot);
+		snapshot.alpha = pendingAlpha;
+		finished.store(done, std::memory_order_release);
+	}
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <thread>
+#include "Scene.h"
+#include "SceneSnapshot.h"
+
+// Runs a scene's ticks on a worker thread one frame ahead of the thread that draws it.
+// Each frame the main thread takes the snapshot of the ticks it started last frame,
+// starts this frame's ticks, and draws the snapshot while they run, so presenting and
+// waiting for vsync no longer hold up the simulation. What's on screen is a frame
+// behind the input that drove it.
+//
+// There are two snapshots: the worker captures into one while the main thread draws
+// the other, and they swap at each handoff. The handoff is two counters, batches
+// started and batches finished, with no lock taken on either side.
+//
+// Between finish() and start() the worker is idle and the main thread may use the
+// scene (entity counts, hot reload). Otherwise the scene belongs to the worker.
+class SimulationThread
+{
+public:
+	// runTick advances scene by one tick; it's called on the worker. The scene's state
+	// now is captured as the first snapshot.
+	SimulationThread(Scene& scene, std::function<void()> runTick);
+
+	// Waits for the ticks in flight, then stops the worker.
+	~SimulationThread();
+
+	SimulationThread(const SimulationThread&) = delete;
+	SimulationThread& operator=(const SimulationThread&) = delete;
+
+	// Waits for the ticks start() last handed over and returns their snapshot, valid
+	// until the next finish(). Spins rather than sleeps: this is on the frame's path.
+	const SceneSnapshot& finish();
+
+	// Has the worker run ticks ticks and capture the result, to be drawn at alpha.
+	// Call finish() first.
+	void start(int ticks, float alpha);
+
+	// Seconds finish() spent waiting since construction: the frames the simulation was
+	// slower than drawing.
+	double waitSeconds() const { return waited; }
+
+private:
+	void run();
+
+	Scene& scene;
+	std::function<void()> runTick;
+	SceneSnapshot snapshots[2]; // batch n is captured into snapshots[n % 2]
+	int pendingTicks = 0;       // written before started is raised, read after
+	float pendingAlpha = 1.0f;
+	std::atomic<uint64_t> started{ 0 };
+	std::atomic<uint64_t> finished{ 0 };
+	std::atomic<bool> stopping{ false };
+	double waited = 0.0;
+	std::thread worker;
+};
@@ -0,0 +1,212 @@
+#include "SoftwareBlitter.h"
+#include <algorithm>
+#include <cmath>
+#include <initializer_list>
+
+namespace
+{
+	// The tint in the surface's channel order, alpha on top where the kernels want it.
+	uint32_t packColor(const SDL_PixelFormat* pFormat, SDL_Color color)
+	{
+		return (uint32_t)color.r << pFormat->Rshift | (uint32_t)color.g << pFormat->Gshift | (uint32_t)color.b << pFormat->Bshift | (uint32_t)color.a << 24;
+	}
+
+	bool sameChannels(const SDL_PixelFormat* pA, const SDL_PixelFormat* pB)
+	{
+		return pA->BytesPerPixel == 4 && pB->BytesPerPixel == 4 && pA->Rmask == pB->Rmask && pA->Gmask == pB->Gmask && pA->Bmask == pB->Bmask;
+	}
+
+	// Narrows [first, last) to the t for which 0 <= start + t * step < end.
+	void narrowSpan(float start, float step, float end, float& first, float& last)
+	{
+		if (step == 0.0f)
+		{
+			if (start < 0.0f || start >= end)
+				last = first;
+			return;
+		}
+		float a = -start / step, b = (end - start) / step;
+		if (step < 0.0f)
+			std::swap(a, b);
+		first = std::max(first, a);
+		last = std::min(last, b);
+	}
+}
+
+SoftwareBlitter::SoftwareBlitter(SDL_Surface* pTarget, const BlitKernels& kernels) : pTarget(pTarget), blit(kernels)
+{
+}
+
+BlitKernel SoftwareBlitter::kernelFor(SDL_BlendMode blend) const
+{
+	switch (blend)
+	{
+	case SDL_BLENDMODE_NONE: return blit.copy;
+	case SDL_BLENDMODE_BLEND: return blit.blend;
+	case SDL_BLENDMODE_ADD: return blit.add;
+	case SDL_BLENDMODE_MOD: return blit.modulate;
+	default: return nullptr;
+	}
+}
+
+bool SoftwareBlitter::canDraw(const SDL_Surface* pSource, SDL_BlendMode blend) const
+{
+	const SDL_PixelFormat* pFormat = pTarget->format;
+	if (kernelFor(blend) == nullptr || SDL_MUSTLOCK(pTarget) || pFormat->BytesPerPixel != 4 || (pFormat->Amask != 0 && pFormat->Amask != 0xFF000000))
+		return false;
+	return pSource == nullptr || (!SDL_MUSTLOCK(pSource) && pSource->format->Amask == 0xFF000000 && sameChannels(pSource->format, pFormat));
+}
+
+void SoftwareBlitter::drawFrom(const SDL_Surface* pSource, const SDL_Rect& src, const SDL_FRect& dst, float angle, SDL_FPoint center,
+	SDL_Color color, SDL_BlendMode blend, AlphaKind alpha, const SpriteRuns* pRuns)
+{
+	BlitKernel kernel = kernelFor(blend);
+	if (kernel == nullptr || src.w <= 0 || src.h <= 0 || dst.w <= 0.0f || dst.h <= 0.0f)
+		return;
+
+	// Blending an opaque pixel at full alpha just replaces what's there, so the opaque
+	// parts of a source are copies, and a source with binary alpha a masked copy.
+	BlitKernel opaque = kernel;
+	if (blend == SDL_BLENDMODE_BLEND && color.a == 255)
+	{
+		opaque = blit.copy;
+		if (alpha == AlphaKind::Opaque)
+			kernel = blit.copy;
+		else if (alpha == AlphaKind::Binary)
+			kernel = blit.maskedCopy;
+	}
+
+	// NONE and MOD change the destination under transparent pixels too, so they can't skip them.
+	bool runsFit = pRuns && pRuns->width() == pSource->w && pRuns->height() == pSource->h;
+	if (!runsFit || (blend != SDL_BLENDMODE_BLEND && blend != SDL_BLENDMODE_ADD))
+		pRuns = nullptr;
+
+	uint32_t tint = packColor(pSource->format, color);
+	if (angle == 0.0f)
+		drawUpright(pSource, src, dst, tint, kernel, pRuns, opaque);
+	else
+		drawRotated(pSource, src, dst, angle, center, tint, kernel);
+}
+
+void SoftwareBlitter::fill(const SDL_FRect& dst, SDL_Color color, SDL_BlendMode blend)
+{
+	BlitKernel kernel = kernelFor(blend);
+	if (kernel == nullptr)
+		return;
+
+	// Every pixel whose centre dst covers.
+	const SDL_Rect& clip = pTarget->clip_rect;
+	int x0 = std::max(clip.x, (int)std::ceil(dst.x - 0.5f)), x1 = std::min(clip.x + clip.w, (int)std::ceil(dst.x + dst.w - 0.5f));
+	int y0 = std::max(clip.y, (int)std::ceil(dst.y - 0.5f)), y1 = std::min(clip.y + clip.h, (int)std::ceil(dst.y + dst.h - 0.5f));
+	if (x0 >= x1 || y0 >= y1)
+		return;
+
+	if (solid.size() < (size_t)(x1 - x0))
+		solid.resize(x1 - x0, 0xFFFFFFFF);
+	uint32_t tint = packColor(pTarget->format, color);
+	for (int y = y0; y < y1; y++)
+		kernel(targetRow(y) + x0, solid.data(), x1 - x0, tint);
+}
+
+void SoftwareBlitter::drawUpright(const SDL_Surface* pSource, const SDL_Rect& src, const SDL_FRect& dst, uint32_t tint, BlitKernel kernel,
+	const SpriteRuns* pRuns, BlitKernel opaque)
+{
+	const SDL_Rect& clip = pTarget->clip_rect;
+	int x0 = std::max(clip.x, (int)std::ceil(dst.x - 0.5f)), x1 = std::min(clip.x + clip.w, (int)std::ceil(dst.x + dst.w - 0.5f));
+	int y0 = std::max(clip.y, (int)std::ceil(dst.y - 0.5f)), y1 = std::min(clip.y + clip.h, (int)std::ceil(dst.y + dst.h - 0.5f));
+	if (x0 >= x1 || y0 >= y1)
+		return;
+
+	// Texels per pixel, and the texel column under the first pixel's centre in 16.16 fixed point.
+	float scaleX = src.w / dst.w, scaleY = src.h / dst.h;
+	int count = x1 - x0;
+	int firstColumn = (int)((x0 + 0.5f - dst.x) * scaleX * 65536.0f);
+	int columnStep = (int)(scaleX * 65536.0f);
+	int lastColumn = src.w - 1;
+
+	// Unscaled rows are runs of the source as they are; only scaled ones need gathering.
+	bool unscaled = dst.w == (float)src.w && (firstColumn >> 16) + count <= src.w;
+	if (!unscaled && row.size() < (size_t)count)
+		row.resize(count);
+
+	for (int y = y0; y < y1; y++)
+	{
+		int texelRow = std::min(src.h - 1, (int)((y + 0.5f - dst.y) * scaleY));
+		const uint32_t* pTexels = (const uint32_t*)((const uint8_t*)pSource->pixels + (size_t)(src.y + texelRow) * pSource->pitch) + src.x;
+		if (unscaled && pRuns)
+		{
+			pRuns->drawRow(targetRow(y) + x0, pTexels - src.x, src.y + texelRow, src.x + (firstColumn >> 16), count, opaque, kernel, tint);
+			continue;
+		}
+		if (unscaled)
+		{
+			kernel(targetRow(y) + x0, pTexels + (firstColumn >> 16), count, tint);
+			continue;
+		}
+
+		int u = firstColumn;
+		for (int i = 0; i < count; i++, u += columnStep)
+			row[i] = pTexels[std::min(u >> 16, lastColumn)];
+		kernel(targetRow(y) + x0, row.data(), count, tint);
+	}
+}
+
+void SoftwareBlitter::drawRotated(const SDL_Surface* pSource, const SDL_Rect& src, const SDL_FRect& dst, float angle, SDL_FPoint center, uint32_t tint, BlitKernel kernel)
+{
+	float radians = angle * 3.14159265f / 180.0f;
+	float c = std::cos(radians), s = std::sin(radians);
+	float pivotX = dst.x + center.x, pivotY = dst.y + center.y;
+
+	// The rows the rotated quad touches, from its corners.
+	float minY = pivotY, maxY = pivotY, minX = pivotX, maxX = pivotX;
+	bool first = true;
+	for (float cornerX : { 0.0f, dst.w })
+	{
+		for (float cornerY : { 0.0f, dst.h })
+		{
+			float dx = cornerX - center.x, dy = cornerY - center.y;
+			float x = pivotX + dx * c - dy * s, y = pivotY + dx * s + dy * c;
+			minX = first ? x : std::min(minX, x);
+			maxX = first ? x : std::max(maxX, x);
+			minY = first ? y : std::min(minY, y);
+			maxY = first ? y : std::max(maxY, y);
+			first = false;
+		}
+	}
+
+	const SDL_Rect& clip = pTarget->clip_rect;
+	int x0 = std::max(clip.x, (int)std::ceil(minX - 0.5f)), x1 = std::min(clip.x + clip.w, (int)std::ceil(maxX - 0.5f));
+	int y0 = std::max(clip.y, (int)std::ceil(minY - 0.5f)), y1 = std::min(clip.y + clip.h, (int)std::ceil(maxY - 0.5f));
+	if (x0 >= x1 || y0 >= y1)
+		return;
+	if (row.size() < (size_t)(x1 - x0))
+		row.resize(x1 - x0);
+
+	// Pixel centres map back to texels by the inverse rotation; along a row both texel
+	// coordinates change by a fixed step, so each row is one span found from its ends.
+	float scaleX = src.w / dst.w, scaleY = src.h / dst.h;
+	float stepU = c * scaleX, stepV = -s * scaleY;
+	for (int y = y0; y < y1; y++)
+	{
+		float ex = x0 + 0.5f - pivotX, ey = y + 0.5f - pivotY;
+		float u = (center.x + ex * c + ey * s) * scaleX;
+		float v = (center.y - ex * s + ey * c) * scaleY;
+
+		float spanFirst = 0.0f, spanLast = (float)(x1 - x0);
+		narrowSpan(u, stepU, (float)src.w, spanFirst, spanLast);
+		narrowSpan(v, stepV, (float)src.h, spanFirst, spanLast);
+		int begin = (int)std::ceil(spanFirst), end = (int)std::ceil(spanLast);
+		if (begin >= end)
+			continue;
+
+		int fixedU = (int)((u + begin * stepU) * 65536.0f), fixedV = (int)((v + begin * stepV) * 65536.0f);
+		int fixedStepU = (int)(stepU * 65536.0f), fixedStepV = (int)(stepV * 65536.0f);
+		for (int i = 0; i < end - begin; i++, fixedU += fixedStepU, fixedV += fixedStepV)
+		{
+			int column = std::min(std::max(fixedU >> 16, 0), src.w - 1);
+			int texelRow = std::min(std::max(fixedV >> 16, 0), src.h - 1);
+			row[i] = *((const uint32_t*)((const uint8_t*)pSource->pixels + (size_t)(src.y + texelRow) * pSource->pitch) + src.x + column);
+		}
+		kernel(targetRow(y) + x0 + begin, row.data(), end - begin, tint);
+	}
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <SDL.h>
+#include "BlitKernels.h"
+#include "SpriteRuns.h"
+
+// Draws sprites straight into an SDL_Surface with the SIMD kernels in BlitKernels, for
+// machines with no GPU, where SDL would fall back to its generic software renderer.
+// A SpriteBatch given one (SpriteBatch::setBlitter) sends it every run it can draw.
+//
+// The target and the sources are 32-bit surfaces with the same colour channels, and the
+// sources have alpha in the top byte: ARGB8888 sprites on an ARGB8888 or RGB888 target,
+// say. Neither may need locking. Scaling samples the nearest texel, as SDL's software
+// renderer does, and rotated sprites are drawn one span per row.
+//
+// With BLEND at full alpha, sources known to be opaque are copied and ones with binary
+// alpha get masked copies (see AlphaKind.h). Given the source's SpriteRuns, unscaled
+// upright sprites drawn with BLEND or ADD touch only the pixels the runs cover, and
+// opaque runs drawn with BLEND at full alpha are plain copies (memcpy when untinted).
+// The other cases need every pixel, runs or not.
+class SoftwareBlitter
+{
+public:
+	SoftwareBlitter(SDL_Surface* pTarget, const BlitKernels& kernels = blitKernels());
+
+	SDL_Surface* target() const { return pTarget; }
+	const BlitKernels& kernels() const { return blit; }
+
+	// Whether drawFrom() can draw pSource with blend, and fill() a rectangle with it
+	// (pSource null). Anything else is for the renderer.
+	bool canDraw(const SDL_Surface* pSource, SDL_BlendMode blend) const;
+
+	// Draws src of pSource over dst (window pixels), rotated by angle degrees clockwise
+	// around center, relative to the top-left of dst. color tints it like SDL's colour and alpha mod.
+	// alpha is how src uses alpha, and pRuns, if given, are pSource's SpriteRuns.
+	void drawFrom(const SDL_Surface* pSource, const SDL_Rect& src, const SDL_FRect& dst, float angle, SDL_FPoint center,
+		SDL_Color color, SDL_BlendMode blend, AlphaKind alpha = AlphaKind::Translucent, const SpriteRuns* pRuns = nullptr);
+
+	// A solid rectangle, blended like a sprite of color.
+	void fill(const SDL_FRect& dst, SDL_Color color, SDL_BlendMode blend);
+
+private:
+	BlitKernel kernelFor(SDL_BlendMode blend) const;
+	uint32_t* targetRow(int y) const { return (uint32_t*)((uint8_t*)pTarget->pixels + (size_t)y * pTarget->pitch); }
+	void drawUpright(const SDL_Surface* pSource, const SDL_Rect& src, const SDL_FRect& dst, uint32_t tint, BlitKernel kernel,
+		const SpriteRuns* pRuns, BlitKernel opaque);
+	void drawRotated(const SDL_Surface* pSource, const SDL_Rect& src, const SDL_FRect& dst, float angle, SDL_FPoint center, uint32_t tint, BlitKernel kernel);
+
+	SDL_Surface* pTarget;
+	const BlitKernels& blit;
+	std::vector<uint32_t> row;   // texels gathered for one span
+	std::vector<uint32_t> solid; // opaque white, the source for fill()
+};
@@ -0,0 +1,166 @@
+#include "SpatialHash.h"
+#include <algorithm>
+
+SpatialHash::SpatialHash(float cellSize)
+{
+	setCellSize(cellSize);
+}
+
+void SpatialHash::setCellSize(float size)
+{
+	cell = size > 1.0f ? size : 1.0f;
+	inverseCell = 1.0f / cell;
+}
+
+void SpatialHash::fitSizes(const std::vector<float>& sizes)
+{
+	setCellSize(cellSizeFor(sizes));
+}
+
+float SpatialHash::cellSizeFor(std::vector<float> sizes)
+{
+	if (sizes.empty())
+		return 64.0f;
+	size_t middle = sizes.size() / 2;
+	std::nth_element(sizes.begin(), sizes.begin() + middle, sizes.end());
+	return std::max(sizes[middle] * 2.0f, 8.0f);
+}
+
+int32_t SpatialHash::cellOf(float position) const
+{
+	// floor() without the library call; positions are never near the int range.
+	float scaled = position * inverseCell;
+	int32_t truncated = (int32_t)scaled;
+	return truncated - (scaled < (float)truncated);
+}
+
+uint32_t SpatialHash::bucketOf(int32_t cellX, int32_t cellY) const
+{
+	return ((uint32_t)cellX * 73856093u ^ (uint32_t)cellY * 19349663u) & bucketMask;
+}
+
+void SpatialHash::build()
+{
+	const uint32_t count = (uint32_t)minX.size();
+
+	// The cells each box covers, and how many (cell, box) entries that makes at most.
+	cellRanges.resize(count);
+	size_t entryLimit = 0;
+	for (uint32_t i = 0; i < count; i++)
+	{
+		CellRange& range = cellRanges[i];
+		range = { cellOf(minX[i]), cellOf(minY[i]), cellOf(maxX[i]), cellOf(maxY[i]) };
+		entryLimit += (size_t)(range.x1 - range.x0 + 1) * (size_t)(range.y1 - range.y0 + 1);
+	}
+
+	// About one bucket per occupied cell.
+	uint32_t bucketCount = 1;
+	while (bucketCount < entryLimit)
+		bucketCount *= 2;
+	bucketMask = bucketCount - 1;
+
+	// Hash every cell a box touches. Two of its cells can land in the same bucket;
+	// keeping the box there once means a bucket never holds the same box twice.
+	bucketStart.assign(bucketCount + 1, 0);
+	entryBuckets.resize(entryLimit);
+	entryIds.resize(entryLimit);
+	uint32_t* pBuckets = entryBuckets.data();
+	uint32_t* pIds = entryIds.data();
+	uint32_t* pCounts = bucketStart.data() + 1;
+	size_t entryCount = 0;
+	for (uint32_t i = 0; i < count; i++)
+	{
+		const CellRange range = cellRanges[i];
+		size_t firstEntry = entryCount;
+		for (int32_t y = range.y0; y <= range.y1; y++)
+		{
+			for (int32_t x = range.x0; x <= range.x1; x++)
+			{
+				uint32_t bucket = bucketOf(x, y);
+				if (entryCount != firstEntry && std::find(pBuckets + firstEntry, pBuckets + entryCount, bucket) != pBuckets + entryCount)
+					continue;
+				pBuckets[entryCount] = bucket;
+				pIds[entryCount] = i;
+				entryCount++;
+				pCounts[bucket]++;
+			}
+		}
+	}
+
+	// Counting sort: prefix sums give each bucket its range, then entries are scattered
+	// in box order, which keeps the ids in every bucket ascending.
+	candidates = 0;
+	for (uint32_t bucket = 0; bucket < bucketCount; bucket++)
+	{
+		size_t bucketSize = bucketStart[bucket + 1];
+		candidates += bucketSize * (bucketSize - 1) / 2;
+		bucketStart[bucket + 1] += bucketStart[bucket];
+	}
+	bucketCursor.assign(bucketStart.begin(), bucketStart.end() - 1);
+	entries.resize(entryCount);
+	Entry* pEntries = entries.data();
+	uint32_t* pCursor = bucketCursor.data();
+	for (size_t e = 0; e < entryCount; e++)
+	{
+		uint32_t i = pIds[e];
+		pEntries[pCursor[pBuckets[e]]++] = { minX[i], minY[i], maxX[i], maxY[i], i, layerBits[i] };
+	}
+}
+
+void SpatialHash::findPairs(std::vector<BoxPair>& pairs) const
+{
+	collectPairs(true, 0, pairs);
+}
+
+void SpatialHash::findPairsBetween(uint32_t split, std::vector<BoxPair>& pairs) const
+{
+	collectPairs(false, split, pairs);
+}
+
+void SpatialHash::collectPairs(bool allPairs, uint32_t split, std::vector<BoxPair>& pairs) const
+{
+	// Room for every candidate, so the loop below can write each one and only keep the
+	// real pairs by moving on. Whether two boxes overlap is close to a coin toss; as a
+	// branch it would be mispredicted all the time.
+	pairs.resize(candidates);
+	BoxPair* pOut = pairs.data();
+
+	const Entry* pEntries = entries.data();
+	const uint32_t bucketCount = bucketMask + 1;
+	for (uint32_t bucket = 0; bucket < bucketCount; bucket++)
+	{
+		uint32_t begin = bucketStart[bucket];
+		uint32_t end = bucketStart[bucket + 1];
+		if (end - begin < 2)
+			continue;
+
+		// Ids are ascending, so the first group is a prefix of the bucket.
+		uint32_t middle = begin;
+		if (!allPairs)
+		{
+			while (middle < end && pEntries[middle].box < split)
+				middle++;
+		}
+		uint32_t firstEnd = allPairs ? end : middle;
+		for (uint32_t i = begin; i < firstEnd; i++)
+		{
+			const Entry& a = pEntries[i];
+			const uint32_t collidesWith = a.layers >> 16;
+			for (uint32_t j = allPairs ? i + 1 : middle; j < end; j++)
+			{
+				const Entry& b = pEntries[j];
+				bool overlap = (a.minX < b.maxX) & (b.minX < a.maxX) & (a.minY < b.maxY) & (b.minY < a.maxY) & ((collidesWith & b.layers) != 0);
+
+				// Boxes sharing several cells meet in several buckets. Only the bucket holding
+				// the top-left corner of their overlap reports them.
+				float cornerX = std::max(a.minX, b.minX);
+				float cornerY = std::max(a.minY, b.minY);
+				bool owner = bucketOf(cellOf(cornerX), cellOf(cornerY)) == bucket;
+
+				*pOut = { a.box, b.box };
+				pOut += overlap & owner;
+			}
+		}
+	}
+	pairs.resize(pOut - pairs.data());
+}
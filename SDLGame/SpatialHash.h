@@ -0,0 +1,74 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Broadphase.h"
+
+// Uniform grid broadphase for objects that all move every tick.
+//
+// Nothing is kept between ticks. build() hashes each box into the cells its bounds
+// cover and counting-sorts those (cell, box) entries into one flat array, so a rebuild
+// is a few linear passes over the boxes and, once the arrays have grown, allocates
+// nothing. Cells are hashed into a table sized from the number of entries, so the world has
+// no edges and the cost follows the number of objects, not the area they cover.
+class SpatialHash : public Broadphase
+{
+public:
+	explicit SpatialHash(float cellSize = 64.0f);
+
+	const char* name() const override { return "spatial-hash"; }
+
+	// Sets the cell size from cellSizeFor(sizes).
+	void fitSizes(const std::vector<float>& sizes) override;
+
+	// Takes effect at the next build().
+	void setCellSize(float size);
+	float cellSize() const { return cell; }
+
+	// A cell size for objects of these sizes (the longer side of each, pixels): twice the
+	// median, so a typical object touches one or two cells. Bigger cells crowd more
+	// objects into each one; smaller ones spread every object over more cells.
+	static float cellSizeFor(std::vector<float> sizes);
+
+	// Sorts the boxes added since clear() into cells.
+	void build() override;
+
+	void findPairs(std::vector<BoxPair>& pairs) const override;
+	void findPairsBetween(uint32_t split, std::vector<BoxPair>& pairs) const override;
+
+	// (cell, box) entries in the last build(). Divided by size() it's how many cells an average box touches.
+	size_t entryCount() const { return entries.size(); }
+
+	// Pairs of entries sharing a bucket in the last build(): how many box tests findPairs() does at most.
+	size_t candidateCount() const { return candidates; }
+
+private:
+	// A box as sorted into a bucket, with its bounds and layer bits copied alongside
+	// so the pair loop reads each bucket front to back.
+	struct Entry
+	{
+		float minX, minY, maxX, maxY;
+		uint32_t box;
+		uint32_t layers;
+	};
+
+	struct CellRange
+	{
+		int32_t x0, y0, x1, y1;
+	};
+
+	void collectPairs(bool allPairs, uint32_t split, std::vector<BoxPair>& pairs) const;
+	int32_t cellOf(float position) const;
+	uint32_t bucketOf(int32_t cellX, int32_t cellY) const;
+
+	float cell;
+	float inverseCell;
+	std::vector<CellRange> cellRanges;
+	uint32_t bucketMask = 0;
+	size_t candidates = 0;
+	std::vector<uint32_t> bucketStart;  // bucket -> first entry; bucketStart[bucket + 1] is its end
+	std::vector<uint32_t> bucketCursor;
+	std::vector<uint32_t> entryBuckets; // unsorted, in box order
+	std::vector<uint32_t> entryIds;
+	std::vector<Entry> entries;         // sorted by bucket, ascending box id within each
+};
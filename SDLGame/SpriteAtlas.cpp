@@ -0,0 +1,445 @@
+#include "SpriteAtlas.h"
+#include <algorithm>
+#include "SpriteTable.h"
+
+namespace
+{
+	bool insideSurface(const SDL_Rect& rect, const SDL_Surface* pSurface)
+	{
+		return rect.x >= 0 && rect.y >= 0 && rect.w >= 0 && rect.h >= 0 && rect.x + rect.w <= pSurface->w && rect.y + rect.h <= pSurface->h;
+	}
+}
+
+SpriteAtlas::SpriteAtlas(SpriteBatch& batch, AssetCache& cache) : spriteBatch(batch), assetCache(cache)
+{
+}
+
+SpriteAtlas::~SpriteAtlas()
+{
+	clear();
+}
+
+void SpriteAtlas::clear()
+{
+	for (const UsedTexture& used : textures)
+	{
+		spriteBatch.removeTexture(used.slot);
+		assetCache.release(used.handle);
+	}
+	textures.clear();
+	frames.clear();
+	names.clear();
+	byName.clear();
+	masks.clear();
+	shapes.clear();
+	meshes.clear();
+	pageSlots.clear();
+	tablePath.clear();
+	packed = false;
+}
+
+int SpriteAtlas::addTexture(AssetHandle texture)
+{
+	// With kept pixels the blitter can skip what's transparent, given the runs: from the
+	// pack when it has them for this image, otherwise built from the pixels.
+	SDL_Surface* pPixels = assetCache.surface(texture);
+	std::unique_ptr<SpriteRuns> pRuns;
+	if (pPixels && pPixels->format->Amask == 0xFF000000)
+	{
+		pRuns = std::make_unique<SpriteRuns>();
+		bool fromPack = assetCache.loader().loadSpriteRuns(assetCache.path(texture), *pRuns)
+			&& pRuns->width() == pPixels->w && pRuns->height() == pPixels->h;
+		if (!fromPack)
+			pRuns->build(pPixels->pixels, pPixels->w, pPixels->h, pPixels->pitch);
+		if (pRuns->isEmpty())
+			pRuns.reset();
+	}
+
+	int slot = spriteBatch.addTexture(assetCache.texture(texture), pPixels, pRuns.get());
+	textures.push_back({ slot, texture, std::move(pRuns) });
+	return slot;
+}
+
+bool SpriteAtlas::loadPacked(const std::string& tableFile)
+{
+	SpriteTable table;
+	if (!table.read(assetCache.loader().root() + tableFile))
+		return false;
+
+	// Page files are relative to the table; the loader wants paths relative to the asset root.
+	std::string tableDir = tableFile.substr(0, tableFile.find_last_of("/\\") + 1);
+	for (const AtlasPage& page : table.pages)
+	{
+		AssetHandle texture = assetCache.acquireTexture(tableDir + page.file);
+		if (!texture.isValid())
+		{
+			// A missing page makes the whole atlas useless; fall back to loose files.
+			for (size_t i = 0; i < pageSlots.size(); i++)
+			{
+				spriteBatch.removeTexture(textures.back().slot);
+				assetCache.release(textures.back().handle);
+				textures.pop_back();
+			}
+			pageSlots.clear();
+			return false;
+		}
+		pageSlots.push_back(addTexture(texture));
+	}
+
+	for (const SpriteEntry& entry : table.sprites)
+		addPackedFrame(entry, table.pages[entry.page]);
+	tablePath = tableFile;
+	packed = true;
+	return true;
+}
+
+void SpriteAtlas::addPackedFrame(const SpriteEntry& entry, const AtlasPage& page)
+{
+	SpriteFrame frame;
+	frame.textureSlot = pageSlots[entry.page];
+	frame.rect = { entry.x, entry.y, entry.w, entry.h };
+	frame.u0 = (float)entry.x / page.width;
+	frame.v0 = (float)entry.y / page.height;
+	frame.u1 = (float)(entry.x + entry.w) / page.width;
+	frame.v1 = (float)(entry.y + entry.h) / page.height;
+	frame.offsetX = entry.offsetX;
+	frame.offsetY = entry.offsetY;
+	frame.sourceW = entry.sourceW;
+	frame.sourceH = entry.sourceH;
+	frame.pivotX = entry.pivotX;
+	frame.pivotY = entry.pivotY;
+	frame.alpha = entry.alpha;
+	int sprite = addFrame(entry.name, frame);
+	setMesh(sprite, entry.mesh);
+
+	// Updated in place on reload, so shapes already handed out stay current.
+	if (entry.shape.isEmpty())
+		return;
+	if ((int)shapes.size() <= sprite)
+		shapes.resize(frames.size());
+	if (shapes[sprite])
+		*shapes[sprite] = entry.shape;
+	else
+		shapes[sprite] = std::make_unique<CollisionShape>(entry.shape);
+}
+
+SpriteAtlas::ReloadResult SpriteAtlas::reloadTable()
+{
+	SpriteTable table;
+	if (!packed || !table.read(assetCache.loader().root() + tablePath))
+		return ReloadResult::Failed;
+
+	// New or removed pages would need new textures and slots; that's what a restart is for.
+	if (table.pages.size() != pageSlots.size())
+		return ReloadResult::NeedsRepack;
+
+	// addFrame() finds existing sprites by name, so their ids don't change.
+	for (const SpriteEntry& entry : table.sprites)
+		addPackedFrame(entry, table.pages[entry.page]);
+	return ReloadResult::Updated;
+}
+
+SpriteAtlas::ReloadResult SpriteAtlas::reloadImage(const std::string& path, SDL_Surface* pSurface)
+{
+	if (pSurface == nullptr)
+		return ReloadResult::Failed;
+
+	// A mask someone already asked for is rebuilt in place, so their pointer sees the new
+	// one. From these pixels: decoding the file again here would stall the frame.
+	auto named = byName.find(path.substr(0, path.rfind(".png")));
+	if (named != byName.end() && named->second < (int)masks.size() && masks[named->second])
+	{
+		assetCache.loader().buildCollisionMask(pSurface, *masks[named->second]);
+		if (named->second < (int)shapes.size() && shapes[named->second])
+			shapes[named->second]->build(*masks[named->second]);
+	}
+
+	Uint32 format = textureFormat();
+	if (pSurface->format->format != format)
+	{
+		SDL_Surface* pConverted = SDL_ConvertSurfaceFormat(pSurface, format, 0);
+		SDL_FreeSurface(pSurface);
+		if (pConverted == nullptr)
+			return ReloadResult::Failed;
+		pSurface = pConverted;
+	}
+
+	ReloadResult result = ReloadResult::NotUsed;
+
+	// A page's sprite rectangles are the old table's until the packer's new table is
+	// reloaded, which brings their alpha and meshes with it. Until then they are drawn
+	// as blended quads, which is right whatever the new pixels there are. Loose sprites
+	// cover their whole texture and are described from the pixels straight away.
+	auto describe = [this, pSurface](int sprite, bool page)
+	{
+		if (page)
+		{
+			frames[sprite].alpha = AlphaKind::Translucent;
+			setMesh(sprite, SpriteMesh());
+		}
+		else
+		{
+			describeFrame(sprite, pSurface, frames[sprite].rect);
+		}
+	};
+
+	// A whole texture: a loose sprite or an atlas page.
+	for (UsedTexture& used : textures)
+	{
+		if (assetCache.path(used.handle) != path)
+			continue;
+		bool page = std::find(pageSlots.begin(), pageSlots.end(), used.slot) != pageSlots.end();
+
+		SDL_Texture* pTexture = assetCache.texture(used.handle);
+		int width = 0, height = 0;
+		SDL_QueryTexture(pTexture, nullptr, nullptr, &width, &height);
+		if (width == pSurface->w && height == pSurface->h)
+		{
+			SDL_UpdateTexture(pTexture, nullptr, pSurface->pixels, pSurface->pitch);
+			// Kept pixels and runs are the old image now, so the blitter leaves this texture to the renderer.
+			spriteBatch.replaceTexture(used.slot, pTexture);
+			used.pRuns.reset();
+			for (int sprite = 0; sprite < (int)frames.size(); sprite++)
+			{
+				if (frames[sprite].textureSlot == used.slot)
+					describe(sprite, page);
+			}
+			result = ReloadResult::Updated;
+			continue;
+		}
+
+		// A new size needs a new texture. The slot and the cache entry stay the same, so nothing else notices.
+		SDL_Texture* pResized = SDL_CreateTextureFromSurface(spriteBatch.renderer(), pSurface);
+		if (pResized == nullptr || !assetCache.replaceTexture(used.handle, pResized))
+		{
+			SDL_FreeSurface(pSurface);
+			return ReloadResult::Failed;
+		}
+		spriteBatch.replaceTexture(used.slot, pResized);
+		used.pRuns.reset();
+		for (int sprite = 0; sprite < (int)frames.size(); sprite++)
+		{
+			SpriteFrame& frame = frames[sprite];
+			if (frame.textureSlot != used.slot)
+				continue;
+			bool wholeTexture = frame.rect.x == 0 && frame.rect.y == 0 && frame.rect.w == width && frame.rect.h == height;
+			if (wholeTexture)
+			{
+				frame.rect = { 0, 0, pSurface->w, pSurface->h };
+				frame.sourceW = pSurface->w;
+				frame.sourceH = pSurface->h;
+			}
+			frame.u0 = (float)frame.rect.x / pSurface->w;
+			frame.v0 = (float)frame.rect.y / pSurface->h;
+			frame.u1 = (float)(frame.rect.x + frame.rect.w) / pSurface->w;
+			frame.v1 = (float)(frame.rect.y + frame.rect.h) / pSurface->h;
+			describe(sprite, page);
+		}
+		result = ReloadResult::Updated;
+	}
+
+	// A sprite packed into a page: patch its rectangle on the page.
+	auto it = byName.find(path.substr(0, path.rfind(".png")));
+	if (it != byName.end() && result == ReloadResult::NotUsed)
+	{
+		const SpriteFrame& frame = frames[it->second];
+		if (pSurface->w != frame.sourceW || pSurface->h != frame.sourceH || pSurface->format->BytesPerPixel != 4)
+		{
+			SDL_FreeSurface(pSurface);
+			return ReloadResult::NeedsRepack;
+		}
+
+		// The atlas only stores the trimmed rectangle. Anything drawn outside it can't be
+		// shown until the atlas is repacked. The padding around the sprite keeps the old
+		// extruded edge until then too, which only shows with linear filtering.
+		result = ReloadResult::Updated;
+		for (int y = 0; y < pSurface->h && result == ReloadResult::Updated; y++)
+		{
+			const Uint8* pRow = (const Uint8*)pSurface->pixels + y * pSurface->pitch;
+			bool rowInside = y >= frame.offsetY && y < frame.offsetY + frame.rect.h;
+			for (int x = 0; x < pSurface->w; x++)
+			{
+				if (rowInside && x >= frame.offsetX && x < frame.offsetX + frame.rect.w)
+					continue;
+				Uint8 r, g, b, a;
+				SDL_GetRGBA(*(const Uint32*)(pRow + x * 4), pSurface->format, &r, &g, &b, &a);
+				if (a != 0)
+				{
+					result = ReloadResult::NeedsRepack;
+					break;
+				}
+			}
+		}
+
+		const Uint8* pTrimmed = (const Uint8*)pSurface->pixels + frame.offsetY * pSurface->pitch + frame.offsetX * 4;
+		SDL_Texture* pPage = spriteBatch.texture(frame.textureSlot);
+		SDL_UpdateTexture(pPage, &frame.rect, pTrimmed, pSurface->pitch);
+		spriteBatch.replaceTexture(frame.textureSlot, pPage);
+		describeFrame(it->second, pSurface, { frame.offsetX, frame.offsetY, frame.rect.w, frame.rect.h });
+	}
+
+	SDL_FreeSurface(pSurface);
+	return result;
+}
+
+int SpriteAtlas::find(const std::string& name)
+{
+	auto it = byName.find(name);
+	if (it != byName.end())
+		return it->second;
+	return loadLoose(name);
+}
+
+std::vector<float> SpriteAtlas::spriteSizes() const
+{
+	std::vector<float> sizes;
+	sizes.reserve(frames.size());
+	for (const SpriteFrame& frame : frames)
+		sizes.push_back((float)std::max(frame.sourceW, frame.sourceH));
+	return sizes;
+}
+
+const CollisionMask* SpriteAtlas::collisionMask(int sprite)
+{
+	if (sprite < 0 || sprite >= (int)frames.size())
+		return nullptr;
+	if ((int)masks.size() <= sprite)
+		masks.resize(frames.size());
+	if (!masks[sprite])
+	{
+		masks[sprite] = std::make_unique<CollisionMask>();
+		assetCache.loader().loadCollisionMask(names[sprite] + ".png", *masks[sprite]);
+	}
+	return masks[sprite]->isEmpty() ? nullptr : masks[sprite].get();
+}
+
+const CollisionShape* SpriteAtlas::collisionShape(int sprite)
+{
+	if (sprite < 0 || sprite >= (int)frames.size())
+		return nullptr;
+	if ((int)shapes.size() <= sprite)
+		shapes.resize(frames.size());
+	if (!shapes[sprite])
+	{
+		shapes[sprite] = std::make_unique<CollisionShape>();
+		const CollisionMask* pMask = collisionMask(sprite);
+		if (pMask != nullptr)
+			shapes[sprite]->build(*pMask);
+	}
+	return shapes[sprite]->isEmpty() ? nullptr : shapes[sprite].get();
+}
+
+int SpriteAtlas::addFrame(const std::string& name, const SpriteFrame& frame)
+{
+	auto it = byName.find(name);
+	if (it != byName.end())
+	{
+		frames[it->second] = frame;
+		return it->second;
+	}
+	frames.push_back(frame);
+	names.push_back(name);
+	byName[name] = (int)frames.size() - 1;
+	return (int)frames.size() - 1;
+}
+
+int SpriteAtlas::preload(const std::vector<std::string>& paths, ThreadPool& pool)
+{
+	std::vector<std::string> names;
+	std::vector<std::string> missing;
+	for (const std::string& path : paths)
+	{
+		std::string name = path.substr(0, path.rfind(".png"));
+		if (byName.find(name) == byName.end())
+		{
+			names.push_back(name);
+			missing.push_back(path);
+		}
+	}
+
+	std::vector<AssetHandle> loaded = assetCache.acquireTextures(missing, pool);
+	int added = 0;
+	for (size_t i = 0; i < loaded.size(); i++)
+	{
+		if (loaded[i].isValid() && addLoose(names[i], loaded[i]) >= 0)
+			added++;
+	}
+	return added;
+}
+
+int SpriteAtlas::loadLoose(const std::string& name)
+{
+	AssetHandle texture = assetCache.acquireTexture(name + ".png");
+	if (!texture.isValid())
+		return -1;
+	return addLoose(name, texture);
+}
+
+int SpriteAtlas::addLoose(const std::string& name, AssetHandle texture)
+{
+	SpriteFrame frame;
+	frame.textureSlot = addTexture(texture);
+	SDL_QueryTexture(assetCache.texture(texture), nullptr, nullptr, &frame.sourceW, &frame.sourceH);
+	frame.rect = { 0, 0, frame.sourceW, frame.sourceH };
+	frame.u1 = frame.v1 = 1.0f;
+
+	// The pack has the image's runs and class from when it was built. Without it, the
+	// runs built from kept pixels tell both.
+	SpriteRuns packRuns;
+	const SpriteRuns* pRuns = textures.back().pRuns.get();
+	if (pRuns == nullptr && assetCache.loader().loadSpriteRuns(name + ".png", packRuns))
+		pRuns = &packRuns;
+	if (pRuns && (pRuns->width() != frame.sourceW || pRuns->height() != frame.sourceH))
+		pRuns = nullptr;
+	if (!assetCache.loader().loadAlphaKind(name + ".png", frame.alpha) && pRuns)
+		frame.alpha = pRuns->alphaKind();
+
+	int sprite = addFrame(name, frame);
+	if (pRuns)
+	{
+		SpriteMesh mesh;
+		mesh.build(*pRuns);
+		setMesh(sprite, mesh);
+	}
+	return sprite;
+}
+
+void SpriteAtlas::setMesh(int sprite, const SpriteMesh& mesh)
+{
+	// Updated in place, so draws already queued with the old one stay valid.
+	if ((int)meshes.size() <= sprite)
+		meshes.resize(frames.size());
+	if (meshes[sprite])
+		*meshes[sprite] = mesh;
+	else if (!mesh.isEmpty())
+		meshes[sprite] = std::make_unique<SpriteMesh>(mesh);
+}
+
+void SpriteAtlas::describeFrame(int sprite, const SDL_Surface* pSurface, const SDL_Rect& rect)
+{
+	// A rectangle from a table older than the pixels can reach past them. The runs would
+	// read outside the surface then, so the sprite keeps what it had.
+	if (!insideSurface(rect, pSurface))
+		return;
+
+	// Without alpha in the top byte there are no runs: the sprite is blended, as a quad.
+	SpriteRuns runs;
+	if (pSurface->format->Amask == 0xFF000000)
+		runs.build((const Uint8*)pSurface->pixels + rect.y * pSurface->pitch + rect.x * 4, rect.w, rect.h, pSurface->pitch);
+	frames[sprite].alpha = runs.alphaKind();
+	SpriteMesh mesh;
+	mesh.build(runs);
+	setMesh(sprite, mesh);
+}
+
+void SpriteAtlas::draw(int sprite, const SDL_FRect& dst, uint8_t layer, float angle, SDL_Color tint, SDL_BlendMode blend)
+{
+	const SpriteFrame& f = frames[sprite];
+	float scaleX = dst.w / f.sourceW;
+	float scaleY = dst.h / f.sourceH;
+
+	SDL_FRect trimmed = { dst.x + f.offsetX * scaleX, dst.y + f.offsetY * scaleY, f.rect.w * scaleX, f.rect.h * scaleY };
+	SDL_FPoint pivot = { (f.pivotX * f.sourceW - f.offsetX) * scaleX, (f.pivotY * f.sourceH - f.offsetY) * scaleY };
+	const SpriteMesh* pMesh = sprite < (int)meshes.size() ? meshes[sprite].get() : nullptr;
+	spriteBatch.drawRotated(f.textureSlot, f.rect, trimmed, layer, angle, pivot, tint, blend, f.alpha, pMesh);
+}
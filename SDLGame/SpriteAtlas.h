@@ -0,0 +1,140 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "AssetCache.h"
+#include "CollisionMask.h"
+#include "CollisionShape.h"
+#include "SpriteBatch.h"
+#include "SpriteMesh.h"
+#include "SpriteRuns.h"
+
+class ThreadPool;
+struct AtlasPage;
+struct SpriteEntry;
+
+// Where a sprite lives: a texture slot in the batch, the part of the texture it uses,
+// and how that (trimmed) part sits inside the original image.
+struct SpriteFrame
+{
+	int textureSlot = SpriteBatch::noTexture;
+	SDL_Rect rect = { 0, 0, 0, 0 }; // in the texture
+	float u0 = 0, v0 = 0, u1 = 0, v1 = 0;
+	int offsetX = 0, offsetY = 0;   // top-left of rect inside the original image
+	int sourceW = 0, sourceH = 0;   // original image size
+	float pivotX = 0.5f, pivotY = 0.5f;
+	AlphaKind alpha = AlphaKind::Translucent; // of the pixels in rect
+};
+
+// Resolves sprite names to atlas sub-rectangles.
+// With a packed atlas (see Tools/AtlasPacker.cpp) a whole frame draws from one or two
+// textures. Sprites that aren't in the atlas, or every sprite if there is no atlas,
+// are loaded from their own PNG the first time they are asked for, so the game
+// still runs straight from Assets/. Textures come from the AssetCache, which holds one
+// reference per texture for as long as the atlas uses it.
+class SpriteAtlas
+{
+public:
+	SpriteAtlas(SpriteBatch& batch, AssetCache& cache);
+	~SpriteAtlas();
+
+	SpriteAtlas(const SpriteAtlas&) = delete;
+	SpriteAtlas& operator=(const SpriteAtlas&) = delete;
+
+	// Loads the sprite table and its pages, relative to the asset root.
+	// Returns false if there is no usable atlas.
+	bool loadPacked(const std::string& tableFile = "Atlas/atlas.txt");
+
+	// Loads the given images (paths as from ImageLoader::listImages) that aren't already
+	// known, decoding them on the pool while this thread uploads the finished ones
+	// (see AssetCache::acquireTextures). Returns how many were added.
+	int preload(const std::vector<std::string>& paths, ThreadPool& pool);
+
+	// Sprite id for a name such as "Meteors/meteorBrown_big1", or -1 if it can't be found.
+	// Look names up once and keep the ids; this does a hash lookup and may load a file.
+	int find(const std::string& name);
+
+	const SpriteFrame& frame(int sprite) const { return frames[sprite]; }
+
+	// The longer side of every sprite's original image, for sizing broadphase cells
+	// (SpatialHash::cellSizeFor). With a packed atlas that covers all of Assets/,
+	// otherwise only the images loaded so far.
+	std::vector<float> spriteSizes() const;
+
+	// The sprite's collision mask, covering its original image (sourceW x sourceH), or
+	// nullptr if it has none. Loaded the first time it's asked for, from the pack when
+	// possible. The pointer stays valid, and hot reload keeps the mask current, until clear().
+	const CollisionMask* collisionMask(int sprite);
+
+	// The sprite's collision shapes, in the same pixels as its mask, or nullptr if it has
+	// nothing solid. Taken from the sprite table when it has them, otherwise worked out
+	// from the mask the first time they're asked for. Valid until clear(), like the mask.
+	const CollisionShape* collisionShape(int sprite);
+
+	int spriteCount() const { return (int)frames.size(); }
+	int textureCount() const { return (int)textures.size(); }
+	bool isPacked() const { return packed; }
+	SpriteBatch& batch() const { return spriteBatch; }
+
+	// Forgets every sprite and hands its textures back to the cache. Ids from find() become invalid.
+	void clear();
+
+	// Hot reload (see HotReloader). Sprite ids and cache handles stay valid through both.
+	enum class ReloadResult
+	{
+		Updated,
+		NotUsed,     // the atlas doesn't draw this image
+		NeedsRepack, // patched what fits; the image outgrew its place in the atlas
+		Failed,
+	};
+
+	// Puts new pixels for an image (path under the asset root) wherever the atlas uses
+	// them: the whole texture of a loose sprite or atlas page, or just the sprite's
+	// rectangle on its atlas page. Frees the surface. Pass surfaces already in
+	// textureFormat() to avoid a conversion here.
+	ReloadResult reloadImage(const std::string& path, SDL_Surface* pSurface);
+
+	// Re-reads the sprite table after the atlas was repacked, moving sprites to their new rectangles.
+	ReloadResult reloadTable();
+
+	const std::string& tableFile() const { return tablePath; }
+	Uint32 textureFormat() const { return ImageLoader::textureFormat(spriteBatch.renderer()); }
+
+	// Queues a sprite so that its original, untrimmed image covers dst.
+	// angle is in degrees clockwise around the sprite's pivot. Sprites with a SpriteMesh
+	// are drawn as it where the batch can.
+	void draw(int sprite, const SDL_FRect& dst, uint8_t layer = 0, float angle = 0.0f,
+		SDL_Color tint = { 255, 255, 255, 255 }, SDL_BlendMode blend = SDL_BLENDMODE_BLEND);
+
+private:
+	int addFrame(const std::string& name, const SpriteFrame& frame);
+	int loadLoose(const std::string& name);
+	int addLoose(const std::string& name, AssetHandle texture);
+	int addTexture(AssetHandle texture);
+	void addPackedFrame(const SpriteEntry& entry, const AtlasPage& page);
+	void setMesh(int sprite, const SpriteMesh& mesh);
+	// Works out the class and mesh of a sprite again from the new pixels of its rect.
+	// Leaves them alone if rect isn't inside the surface.
+	void describeFrame(int sprite, const SDL_Surface* pSurface, const SDL_Rect& rect);
+
+	struct UsedTexture
+	{
+		int slot;
+		AssetHandle handle;
+		std::unique_ptr<SpriteRuns> pRuns; // for the blitter, with the cache's kept pixels
+	};
+
+	SpriteBatch& spriteBatch;
+	AssetCache& assetCache;
+	bool packed = false;
+	std::string tablePath;
+	std::vector<int> pageSlots;
+	std::vector<SpriteFrame> frames;
+	std::vector<std::string> names; // by sprite id
+	std::unordered_map<std::string, int> byName;
+	std::vector<std::unique_ptr<CollisionMask>> masks; // by sprite id, null until loaded
+	std::vector<std::unique_ptr<CollisionShape>> shapes; // likewise; set up front from the sprite table
+	std::vector<std::unique_ptr<SpriteMesh>> meshes;     // by sprite id, null for sprites drawn as quads
+	std::vector<UsedTexture> textures;
+};
@@ -0,0 +1,321 @@
+#include "SpriteBatch.h"
+#include <cmath>
+#include "RadixSort.h"
+#include "SoftwareBlitter.h"
+#include "SpriteMesh.h"
+
+namespace
+{
+	// Small number per blend mode for the sort key. Custom blend modes share a value;
+	// runs are split on the actual blend mode, so that only costs an extra batch.
+	uint32_t blendKey(SDL_BlendMode blend)
+	{
+		switch (blend)
+		{
+		case SDL_BLENDMODE_NONE: return 0;
+		case SDL_BLENDMODE_BLEND: return 1;
+		case SDL_BLENDMODE_ADD: return 2;
+		case SDL_BLENDMODE_MOD: return 3;
+		default: return 4;
+		}
+	}
+
+	// Blending changes nothing under an opaque sprite drawn at full alpha.
+	SDL_BlendMode cheapestBlend(SDL_BlendMode blend, SDL_Color tint, AlphaKind alpha)
+	{
+		return blend == SDL_BLENDMODE_BLEND && tint.a == 255 && alpha == AlphaKind::Opaque ? SDL_BLENDMODE_NONE : blend;
+	}
+
+	bool sameColor(SDL_Color a, SDL_Color b)
+	{
+		return a.r == b.r && a.g == b.g && a.b == b.b && a.a == b.a;
+	}
+}
+
+SpriteBatch::SpriteBatch(SDL_Renderer* pRenderer) : pRenderer(pRenderer)
+{
+}
+
+int SpriteBatch::addTexture(SDL_Texture* pTexture, SDL_Surface* pPixels, const SpriteRuns* pRuns)
+{
+	int width = 1, height = 1;
+	SDL_QueryTexture(pTexture, nullptr, nullptr, &width, &height);
+	TextureSlot slot = { pTexture, pPixels, pPixels ? pRuns : nullptr, 1.0f / width, 1.0f / height };
+
+	if (!freeSlots.empty())
+	{
+		int index = freeSlots.back();
+		freeSlots.pop_back();
+		textures[index] = slot;
+		return index;
+	}
+	textures.push_back(slot);
+	return (int)textures.size() - 1;
+}
+
+void SpriteBatch::replaceTexture(int slot, SDL_Texture* pTexture, SDL_Surface* pPixels, const SpriteRuns* pRuns)
+{
+	if (texture(slot) == nullptr)
+		return;
+
+	int width = 1, height = 1;
+	SDL_QueryTexture(pTexture, nullptr, nullptr, &width, &height);
+	textures[slot] = { pTexture, pPixels, pPixels ? pRuns : nullptr, 1.0f / width, 1.0f / height };
+}
+
+void SpriteBatch::removeTexture(int slot)
+{
+	if (slot < 0 || slot >= (int)textures.size() || textures[slot].pTexture == nullptr)
+		return;
+
+	// Turn queued draws that use it into invisible rectangles so a flush never touches a destroyed texture.
+	// They blend, since an opaque sprite's draw may have had blending turned off.
+	for (Command& command : commands)
+	{
+		if (command.textureSlot == slot)
+		{
+			command.textureSlot = noTexture;
+			command.color.a = 0;
+			command.blend = SDL_BLENDMODE_BLEND;
+			command.pMesh = nullptr;
+		}
+	}
+	textures[slot] = { nullptr, nullptr, nullptr, 1.0f, 1.0f };
+	freeSlots.push_back(slot);
+}
+
+void SpriteBatch::draw(int textureSlot, const SDL_Rect& src, const SDL_FRect& dst, uint8_t layer, float angle, SDL_Color tint, SDL_BlendMode blend,
+	AlphaKind alpha)
+{
+	if (texture(textureSlot) == nullptr)
+		return;
+	push({ dst, src, angle, { dst.w * 0.5f, dst.h * 0.5f }, tint, cheapestBlend(blend, tint, alpha), alpha, textureSlot, nullptr }, layer);
+}
+
+void SpriteBatch::drawRotated(int textureSlot, const SDL_Rect& src, const SDL_FRect& dst, uint8_t layer, float angle, SDL_FPoint center, SDL_Color tint, SDL_BlendMode blend,
+	AlphaKind alpha, const SpriteMesh* pMesh)
+{
+	if (texture(textureSlot) == nullptr)
+		return;
+	if (pMesh && pMesh->isEmpty())
+		pMesh = nullptr;
+	push({ dst, src, angle, center, tint, cheapestBlend(blend, tint, alpha), alpha, textureSlot, pMesh }, layer);
+}
+
+void SpriteBatch::drawRect(const SDL_FRect& dst, SDL_Color color, uint8_t layer, SDL_BlendMode blend)
+{
+	push({ dst, { 0, 0, 0, 0 }, 0.0f, { 0.0f, 0.0f }, color, cheapestBlend(blend, color, AlphaKind::Opaque), AlphaKind::Opaque, noTexture, nullptr }, layer);
+}
+
+void SpriteBatch::push(const Command& command, uint8_t layer)
+{
+	uint32_t key = (uint32_t)layer << 24 | blendKey(command.blend) << 16 | ((uint32_t)(command.textureSlot + 1) & 0xFFFF);
+	order.push_back((uint64_t)key << 32 | (uint32_t)commands.size());
+	commands.push_back(command);
+}
+
+void SpriteBatch::countPixels(const Command& command, bool meshed)
+{
+	float quad = command.dst.w * command.dst.h;
+	stats.quadPixels += quad;
+	stats.drawnPixels += meshed ? command.pMesh->area() * quad / ((float)command.src.w * command.src.h) : quad;
+}
+
+void SpriteBatch::flush()
+{
+	stats = Stats();
+	stats.sprites = (int)commands.size();
+
+	radixSortByHighWord(order, scratch);
+
+	size_t runBegin = 0;
+	for (size_t i = 1; i <= order.size(); i++)
+	{
+		if (i < order.size())
+		{
+			const Command& first = commands[(uint32_t)order[runBegin]];
+			const Command& next = commands[(uint32_t)order[i]];
+			if (next.textureSlot == first.textureSlot && next.blend == first.blend)
+				continue;
+		}
+		submitRun(runBegin, i);
+		runBegin = i;
+	}
+
+	commands.clear();
+	order.clear();
+}
+
+void SpriteBatch::submitRun(size_t begin, size_t end)
+{
+	if (begin >= end)
+		return;
+	stats.batches++;
+
+	const Command& first = commands[(uint32_t)order[begin]];
+	SDL_Surface* pPixels = first.textureSlot == noTexture ? nullptr : textures[first.textureSlot].pPixels;
+	if (pBlitter && (first.textureSlot == noTexture || pPixels) && pBlitter->canDraw(pPixels, first.blend))
+	{
+		submitRunBlitter(begin, end);
+		return;
+	}
+
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+	submitRunGeometry(begin, end);
+#else
+	if (commands[(uint32_t)order[begin]].textureSlot == noTexture)
+		submitRunRects(begin, end);
+	else
+		submitRunCopy(begin, end);
+#endif
+}
+
+void SpriteBatch::submitRunCopy(size_t begin, size_t end)
+{
+	const Command& first = commands[(uint32_t)order[begin]];
+	SDL_Texture* pTexture = textures[first.textureSlot].pTexture;
+	SDL_SetTextureBlendMode(pTexture, first.blend);
+
+	SDL_Color current = first.color;
+	SDL_SetTextureColorMod(pTexture, current.r, current.g, current.b);
+	SDL_SetTextureAlphaMod(pTexture, current.a);
+
+	for (size_t i = begin; i < end; i++)
+	{
+		const Command& command = commands[(uint32_t)order[i]];
+		if (!sameColor(command.color, current))
+		{
+			current = command.color;
+			SDL_SetTextureColorMod(pTexture, current.r, current.g, current.b);
+			SDL_SetTextureAlphaMod(pTexture, current.a);
+		}
+
+		countPixels(command, false);
+		if (command.angle == 0.0f)
+			SDL_RenderCopyF(pRenderer, pTexture, &command.src, &command.dst);
+		else
+			SDL_RenderCopyExF(pRenderer, pTexture, &command.src, &command.dst, command.angle, &command.center, SDL_FLIP_NONE);
+		stats.renderCalls++;
+	}
+}
+
+void SpriteBatch::submitRunRects(size_t begin, size_t end)
+{
+	SDL_SetRenderDrawBlendMode(pRenderer, commands[(uint32_t)order[begin]].blend);
+
+	// One SDL_RenderFillRectsF per stretch of equally coloured rectangles.
+	size_t i = begin;
+	while (i < end)
+	{
+		SDL_Color color = commands[(uint32_t)order[i]].color;
+		rects.clear();
+		for (; i < end && sameColor(commands[(uint32_t)order[i]].color, color); i++)
+			rects.push_back(commands[(uint32_t)order[i]].dst);
+
+		SDL_SetRenderDrawColor(pRenderer, color.r, color.g, color.b, color.a);
+		SDL_RenderFillRectsF(pRenderer, rects.data(), (int)rects.size());
+		stats.renderCalls++;
+	}
+}
+
+void SpriteBatch::submitRunBlitter(size_t begin, size_t end)
+{
+#if SDL_VERSION_ATLEAST(2, 0, 10)
+	// The renderer may still hold draws it batched up, a clear among them; they go first.
+	SDL_RenderFlush(pRenderer);
+#endif
+
+	const Command& first = commands[(uint32_t)order[begin]];
+	SDL_Surface* pPixels = first.textureSlot == noTexture ? nullptr : textures[first.textureSlot].pPixels;
+	const SpriteRuns* pRuns = first.textureSlot == noTexture ? nullptr : textures[first.textureSlot].pRuns;
+	for (size_t i = begin; i < end; i++)
+	{
+		const Command& command = commands[(uint32_t)order[i]];
+		if (pPixels)
+		{
+			countPixels(command, false);
+			pBlitter->drawFrom(pPixels, command.src, command.dst, command.angle, command.center, command.color, command.blend, command.alpha, pRuns);
+		}
+		else
+			pBlitter->fill(command.dst, command.color, command.blend);
+	}
+	stats.blits += (int)(end - begin);
+}
+
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+void SpriteBatch::submitRunGeometry(size_t begin, size_t end)
+{
+	const Command& first = commands[(uint32_t)order[begin]];
+	SDL_Texture* pTexture = first.textureSlot == noTexture ? nullptr : textures[first.textureSlot].pTexture;
+	float inverseWidth = pTexture ? textures[first.textureSlot].inverseWidth : 0.0f;
+	float inverseHeight = pTexture ? textures[first.textureSlot].inverseHeight : 0.0f;
+
+	if (pTexture)
+	{
+		SDL_SetTextureBlendMode(pTexture, first.blend);
+		SDL_SetTextureColorMod(pTexture, 255, 255, 255);
+		SDL_SetTextureAlphaMod(pTexture, 255);
+	}
+	else
+	{
+		SDL_SetRenderDrawBlendMode(pRenderer, first.blend);
+	}
+
+	vertices.clear();
+	indices.clear();
+	for (size_t i = begin; i < end; i++)
+	{
+		const Command& command = commands[(uint32_t)order[i]];
+		bool meshed = pTexture && meshes && command.pMesh;
+		if (pTexture)
+			countPixels(command, meshed);
+
+		// Window position of a point given relative to the top-left of dst.
+		float c = 1.0f, s = 0.0f;
+		if (command.angle != 0.0f)
+		{
+			float radians = command.angle * 3.14159265f / 180.0f;
+			c = std::cos(radians);
+			s = std::sin(radians);
+		}
+		auto place = [&](float x, float y) -> SDL_FPoint
+		{
+			if (command.angle == 0.0f)
+				return { command.dst.x + x, command.dst.y + y };
+			float dx = x - command.center.x, dy = y - command.center.y;
+			return { command.dst.x + command.center.x + dx * c - dy * s, command.dst.y + command.center.y + dx * s + dy * c };
+		};
+
+		int base = (int)vertices.size();
+		if (meshed)
+		{
+			// A fan over the outline's corners, which are texels of src.
+			const SpriteMesh& mesh = *command.pMesh;
+			float scaleX = command.dst.w / command.src.w, scaleY = command.dst.h / command.src.h;
+			for (int j = 0; j < mesh.count; j++)
+			{
+				SDL_FPoint uv = { (command.src.x + mesh.x[j]) * inverseWidth, (command.src.y + mesh.y[j]) * inverseHeight };
+				vertices.push_back({ place(mesh.x[j] * scaleX, mesh.y[j] * scaleY), command.color, uv });
+			}
+			for (int j = 2; j < mesh.count; j++)
+				indices.insert(indices.end(), { base, base + j - 1, base + j });
+			continue;
+		}
+
+		float u0 = command.src.x * inverseWidth;
+		float v0 = command.src.y * inverseHeight;
+		float u1 = (command.src.x + command.src.w) * inverseWidth;
+		float v1 = (command.src.y + command.src.h) * inverseHeight;
+		SDL_FPoint corners[4] = { place(0.0f, 0.0f), place(command.dst.w, 0.0f), place(command.dst.w, command.dst.h), place(0.0f, command.dst.h) };
+
+		vertices.push_back({ corners[0], command.color, { u0, v0 } });
+		vertices.push_back({ corners[1], command.color, { u1, v0 } });
+		vertices.push_back({ corners[2], command.color, { u1, v1 } });
+		vertices.push_back({ corners[3], command.color, { u0, v1 } });
+		indices.insert(indices.end(), { base, base + 1, base + 2, base, base + 2, base + 3 });
+	}
+
+	SDL_RenderGeometry(pRenderer, pTexture, vertices.data(), (int)vertices.size(), indices.data(), (int)indices.size());
+	stats.renderCalls++;
+}
+#endif
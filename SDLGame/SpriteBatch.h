@@ -0,0 +1,144 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <SDL.h>
+#include "AlphaKind.h"
+
+class SoftwareBlitter;
+class SpriteRuns;
+struct SpriteMesh;
+
+// Collects a frame's worth of sprite draws and submits them in as few renderer calls as possible.
+//
+// Draws are sorted by layer, then blend mode, then texture (a stable radix sort, so
+// sprites with the same state keep the order they were drawn in). Each run of
+// draws that share a texture and blend mode becomes one SDL_RenderGeometry call
+// on SDL 2.0.18+, or a tight loop of SDL_RenderCopyF calls with no state changes
+// in between on older SDL.
+//
+// With a SoftwareBlitter (setBlitter) runs it can draw go to it instead, into its
+// surface, and the rest to the renderer, which should then be a software renderer on
+// the same surface (SDL_CreateSoftwareRenderer) so both end up in one picture.
+//
+// Draws say how their sprite uses alpha (AlphaKind). Opaque sprites drawn with BLEND at
+// full alpha are drawn with blending off instead, by the renderer and the blitter alike,
+// and the blitter draws binary-alpha ones as masked copies. Translucent sprites, and
+// anything tinted translucent, are blended.
+//
+// A draw can also give the sprite's SpriteMesh, an outline around its visible texels.
+// SDL_RenderGeometry then fills that instead of the whole quad, which saves fill rate
+// on big round sprites; Stats counts the pixels it leaves out. Older SDL, and the
+// blitter, which skips clear pixels by itself, draw quads.
+//
+// Layers decide what is drawn on top. Within a layer, sprites are grouped by
+// texture, so sprites in the same layer should not rely on overlapping each other in a
+// particular order.
+class SpriteBatch
+{
+public:
+	static const int noTexture = -1;
+
+	SpriteBatch(SDL_Renderer* pRenderer);
+
+	SDL_Renderer* renderer() const { return pRenderer; }
+
+	// Registers a texture for drawing and returns its slot. The batch does not own the texture.
+	// pPixels, if given, is the same image in memory, which the blitter draws from; it
+	// must stay valid while the slot uses it. Slots without pixels are left to the renderer.
+	// pRuns, if given, are that image's SpriteRuns, so the blitter can skip its
+	// transparent pixels; they must stay valid as long as the pixels.
+	int addTexture(SDL_Texture* pTexture, SDL_Surface* pPixels = nullptr, const SpriteRuns* pRuns = nullptr);
+
+	// Forgets a texture slot so it can be reused. Call before destroying the texture.
+	void removeTexture(int slot);
+
+	// Points a slot at a different texture, e.g. one reloaded at a new size. Queued draws keep their source rectangles.
+	void replaceTexture(int slot, SDL_Texture* pTexture, SDL_Surface* pPixels = nullptr, const SpriteRuns* pRuns = nullptr);
+
+	SDL_Texture* texture(int slot) const { return slot >= 0 && slot < (int)textures.size() ? textures[slot].pTexture : nullptr; }
+
+	// Draws in software from now on, wherever the blitter can. Null goes back to the renderer alone.
+	void setBlitter(SoftwareBlitter* pBlitter) { this->pBlitter = pBlitter; }
+	SoftwareBlitter* blitter() const { return pBlitter; }
+
+	// Queues a textured quad. src is in texels, dst in window pixels, angle in degrees
+	// clockwise around the centre of dst. alpha is how the texels in src use alpha.
+	void draw(int textureSlot, const SDL_Rect& src, const SDL_FRect& dst, uint8_t layer = 0,
+		float angle = 0.0f, SDL_Color tint = { 255, 255, 255, 255 }, SDL_BlendMode blend = SDL_BLENDMODE_BLEND,
+		AlphaKind alpha = AlphaKind::Translucent);
+
+	// Same, rotating around center (relative to the top-left of dst) instead of the middle of dst.
+	// pMesh, if given, outlines the visible texels of src in src's pixels; it must stay
+	// valid until the next flush().
+	void drawRotated(int textureSlot, const SDL_Rect& src, const SDL_FRect& dst, uint8_t layer, float angle, SDL_FPoint center,
+		SDL_Color tint = { 255, 255, 255, 255 }, SDL_BlendMode blend = SDL_BLENDMODE_BLEND, AlphaKind alpha = AlphaKind::Translucent,
+		const SpriteMesh* pMesh = nullptr);
+
+	// Queues a solid rectangle.
+	void drawRect(const SDL_FRect& dst, SDL_Color color, uint8_t layer = 0, SDL_BlendMode blend = SDL_BLENDMODE_BLEND);
+
+	// Draws with the meshes draws give (the default), or ignores them and draws quads.
+	void setMeshes(bool enabled) { meshes = enabled; }
+	bool meshesEnabled() const { return meshes; }
+
+	// Sorts and submits everything queued since the last flush.
+	void flush();
+
+	// Counters for the last flush.
+	struct Stats
+	{
+		int sprites = 0;     // draws queued
+		int batches = 0;     // runs of draws sharing texture and blend mode
+		int renderCalls = 0; // SDL_Render* draw calls issued
+		int blits = 0;       // draws done by the blitter instead
+		double quadPixels = 0.0;  // window pixels under the textured draws' quads
+		double drawnPixels = 0.0; // the part of those sent to be filled; less with meshes
+	};
+	const Stats& lastStats() const { return stats; }
+
+private:
+	struct Command
+	{
+		SDL_FRect dst;
+		SDL_Rect src;
+		float angle;
+		SDL_FPoint center; // rotation centre relative to dst
+		SDL_Color color;
+		SDL_BlendMode blend;
+		AlphaKind alpha;
+		int textureSlot;
+		const SpriteMesh* pMesh; // null to draw the quad
+	};
+
+	struct TextureSlot
+	{
+		SDL_Texture* pTexture;
+		SDL_Surface* pPixels;
+		const SpriteRuns* pRuns;
+		float inverseWidth;
+		float inverseHeight;
+	};
+
+	void push(const Command& command, uint8_t layer);
+	void countPixels(const Command& command, bool meshed);
+	void submitRun(size_t begin, size_t end);
+	void submitRunCopy(size_t begin, size_t end);
+	void submitRunRects(size_t begin, size_t end);
+	void submitRunBlitter(size_t begin, size_t end);
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+	void submitRunGeometry(size_t begin, size_t end);
+	std::vector<SDL_Vertex> vertices;
+	std::vector<int> indices;
+#endif
+
+	SDL_Renderer* pRenderer;
+	SoftwareBlitter* pBlitter = nullptr;
+	bool meshes = true;
+	std::vector<TextureSlot> textures;
+	std::vector<int> freeSlots;
+	std::vector<Command> commands;
+	std::vector<uint64_t> order;   // sort key << 32 | command index
+	std::vector<uint64_t> scratch; // radix sort buffer
+	std::vector<SDL_FRect> rects;
+	Stats stats;
+};
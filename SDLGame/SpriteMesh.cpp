@@ -0,0 +1,57 @@
+#include "SpriteMesh.h"
+#include <vector>
+#include "ConvexHull.h"
+
+void SpriteMesh::build(const SpriteRuns& runs)
+{
+	*this = SpriteMesh();
+	if (runs.isEmpty())
+		return;
+
+	// Only the ends of each row's first and last run can be on the hull; take the corners of both.
+	const uint32_t* pRowStarts = runs.data().data();
+	const uint32_t* pRuns = pRowStarts + runs.height() + 1;
+	std::vector<HullPoint> points;
+	for (int y = 0; y < runs.height(); y++)
+	{
+		if (pRowStarts[y] == pRowStarts[y + 1])
+			continue;
+		uint32_t first = pRuns[pRowStarts[y]], last = pRuns[pRowStarts[y + 1] - 1];
+		float left = (float)SpriteRuns::runX(first), right = (float)(SpriteRuns::runX(last) + SpriteRuns::runLength(last));
+		points.push_back({ left, (float)y });
+		points.push_back({ left, (float)(y + 1) });
+		points.push_back({ right, (float)y });
+		points.push_back({ right, (float)(y + 1) });
+	}
+	if (points.empty())
+		return;
+
+	// Simplifying grows the hull, so it may poke out of the rectangle, where the texels
+	// belong to other sprites; clipping keeps it inside.
+	std::vector<HullPoint> hull = convexHull(points);
+	if (!simplifyHull(hull, hullVertices))
+		return;
+	clipHull(hull, 0.0f, 0.0f, (float)runs.width(), (float)runs.height());
+	if (hull.size() < 3 || hull.size() > (size_t)maxVertices)
+		return;
+	if (hullArea(hull) > (1.0f - minSaving) * runs.width() * runs.height())
+		return;
+
+	count = (int)hull.size();
+	for (int i = 0; i < count; i++)
+	{
+		x[i] = hull[i].x;
+		y[i] = hull[i].y;
+	}
+}
+
+float SpriteMesh::area() const
+{
+	float twice = 0.0f;
+	for (int i = 0; i < count; i++)
+	{
+		int next = i + 1 < count ? i + 1 : 0;
+		twice += x[i] * y[next] - x[next] * y[i];
+	}
+	return (twice < 0.0f ? -twice : twice) * 0.5f;
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include "SpriteRuns.h"
+
+// A convex outline of at most maxVertices corners around every pixel of a sprite that
+// isn't fully transparent. SpriteBatch draws it as a triangle fan instead of the
+// sprite's quad, so the clear corners of round sprites such as the big meteors aren't
+// filled for nothing. Tools/AtlasPacker.cpp works one out for each sprite's trimmed
+// rectangle and stores it in the sprite table; x and y are in that rectangle's pixels.
+//
+// Sprites the outline would hardly shrink get none and stay quads.
+struct SpriteMesh
+{
+	static constexpr int maxVertices = 12;
+
+	// The hull is cut down to this many corners, then clipped to the rectangle, which
+	// can add one per side.
+	static constexpr int hullVertices = 8;
+
+	// Outlines that leave out less of the rectangle than this aren't worth the triangles.
+	static constexpr float minSaving = 0.1f;
+
+	int count = 0; // 0 to draw the quad
+	float x[maxVertices] = {}, y[maxVertices] = {}; // in order around the outline
+
+	bool isEmpty() const { return count == 0; }
+
+	// Works the outline out from the runs of the rectangle. Empty if it isn't worth it.
+	void build(const SpriteRuns& runs);
+
+	// In the rectangle's pixels.
+	float area() const;
+};
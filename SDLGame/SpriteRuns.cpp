@@ -0,0 +1,127 @@
+#include "SpriteRuns.h"
+#include <algorithm>
+
+namespace
+{
+	uint32_t makeRun(int x, int length, bool opaque)
+	{
+		return (uint32_t)x | (uint32_t)length << 15 | (opaque ? 1u << 30 : 0);
+	}
+}
+
+void SpriteRuns::clear()
+{
+	imageWidth = 0;
+	imageHeight = 0;
+	words.clear();
+}
+
+void SpriteRuns::build(const void* pixels, int width, int height, int pitch)
+{
+	clear();
+	if (width <= 0 || height <= 0 || width > maxWidth)
+		return;
+
+	// Row starts first, runs appended after them as each row is scanned.
+	imageWidth = width;
+	imageHeight = height;
+	words.assign(height + 1, 0);
+	for (int y = 0; y < height; y++)
+	{
+		words[y] = (uint32_t)(words.size() - (height + 1));
+		const uint32_t* pPixels = (const uint32_t*)((const uint8_t*)pixels + (size_t)y * pitch);
+		int x = 0;
+		while (x < width)
+		{
+			uint32_t alpha = pPixels[x] >> 24;
+			if (alpha == 0)
+			{
+				x++;
+				continue;
+			}
+			bool opaque = alpha == 0xFF;
+			int start = x;
+			for (x++; x < width; x++)
+			{
+				alpha = pPixels[x] >> 24;
+				if (alpha == 0 || (alpha == 0xFF) != opaque)
+					break;
+			}
+			words.push_back(makeRun(start, x - start, opaque));
+		}
+	}
+	words[height] = (uint32_t)(words.size() - (height + 1));
+}
+
+bool SpriteRuns::assign(int width, int height, const uint32_t* pWords, size_t wordCount)
+{
+	clear();
+	if (width < 0 || height < 0 || width > maxWidth || (width == 0) != (height == 0))
+		return false;
+	if (width == 0)
+		return wordCount == 0;
+	if (wordCount < (size_t)height + 1 || pWords[height] != wordCount - (height + 1))
+		return false;
+
+	// Every row's runs must lie inside it, in order, without overlapping, so drawRow()
+	// can trust them.
+	const uint32_t* pRuns = pWords + height + 1;
+	for (int y = 0; y < height; y++)
+	{
+		if (pWords[y] > pWords[y + 1])
+			return false;
+		int end = 0;
+		for (uint32_t i = pWords[y]; i < pWords[y + 1]; i++)
+		{
+			if (pRuns[i] >> 31 || runX(pRuns[i]) < end || runLength(pRuns[i]) == 0 || runX(pRuns[i]) + runLength(pRuns[i]) > width)
+				return false;
+			end = runX(pRuns[i]) + runLength(pRuns[i]);
+		}
+	}
+
+	imageWidth = width;
+	imageHeight = height;
+	words.assign(pWords, pWords + wordCount);
+	return true;
+}
+
+size_t SpriteRuns::coveredPixels() const
+{
+	if (isEmpty())
+		return 0;
+	size_t covered = 0;
+	for (const uint32_t* pRun = firstRun(); pRun != words.data() + words.size(); pRun++)
+		covered += runLength(*pRun);
+	return covered;
+}
+
+AlphaKind SpriteRuns::alphaKind() const
+{
+	if (isEmpty())
+		return AlphaKind::Translucent;
+	for (const uint32_t* pRun = firstRun(); pRun != words.data() + words.size(); pRun++)
+	{
+		if (!runIsOpaque(*pRun))
+			return AlphaKind::Translucent;
+	}
+	return coveredPixels() == (size_t)imageWidth * imageHeight ? AlphaKind::Opaque : AlphaKind::Binary;
+}
+
+void SpriteRuns::drawRow(uint32_t* pDst, const uint32_t* pRow, int y, int x, int count, BlitKernel opaque, BlitKernel translucent, uint32_t color) const
+{
+	const uint32_t* pBegin = firstRun() + words[y];
+	const uint32_t* pEnd = firstRun() + words[y + 1];
+	int end = x + count;
+
+	// The first run that reaches past x; the ones before it are left of the span. Whole
+	// rows, the usual case, start at the first.
+	const uint32_t* pRun = pBegin;
+	if (pRun != pEnd && x > runX(*pRun))
+		pRun = std::upper_bound(pBegin, pEnd, x, [](int column, uint32_t run) { return column < runX(run) + runLength(run); });
+	for (; pRun != pEnd && runX(*pRun) < end; pRun++)
+	{
+		int first = std::max(x, runX(*pRun)), last = std::min(end, runX(*pRun) + runLength(*pRun));
+		BlitKernel kernel = runIsOpaque(*pRun) ? opaque : translucent;
+		kernel(pDst + (first - x), pRow + first, last - first, color);
+	}
+}
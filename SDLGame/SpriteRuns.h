@@ -0,0 +1,63 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "AlphaKind.h"
+#include "BlitKernels.h"
+
+// The pixels of an image worth drawing, as runs along each row: opaque runs (alpha 255)
+// and translucent ones (anything between). The fully transparent pixels are the gaps
+// between runs, so drawing a row with drawRow() never reads or writes them, and opaque
+// runs can be copied instead of blended. Most sprites are mostly one or the other, so
+// the cost of drawing them follows the pixels they cover rather than their box.
+//
+// Each run is one word: x in bits 0-14, length in bits 15-29 and bit 30 set for opaque.
+// data() holds height + 1 row starts (the run index where each row begins, then the
+// total) followed by the runs, sorted by x within each row.
+//
+// Tools/AssetPackBuilder.cpp builds runs for every image and stores them in the pack.
+class SpriteRuns
+{
+public:
+	// Wider images can't be described and are left empty.
+	static constexpr int maxWidth = 0x7FFF;
+
+	// Builds the runs from 32-bit pixels with alpha in the top byte (ARGB8888, ABGR8888).
+	void build(const void* pixels, int width, int height, int pitch);
+
+	// Takes the words of runs built elsewhere, as data() returns them. Returns false
+	// (and leaves the runs empty) if they don't describe an image of this size.
+	bool assign(int width, int height, const uint32_t* pWords, size_t wordCount);
+
+	void clear();
+	bool isEmpty() const { return words.empty(); }
+
+	int width() const { return imageWidth; }
+	int height() const { return imageHeight; }
+
+	// Pixels inside runs: the ones drawRow() touches when drawing whole rows.
+	size_t coveredPixels() const;
+
+	// Opaque if one opaque run fills every row, binary if every run is opaque.
+	// Translucent when empty, which is always safe.
+	AlphaKind alphaKind() const;
+
+	// Draws columns [x, x + count) of row y: pRow is that row of the image and pDst the
+	// pixel that column x lands on. Opaque runs go through opaque, translucent ones
+	// through translucent, both with color; nothing else is touched.
+	void drawRow(uint32_t* pDst, const uint32_t* pRow, int y, int x, int count, BlitKernel opaque, BlitKernel translucent, uint32_t color) const;
+
+	// Row starts and runs, for storing in a pack.
+	const std::vector<uint32_t>& data() const { return words; }
+
+	static int runX(uint32_t run) { return run & 0x7FFF; }
+	static int runLength(uint32_t run) { return run >> 15 & 0x7FFF; }
+	static bool runIsOpaque(uint32_t run) { return (run >> 30) & 1; }
+
+private:
+	const uint32_t* firstRun() const { return words.data() + imageHeight + 1; }
+
+	int imageWidth = 0;
+	int imageHeight = 0;
+	std::vector<uint32_t> words;
+};
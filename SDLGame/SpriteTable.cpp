@@ -0,0 +1,144 @@
+#include "SpriteTable.h"
+#include <fstream>
+#include <sstream>
+
+namespace
+{
+	const int tableVersion = 1;
+}
+
+bool SpriteTable::read(const std::string& path)
+{
+	pages.clear();
+	sprites.clear();
+	byName.clear();
+
+	std::ifstream in(path);
+	if (!in)
+		return false;
+
+	std::string line;
+	int version = 0;
+	while (std::getline(in, line))
+	{
+		std::istringstream fields(line);
+		std::string kind;
+		if (!(fields >> kind) || kind[0] == '#')
+			continue;
+
+		if (kind == "atlas")
+		{
+			fields >> version;
+		}
+		else if (kind == "page")
+		{
+			AtlasPage page;
+			if (!(fields >> page.file >> page.width >> page.height))
+				break;
+			pages.push_back(page);
+		}
+		else if (kind == "sprite")
+		{
+			SpriteEntry sprite;
+			if (!(fields >> sprite.name >> sprite.page >> sprite.x >> sprite.y >> sprite.w >> sprite.h
+				>> sprite.offsetX >> sprite.offsetY >> sprite.sourceW >> sprite.sourceH >> sprite.pivotX >> sprite.pivotY))
+				break;
+			if (sprite.page < 0 || sprite.page >= (int)pages.size())
+				break;
+			std::string alpha;
+			if (fields >> alpha && !parseAlphaKind(alpha, sprite.alpha))
+				break;
+			sprites.push_back(sprite);
+		}
+		else if (kind == "shape")
+		{
+			if (sprites.empty())
+				break;
+			CollisionShape& shape = sprites.back().shape;
+			if (!(fields >> shape.circleX >> shape.circleY >> shape.radius >> shape.boxX >> shape.boxY
+				>> shape.boxHalfW >> shape.boxHalfH >> shape.boxAngle >> shape.hullCount))
+				break;
+			if (shape.hullCount < 1 || shape.hullCount > CollisionShape::maxHullPoints)
+				break;
+			int point = 0;
+			while (point < shape.hullCount && fields >> shape.hullX[point] >> shape.hullY[point])
+				point++;
+			if (point < shape.hullCount)
+				break;
+			shape.width = (float)sprites.back().sourceW;
+			shape.height = (float)sprites.back().sourceH;
+		}
+		else if (kind == "mesh")
+		{
+			if (sprites.empty())
+				break;
+			SpriteMesh& mesh = sprites.back().mesh;
+			if (!(fields >> mesh.count) || mesh.count < 3 || mesh.count > SpriteMesh::maxVertices)
+				break;
+			int point = 0;
+			while (point < mesh.count && fields >> mesh.x[point] >> mesh.y[point])
+				point++;
+			if (point < mesh.count)
+				break;
+		}
+	}
+
+	if (version != tableVersion || !in.eof())
+	{
+		pages.clear();
+		sprites.clear();
+		return false;
+	}
+	buildIndex();
+	return true;
+}
+
+bool SpriteTable::write(const std::string& path) const
+{
+	std::ofstream out(path);
+	if (!out)
+		return false;
+
+	out << "# Generated by AtlasPacker. Do not edit.\n";
+	out << "atlas " << tableVersion << "\n";
+	for (const AtlasPage& page : pages)
+		out << "page " << page.file << " " << page.width << " " << page.height << "\n";
+	for (const SpriteEntry& sprite : sprites)
+	{
+		out << "sprite " << sprite.name << " " << sprite.page << " " << sprite.x << " " << sprite.y << " " << sprite.w << " " << sprite.h
+			<< " " << sprite.offsetX << " " << sprite.offsetY << " " << sprite.sourceW << " " << sprite.sourceH
+			<< " " << sprite.pivotX << " " << sprite.pivotY << " " << alphaKindName(sprite.alpha) << "\n";
+
+		const CollisionShape& shape = sprite.shape;
+		if (!shape.isEmpty())
+		{
+			out << "shape " << shape.circleX << " " << shape.circleY << " " << shape.radius << " " << shape.boxX << " " << shape.boxY
+				<< " " << shape.boxHalfW << " " << shape.boxHalfH << " " << shape.boxAngle << " " << shape.hullCount;
+			for (int i = 0; i < shape.hullCount; i++)
+				out << " " << shape.hullX[i] << " " << shape.hullY[i];
+			out << "\n";
+		}
+
+		const SpriteMesh& mesh = sprite.mesh;
+		if (mesh.isEmpty())
+			continue;
+		out << "mesh " << mesh.count;
+		for (int i = 0; i < mesh.count; i++)
+			out << " " << mesh.x[i] << " " << mesh.y[i];
+		out << "\n";
+	}
+	return (bool)out;
+}
+
+int SpriteTable::find(const std::string& name) const
+{
+	auto it = byName.find(name);
+	return it == byName.end() ? -1 : it->second;
+}
+
+void SpriteTable::buildIndex()
+{
+	byName.clear();
+	for (size_t i = 0; i < sprites.size(); i++)
+		byName[sprites[i].name] = (int)i;
+}
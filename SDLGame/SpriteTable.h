@@ -0,0 +1,66 @@
+#pragma once
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "AlphaKind.h"
+#include "CollisionShape.h"
+#include "SpriteMesh.h"
+
+// The sprite table written by the atlas packer (Tools/AtlasPacker.cpp) next to its atlas pages.
+//
+// It is a small text file so it diffs nicely and can be checked by hand:
+//
+//   atlas 1
+//   page <file> <width> <height>
+//   sprite <name> <page> <x> <y> <w> <h> <offsetX> <offsetY> <sourceW> <sourceH> <pivotX> <pivotY> [<alpha>]
+//   shape <circleX> <circleY> <radius> <boxX> <boxY> <boxHalfW> <boxHalfH> <boxAngle> <hullCount> <x0> <y0> ...
+//   mesh <count> <x0> <y0> ...
+//
+// Names are the source path relative to Assets/ without ".png", e.g. "Meteors/meteorBrown_big1".
+// Sprites are trimmed: (x, y, w, h) is the opaque part of the image inside the page,
+// (offsetX, offsetY) is where that part sat in the original sourceW x sourceH image.
+// The pivot is in original image coordinates divided by its size (0.5 0.5 = centre).
+// alpha is how the trimmed part uses alpha: opaque, binary or translucent (see
+// AlphaKind.h). Tables from before it was added don't have it; those read as translucent.
+// A shape line belongs to the sprite above it: its collision shapes (see
+// CollisionShape.h) in original image pixels. Sprites with nothing solid have none.
+// A mesh line does the same for the outline it is drawn with (see SpriteMesh.h), in
+// pixels of the trimmed part. Sprites that are drawn as quads have none.
+struct AtlasPage
+{
+	std::string file; // relative to the table file
+	int width = 0;
+	int height = 0;
+};
+
+struct SpriteEntry
+{
+	std::string name;
+	int page = 0;
+	int x = 0, y = 0, w = 0, h = 0;
+	int offsetX = 0, offsetY = 0;
+	int sourceW = 0, sourceH = 0;
+	float pivotX = 0.5f, pivotY = 0.5f;
+	AlphaKind alpha = AlphaKind::Translucent;
+	CollisionShape shape; // empty if the table has none
+	SpriteMesh mesh;      // likewise
+};
+
+class SpriteTable
+{
+public:
+	std::vector<AtlasPage> pages;
+	std::vector<SpriteEntry> sprites;
+
+	// Returns false (and leaves the table empty) if the file is missing or malformed.
+	bool read(const std::string& path);
+	bool write(const std::string& path) const;
+
+	// Index into sprites, or -1. Only valid after read().
+	int find(const std::string& name) const;
+
+private:
+	void buildIndex();
+
+	std::unordered_map<std::string, int> byName;
+};
@@ -0,0 +1,19 @@
+#include "StringInterner.h"
+
+uint32_t StringInterner::intern(std::string_view text)
+{
+	auto it = ids.find(text);
+	if (it != ids.end())
+		return it->second;
+
+	uint32_t id = (uint32_t)strings.size();
+	strings.emplace_back(text);
+	ids.emplace(strings.back(), id);
+	return id;
+}
+
+uint32_t StringInterner::find(std::string_view text) const
+{
+	auto it = ids.find(text);
+	return it != ids.end() ? it->second : noId;
+}
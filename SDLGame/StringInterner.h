@@ -0,0 +1,28 @@
+#pragma once
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+// Stores each distinct string once and gives it a small dense id, so code that
+// looks things up by name (asset paths, mostly) can hash the string once and use
+// the id as an array index from then on. Ids are never reused.
+class StringInterner
+{
+public:
+	static const uint32_t noId = UINT32_MAX;
+
+	// Id for text, adding it if it's new.
+	uint32_t intern(std::string_view text);
+
+	// Id for text, or noId if it was never interned.
+	uint32_t find(std::string_view text) const;
+
+	const std::string& str(uint32_t id) const { return strings[id]; }
+	uint32_t size() const { return (uint32_t)strings.size(); }
+
+private:
+	std::deque<std::string> strings; // a deque never moves its elements, so the map's keys stay valid
+	std::unordered_map<std::string_view, uint32_t> ids;
+};
@@ -0,0 +1,34 @@
+#include "Sweep.h"
+#include <algorithm>
+
+namespace
+{
+	// Narrows [enter, exit] to the times at which low < move * t < high on one axis.
+	bool clipSlab(float low, float high, float move, float& enter, float& exit)
+	{
+		if (move == 0.0f)
+			return low < 0.0f && 0.0f < high;
+		float t0 = low / move, t1 = high / move;
+		if (t0 > t1)
+			std::swap(t0, t1);
+		enter = std::max(enter, t0);
+		exit = std::min(exit, t1);
+		return enter < exit;
+	}
+}
+
+bool sweepBounds(const Bounds& box, float dx, float dy, const Bounds& target, float& hitTime)
+{
+	// How far box can move on each axis and still overlap target, as a range of times.
+	float enter = 0.0f, exit = 1.0f;
+	if (!clipSlab(target.minX - box.maxX, target.maxX - box.minX, dx, enter, exit)
+		|| !clipSlab(target.minY - box.maxY, target.maxY - box.minY, dy, enter, exit))
+		return false;
+	hitTime = enter;
+	return true;
+}
+
+Bounds sweptBounds(float fromX, float fromY, float toX, float toY, float w, float h)
+{
+	return { std::min(fromX, toX), std::min(fromY, toY), std::max(fromX, toX) + w, std::max(fromY, toY) + h };
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+// An axis-aligned box, pixels.
+struct Bounds
+{
+	float minX, minY, maxX, maxY;
+};
+
+// Continuous collision for things that move further in one tick than they are long.
+//
+// A test at the end of each tick only sees where an object ended up, so a laser
+// bolt moving 70 pixels a tick can start above an 18-pixel meteor and end below it
+// without ever overlapping it. Running more, shorter ticks hides this at the cost of
+// the whole simulation; these tests instead check the path taken during the tick.
+
+// Whether box, moving by (dx, dy) over the tick, overlaps target at any point of the
+// move. hitTime is the fraction of the move (0 to 1) at which they first overlap; 0
+// if they already do. For two moving objects pass the difference of their moves.
+// A box of zero size makes this a segment test.
+bool sweepBounds(const Bounds& box, float dx, float dy, const Bounds& target, float& hitTime);
+
+// Bounds of everything a box of size (w, h) covers moving in a straight line from
+// (fromX, fromY) to (toX, toY), both top-left corners.
+Bounds sweptBounds(float fromX, float fromY, float toX, float toY, float w, float h);
@@ -0,0 +1,124 @@
+#include "SweepAndPrune.h"
+#include <algorithm>
+
+void SweepAndPrune::build()
+{
+	const uint32_t count = (uint32_t)size();
+
+	// Boxes past the end are gone; ids new since the last build go on the end, to be
+	// sorted into place below.
+	uint32_t previousCount = (uint32_t)order.size();
+	size_t kept = 0;
+	for (uint32_t box : order)
+	{
+		if (box < count)
+			order[kept++] = box;
+	}
+	order.resize(kept);
+	for (uint32_t box = previousCount; box < count; box++)
+		order.push_back(box);
+
+	entries.resize(count);
+	Entry* pEntries = entries.data();
+	for (uint32_t i = 0; i < count; i++)
+	{
+		uint32_t box = order[i];
+		pEntries[i] = { minY[box], maxY[box], minX[box], maxX[box], box, layerBits[box] };
+	}
+
+	// Insertion sort: about one pass when little has changed. If it turns out a lot
+	// has (the first build, or boxes added in a different order), sort from scratch.
+	const size_t moveBudget = (size_t)count * 8;
+	moves = 0;
+	for (uint32_t i = 1; i < count && moves <= moveBudget; i++)
+	{
+		Entry entry = pEntries[i];
+		uint32_t j = i;
+		while (j > 0 && pEntries[j - 1].minY > entry.minY)
+		{
+			pEntries[j] = pEntries[j - 1];
+			j--;
+		}
+		pEntries[j] = entry;
+		moves += i - j;
+	}
+	if (moves > moveBudget)
+	{
+		std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.minY < b.minY; });
+		moves = count;
+	}
+
+	for (uint32_t i = 0; i < count; i++)
+		order[i] = pEntries[i].box;
+}
+
+void SweepAndPrune::findPairs(std::vector<BoxPair>& pairs) const
+{
+	const Entry* pEntries = entries.data();
+	const size_t count = entries.size();
+	size_t written = 0;
+	for (size_t i = 0; i < count; i++)
+	{
+		// Everything from here to the first box starting below this one's bottom edge
+		// overlaps it vertically; nothing after that can.
+		size_t end = i + 1;
+		while (end < count && pEntries[end].minY < pEntries[i].maxY)
+			end++;
+		appendOverlaps(pEntries[i], pEntries + i + 1, pEntries + end, pairs, written);
+	}
+	pairs.resize(written);
+}
+
+void SweepAndPrune::findPairsBetween(uint32_t split, std::vector<BoxPair>& pairs) const
+{
+	// Sweeping the whole list would walk past every pair within each group too. Split
+	// it into the two groups, each still sorted, and sweep each against the other:
+	// first the pairs where the box in the first group starts higher (or level), then
+	// those where the one in the second group does.
+	firstGroup.clear();
+	secondGroup.clear();
+	for (const Entry& entry : entries)
+		(entry.box < split ? firstGroup : secondGroup).push_back(entry);
+
+	size_t written = 0;
+	sweepAgainst(firstGroup, secondGroup, true, pairs, written);
+	sweepAgainst(secondGroup, firstGroup, false, pairs, written);
+	pairs.resize(written);
+}
+
+void SweepAndPrune::sweepAgainst(const std::vector<Entry>& from, const std::vector<Entry>& other, bool levelToo, std::vector<BoxPair>& pairs, size_t& written)
+{
+	const Entry* pOther = other.data();
+	const size_t otherCount = other.size();
+	size_t start = 0;
+	for (const Entry& a : from)
+	{
+		// Both lists are sorted, so where other's boxes start below a only moves down.
+		while (start < otherCount && (pOther[start].minY < a.minY || (!levelToo && pOther[start].minY == a.minY)))
+			start++;
+		size_t end = start;
+		while (end < otherCount && pOther[end].minY < a.maxY)
+			end++;
+		appendOverlaps(a, pOther + start, pOther + end, pairs, written);
+	}
+}
+
+void SweepAndPrune::appendOverlaps(const Entry& a, const Entry* pBegin, const Entry* pEnd, std::vector<BoxPair>& pairs, size_t& written)
+{
+	size_t candidates = pEnd - pBegin;
+	if (candidates == 0)
+		return;
+
+	// Room for all of them, so whether each one is kept needn't be a branch.
+	if (pairs.size() < written + candidates)
+		pairs.resize(std::max(pairs.size() * 2, written + candidates));
+	BoxPair* pOut = pairs.data() + written;
+	const uint32_t collidesWith = a.layers >> 16;
+	for (const Entry* pB = pBegin; pB != pEnd; pB++)
+	{
+		bool overlap = (a.minX < pB->maxX) & (pB->minX < a.maxX) & (a.minY < pB->maxY) & ((collidesWith & pB->layers) != 0);
+		*pOut = { std::min(a.box, pB->box), std::max(a.box, pB->box) };
+		pOut += overlap;
+	}
+	written = pOut - pairs.data();
+}
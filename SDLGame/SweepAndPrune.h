@@ -0,0 +1,54 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Broadphase.h"
+
+// Sweep-and-prune broadphase for scenes that scroll vertically.
+//
+// Keeps the boxes sorted by their top edge from one tick to the next. In a vertical
+// shooter nearly everything moves up or down a little each tick, so last tick's
+// order is almost right and an insertion sort puts it back in about one pass. Pairs
+// are then found by sweeping down the list: each box is only tested against those
+// whose top edge lies above its bottom edge.
+//
+// The order is kept by box id, so it helps most when a box has the same id every
+// tick: add the same stores in the same order. Destroying an entity moves the last
+// one into its place, which the insertion sort fixes by moving just that one.
+class SweepAndPrune : public Broadphase
+{
+public:
+	const char* name() const override { return "sweep-and-prune"; }
+
+	// Re-sorts the boxes added since clear(), starting from the last build()'s order.
+	void build() override;
+
+	void findPairs(std::vector<BoxPair>& pairs) const override;
+	void findPairsBetween(uint32_t split, std::vector<BoxPair>& pairs) const override;
+
+	// How many places boxes moved in the last build(): how far from sorted last tick's order was.
+	size_t moveCount() const { return moves; }
+
+private:
+	// A box in sorted order, with its bounds and layer bits copied alongside so the
+	// sweep reads the list front to back.
+	struct Entry
+	{
+		float minY, maxY, minX, maxX;
+		uint32_t box;
+		uint32_t layers;
+	};
+
+	// Appends a paired with every box in [pBegin, pEnd) it overlaps. Those all start at or below a's top edge.
+	static void appendOverlaps(const Entry& a, const Entry* pBegin, const Entry* pEnd, std::vector<BoxPair>& pairs, size_t& written);
+
+	// Pairs each box in from with the boxes in other that start below it (or level with it, if levelToo).
+	static void sweepAgainst(const std::vector<Entry>& from, const std::vector<Entry>& other, bool levelToo, std::vector<BoxPair>& pairs, size_t& written);
+
+	std::vector<uint32_t> order; // box ids by top edge, kept between builds
+	std::vector<Entry> entries;  // the boxes in that order
+	size_t moves = 0;
+
+	// Scratch for findPairsBetween(), kept so it doesn't allocate every tick.
+	mutable std::vector<Entry> firstGroup, secondGroup;
+};
@@ -0,0 +1,52 @@
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// A fixed set of worker threads running jobs from one queue.
+// submit() returns a std::future for the job's result, so callers can fan work
+// out and collect it in whatever order suits them. Jobs must not touch the
+// renderer: SDL rendering stays on the thread that created it.
+class ThreadPool
+{
+public:
+	// threadCount 0 means one worker per hardware thread, leaving one for the caller.
+	explicit ThreadPool(int threadCount = 0);
+
+	// Runs every job still queued, then joins the workers.
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	template <typename Job>
+	std::future<std::invoke_result_t<Job>> submit(Job&& job)
+	{
+		// std::function needs a copyable target and packaged_task isn't, hence the shared_ptr.
+		auto pTask = std::make_shared<std::packaged_task<std::invoke_result_t<Job>()>>(std::forward<Job>(job));
+		std::future<std::invoke_result_t<Job>> result = pTask->get_future();
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			jobs.push_back([pTask]() { (*pTask)(); });
+		}
+		wake.notify_one();
+		return result;
+	}
+
+	int threadCount() const { return (int)threads.size(); }
+
+private:
+	void workerLoop();
+
+	std::vector<std::thread> threads;
+	std::mutex mutex;
+	std::condition_variable wake;
+	std::deque<std::function<void()>> jobs;
+	bool stopping = false;
+};
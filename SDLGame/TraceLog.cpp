@@ -0,0 +1,50 @@
+#include "TraceLog.h"
+#include <algorithm>
+#include "BenchStats.h"
+
+double TraceLog::nowUs() const
+{
+	return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - origin).count();
+}
+
+void TraceLog::addSpan(const std::string& name, const char* category, double startUs, double endUs)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	spans.push_back({ name, category, startUs, endUs - startUs, threadIndex() });
+}
+
+size_t TraceLog::spanCount() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return spans.size();
+}
+
+int TraceLog::threadIndex()
+{
+	std::thread::id id = std::this_thread::get_id();
+	auto it = std::find(threads.begin(), threads.end(), id);
+	if (it != threads.end())
+		return (int)(it - threads.begin());
+	threads.push_back(id);
+	return (int)threads.size() - 1;
+}
+
+void TraceLog::writeJson(std::ostream& out) const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	out << "{\"traceEvents\":[\n";
+	for (size_t i = 0; i < threads.size(); i++)
+	{
+		// Thread 0 is whoever recorded first, normally the main thread.
+		std::string threadName = i == 0 ? "main" : "worker " + std::to_string(i);
+		out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << i << ",\"args\":{\"name\":" << jsonString(threadName) << "}},\n";
+	}
+	for (size_t i = 0; i < spans.size(); i++)
+	{
+		const Span& span = spans[i];
+		out << "{\"name\":" << jsonString(span.name) << ",\"cat\":" << jsonString(span.category)
+			<< ",\"ph\":\"X\",\"pid\":1,\"tid\":" << span.thread << ",\"ts\":" << span.startUs << ",\"dur\":" << span.durationUs << "}"
+			<< (i + 1 < spans.size() ? "," : "") << "\n";
+	}
+	out << "]}\n";
+}
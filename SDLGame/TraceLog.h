@@ -0,0 +1,67 @@
+#pragma once
+#include <chrono>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Records timed spans from any thread and writes them in the Chrome trace event
+// format, so a run can be opened in chrome://tracing or https://ui.perfetto.dev
+// to see what each thread was doing. Meant for startup and tools, not per-frame use:
+// every span takes a lock.
+class TraceLog
+{
+public:
+	TraceLog() : origin(std::chrono::steady_clock::now()) {}
+
+	// Microseconds since the log was created.
+	double nowUs() const;
+
+	void addSpan(const std::string& name, const char* category, double startUs, double endUs);
+
+	size_t spanCount() const;
+
+	// Writes {"traceEvents":[...]} with one complete ("X") event per span.
+	void writeJson(std::ostream& out) const;
+
+private:
+	struct Span
+	{
+		std::string name;
+		const char* category;
+		double startUs;
+		double durationUs;
+		int thread;
+	};
+
+	int threadIndex(); // small stable number per thread; caller holds the lock
+
+	std::chrono::steady_clock::time_point origin;
+	mutable std::mutex mutex;
+	std::vector<Span> spans;
+	std::vector<std::thread::id> threads;
+};
+
+// Adds a span covering its own lifetime. Does nothing if the log is null.
+class TraceScope
+{
+public:
+	TraceScope(TraceLog* pLog, const std::string& name, const char* category)
+		: pLog(pLog), name(pLog ? name : std::string()), category(category), startUs(pLog ? pLog->nowUs() : 0.0) {}
+
+	~TraceScope()
+	{
+		if (pLog)
+			pLog->addSpan(name, category, startUs, pLog->nowUs());
+	}
+
+	TraceScope(const TraceScope&) = delete;
+	TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+	TraceLog* pLog;
+	std::string name;
+	const char* category;
+	double startUs;
+};
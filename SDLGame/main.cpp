@@ -1,5 +1,17 @@
 #include <iostream>
 #include <SDL.h> 
+#include <SDL_image.h>
+#include "AssetCache.h"
+#include "DirtyRectRenderer.h"
+#include "FramePacer.h"
+#include "GameLoop.h"
+#include "HotReloader.h"
+#include "ImageLoader.h"
+#include "Scenes.h"
+#include "SimulationThread.h"
+#include "SpriteAtlas.h"
+#include "SpriteBatch.h"
+#include "ThreadPool.h"
 // We need to figure out how to...
 //1.	get SDL header files (.h files) to be included in this project so we can call its functions in the source code
 //2.	get SDL precompiled libraries (.lib files) to be linked in this project so when we compile our code it can connect with SDL's compiled code!
@@ -23,18 +35,170 @@ int windowSizeX = 800;
 int windowSizeY = 600;
 const char* windowName = "Hello SDL";
 SDL_Window* pWindow = nullptr;
+SDL_Renderer* pRenderer = nullptr;
+const char* assetRoot = "Assets/";
+
+const double simulationTickRate = 120.0; // simulation ticks per second, independent of the display
+const int maxTicksPerFrame = 8;          // after a long stall, skip ahead instead of trying to catch up
+const double cappedFrameRate = 144.0;    // frame rate used when pacing is set to capped (press V to cycle modes)
+const size_t assetCacheBudget = 128 * 1024 * 1024; // bytes of unused textures/surfaces/sounds kept around before the oldest are freed
+const Uint32 idleWaitMs = 16;             // how long the pause screen sleeps on a frame with nothing to redraw, unless input comes first
 
 // Main function.
 int main(int argc, char* args[]) // Main MUST have these parameters for SDL.
 {
 	int flags = SDL_INIT_EVERYTHING;
 
-	if (SDL_Init(flags) == 0) // if initialized SDL correctly...
+	if (SDL_Init(flags) != 0) // if SDL did not initialize correctly...
+	{
+		std::cout << "SDL_Init failed: " << SDL_GetError() << std::endl;
+		return 1;
+	}
+
+	// Create the window
+	pWindow = SDL_CreateWindow(windowName, SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, windowSizeX, windowSizeY, SDL_WINDOW_SHOWN);
+	if (pWindow == nullptr)
+	{
+		std::cout << "SDL_CreateWindow failed: " << SDL_GetError() << std::endl;
+		SDL_Quit();
+		return 1;
+	}
+
+	// Create the renderer that draws into the window. Vsync is switched on by the frame pacer.
+	pRenderer = SDL_CreateRenderer(pWindow, -1, SDL_RENDERER_ACCELERATED);
+	if (pRenderer == nullptr)
+	{
+		std::cout << "SDL_CreateRenderer failed: " << SDL_GetError() << std::endl;
+		SDL_DestroyWindow(pWindow);
+		SDL_Quit();
+		return 1;
+	}
+
+	IMG_Init(IMG_INIT_PNG);
+
+	// Sprites come from the packed atlas in Assets/Atlas (built by the "atlas" CMake target),
+	// or straight from the PNGs in Assets/ if it hasn't been built. Images are read
+	// pre-decoded from Assets/assets.pack (the "assetpack" target) when it exists.
+	ImageLoader imageLoader(assetRoot);
+	imageLoader.openPack();
+	AssetCache assetCache(imageLoader, pRenderer, assetCacheBudget);
+	SpriteBatch spriteBatch(pRenderer);
+	SpriteAtlas spriteAtlas(spriteBatch, assetCache);
+	if (!spriteAtlas.loadPacked())
 	{
-		// Create the window
-		pWindow = SDL_CreateWindow(windowName, SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, windowSizeX, windowSizeY, SDL_WINDOW_SHOWN);
+		// Development mode: decode every loose image on all cores up front instead of one by one as scenes ask.
+		std::cout << "No sprite atlas in " << assetRoot << "Atlas/, loading loose images" << std::endl;
+		Uint64 loadStart = SDL_GetPerformanceCounter();
+		ThreadPool decodePool;
+		int loaded = spriteAtlas.preload(imageLoader.listImages(), decodePool);
+		std::cout << "Loaded " << loaded << " images in " << (SDL_GetPerformanceCounter() - loadStart) * 1000.0 / SDL_GetPerformanceFrequency()
+			<< " ms on " << decodePool.threadCount() << " decode threads" << std::endl;
+	}
+
+	SceneConfig sceneConfig;
+	sceneConfig.width = windowSizeX;
+	sceneConfig.height = windowSizeY;
+	std::unique_ptr<Scene> scene = createScene("meteor-field", sceneConfig, spriteAtlas);
+
+	// Press P to pause. The pause menu hardly changes, so it only redraws what did.
+	std::unique_ptr<Scene> pauseMenu = createScene("menu", sceneConfig, spriteAtlas);
+	SceneSnapshot menuSnapshot;
+	std::unique_ptr<DirtyRectRenderer> dirtyRects = std::make_unique<DirtyRectRenderer>(spriteAtlas, pWindow, windowSizeX, windowSizeY);
+	bool paused = false;
+
+	// Edited images under Assets/ show up in the running game.
+	HotReloader hotReloader(spriteAtlas, imageLoader);
+	if (!hotReloader.start())
+		std::cout << "Not watching " << assetRoot << " for changes" << std::endl;
+
+	// Game loop: the simulation runs in fixed ticks on a worker thread, a frame ahead of
+	// rendering, which happens once per frame and blends between the last two ticks.
+	FixedTimestep timestep(simulationTickRate, maxTicksPerFrame);
+	const float tickSeconds = (float)timestep.tickSeconds();
+	std::unique_ptr<SimulationThread> simulation = std::make_unique<SimulationThread>(*scene, [&scene, tickSeconds]() { scene->tick(tickSeconds); });
+	FramePacer pacer(cappedFrameRate);
+	pacer.setMode(PacingMode::Vsync, pRenderer, pWindow);
+	const double secondsPerCount = 1.0 / SDL_GetPerformanceFrequency();
+	Uint64 lastCounter = SDL_GetPerformanceCounter();
+	bool isRunning = true;
+
+	while (isRunning)
+	{
+		SDL_Event event;
+		while (SDL_PollEvent(&event))
+		{
+			if (event.type == SDL_QUIT)
+				isRunning = false;
+			else if (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_ESCAPE)
+				isRunning = false;
+			else if (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_v && !event.key.repeat)
+			{
+				const Histogram& errors = pacer.errorHistogram();
+				std::cout << "pacing " << pacingModeName(pacer.mode()) << ": p99 error " << errors.percentile(99) << " us over " << errors.count() << " frames" << std::endl;
+				pacer.cycleMode(pRenderer, pWindow);
+				std::cout << "pacing mode: " << pacingModeName(pacer.mode()) << std::endl;
+			}
+			else if (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_p && !event.key.repeat)
+			{
+				paused = !paused;
+				dirtyRects->invalidate();
+			}
+			else if (event.type == SDL_WINDOWEVENT && (event.window.event == SDL_WINDOWEVENT_EXPOSED || event.window.event == SDL_WINDOWEVENT_SIZE_CHANGED))
+				dirtyRects->invalidate();
+			else if (event.type == SDL_RENDER_TARGETS_RESET)
+				dirtyRects->invalidate();
+		}
+
+		Uint64 counter = SDL_GetPerformanceCounter();
+		int ticks = timestep.advance((counter - lastCounter) * secondsPerCount);
+		lastCounter = counter;
+
+		if (paused)
+		{
+			// The game's ticks stay finished, and the menu ticks here on the main thread.
+			simulation->finish();
+			if (hotReloader.update() > 0)
+				dirtyRects->invalidate();
+			for (int i = 0; i < ticks; i++)
+				pauseMenu->tick(tickSeconds);
+			menuSnapshot.clear();
+			pauseMenu->capture(menuSnapshot);
+
+			dirtyRects->begin();
+			dirtyRects->add(menuSnapshot);
+			// Vsync only waits on a present, so a frame without one sleeps instead.
+			if (dirtyRects->present())
+				pacer.waitForNextFrame();
+			else
+				SDL_WaitEventTimeout(nullptr, idleWaitMs);
+			continue;
+		}
+
+		// Between finish() and start() the worker leaves the scene alone, so this is where
+		// hot reload may change the collision masks the ticks read.
+		const SceneSnapshot& snapshot = simulation->finish();
+		hotReloader.update();
+		simulation->start(ticks, timestep.alpha());
+
+		SDL_SetRenderDrawColor(pRenderer, 0, 0, 0, 255);
+		SDL_RenderClear(pRenderer);
+		snapshot.draw(spriteAtlas);
+		spriteBatch.flush();
+		SDL_RenderPresent(pRenderer);
+		pacer.waitForNextFrame();
 	}
 
-	getchar();
+	// Textures belong to the renderer, so everything holding them goes first, and the
+	// worker before the scene it's ticking.
+	simulation.reset();
+	scene.reset();
+	pauseMenu.reset();
+	dirtyRects.reset();
+	spriteAtlas.clear();
+	assetCache.clear();
+	SDL_DestroyRenderer(pRenderer);
+	SDL_DestroyWindow(pWindow);
+	IMG_Quit();
+	SDL_Quit();
 	return 0;
-}
\ No newline at end of file
+}
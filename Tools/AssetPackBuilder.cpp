@@ -0,0 +1,213 @@
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+#include <SDL.h>
+#include <SDL_image.h>
+#include "AssetPack.h"
+#include "CollisionMask.h"
+#include "Hash.h"
+#include "SpriteRuns.h"
+
+// AssetPackBuilder: decodes every PNG under an asset directory once, at build time,
+// and writes the pixels into one pack file the game can memory-map (see AssetPack.h).
+//
+//   AssetPackBuilder <assetDir> <packFile> [--format ARGB8888|ABGR8888] [--mask-threshold ALPHA]
+//                    [--exclude NAME]...
+//
+// Images are named by their path under assetDir ("Atlas/atlas0.png"), which is what
+// ImageLoader looks up. --format should match the renderer's preferred texture format
+// so creating the texture needs no conversion; ARGB8888 suits the software, OpenGL and
+// Direct3D renderers. Rebuilds are incremental: a PNG whose bytes hash the same as in
+// the existing pack is not decoded again.
+//
+// Every image also gets a CollisionMask, solid where alpha is at least --mask-threshold
+// (default 128), and SpriteRuns: its opaque and translucent spans per row, which the
+// software blitter draws instead of the whole box. Both are cheap to make from the
+// pixels, so they are always rebuilt. The runs also class the image as opaque, binary
+// alpha or translucent for drawing loose images such as Backgrounds/black.png.
+
+namespace fs = std::filesystem;
+
+namespace
+{
+	struct Options
+	{
+		fs::path assetDir;
+		fs::path packFile;
+		Uint32 format = SDL_PIXELFORMAT_ARGB8888;
+		int maskThreshold = CollisionMask::defaultThreshold;
+		std::vector<std::string> excluded;
+	};
+
+	bool isExcluded(const fs::path& relative, const Options& options)
+	{
+		for (const fs::path& part : relative)
+		{
+			if (std::find(options.excluded.begin(), options.excluded.end(), part.string()) != options.excluded.end())
+				return true;
+		}
+		return false;
+	}
+
+	bool readFile(const fs::path& path, std::vector<char>& bytes)
+	{
+		std::ifstream in(path, std::ios::binary);
+		if (!in)
+			return false;
+		bytes.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+		return true;
+	}
+
+	bool parseFormat(const std::string& name, Uint32& format)
+	{
+		for (Uint32 candidate : { SDL_PIXELFORMAT_ARGB8888, SDL_PIXELFORMAT_ABGR8888 })
+		{
+			if (name == SDL_GetPixelFormatName(candidate) + strlen("SDL_PIXELFORMAT_"))
+			{
+				format = candidate;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	bool parseOptions(int argc, char* args[], Options& options)
+	{
+		std::vector<std::string> positional;
+		for (int i = 1; i < argc; i++)
+		{
+			std::string arg = args[i];
+			if (arg.rfind("--", 0) == 0)
+			{
+				if (i + 1 >= argc)
+					return false;
+				std::string value = args[++i];
+				if (arg == "--format")
+				{
+					if (!parseFormat(value, options.format))
+						return false;
+				}
+				else if (arg == "--mask-threshold")
+				{
+					options.maskThreshold = atoi(value.c_str());
+					if (options.maskThreshold < 1 || options.maskThreshold > 255)
+						return false;
+				}
+				else if (arg == "--exclude")
+					options.excluded.push_back(value);
+				else
+					return false;
+			}
+			else
+			{
+				positional.push_back(arg);
+			}
+		}
+		if (positional.size() != 2)
+			return false;
+		options.assetDir = positional[0];
+		options.packFile = positional[1];
+		return true;
+	}
+}
+
+int main(int argc, char* args[])
+{
+	Options options;
+	if (!parseOptions(argc, args, options))
+	{
+		std::cerr << "usage: AssetPackBuilder <assetDir> <packFile> [--format ARGB8888|ABGR8888] [--mask-threshold ALPHA] [--exclude NAME]...\n";
+		return 1;
+	}
+
+	if (SDL_Init(0) != 0 || (IMG_Init(IMG_INIT_PNG) & IMG_INIT_PNG) == 0)
+	{
+		std::cerr << "could not initialise SDL/SDL_image: " << SDL_GetError() << "\n";
+		return 1;
+	}
+
+	std::vector<fs::path> files;
+	for (const fs::directory_entry& entry : fs::recursive_directory_iterator(options.assetDir))
+	{
+		if (!entry.is_regular_file() || entry.path().extension() != ".png")
+			continue;
+		if (isExcluded(fs::relative(entry.path(), options.assetDir), options))
+			continue;
+		files.push_back(entry.path());
+	}
+	std::sort(files.begin(), files.end());
+
+	// The previous pack is only reusable if it was built for the same pixel format.
+	AssetPack previous;
+	if (previous.open(options.packFile.string()) && previous.pixelFormat() != options.format)
+		previous.close();
+
+	// Reused pixels are copied out of the old pack so it can be unmapped before the
+	// new one is renamed over it (Windows won't replace a mapped file).
+	std::vector<std::vector<char>> reusedPixels;
+	std::vector<SDL_Surface*> decoded;
+	std::deque<CollisionMask> masks; // the writer keeps pointers to these
+	std::deque<SpriteRuns> runs;     // and to these
+	AssetPackWriter writer(options.format, (uint8_t)options.maskThreshold);
+	reusedPixels.reserve(files.size());
+	for (const fs::path& file : files)
+	{
+		std::string name = fs::relative(file, options.assetDir).generic_string();
+		std::vector<char> bytes;
+		if (!readFile(file, bytes))
+		{
+			std::cerr << "skipping " << file.string() << ": could not read it\n";
+			continue;
+		}
+		uint64_t contentHash = fnv1a64(bytes.data(), bytes.size());
+
+		const AssetPack::Entry* pOld = previous.find(name);
+		if (pOld && pOld->contentHash == contentHash)
+		{
+			const char* pPixels = (const char*)previous.pixels(*pOld);
+			reusedPixels.emplace_back(pPixels, pPixels + pOld->dataSize);
+			masks.emplace_back();
+			masks.back().build(reusedPixels.back().data(), (int)pOld->width, (int)pOld->height, (int)pOld->pitch, (uint8_t)options.maskThreshold);
+			runs.emplace_back();
+			runs.back().build(reusedPixels.back().data(), (int)pOld->width, (int)pOld->height, (int)pOld->pitch);
+			writer.add(name, contentHash, pOld->width, pOld->height, pOld->pitch, reusedPixels.back().data(), &masks.back(), &runs.back());
+			continue;
+		}
+
+		SDL_Surface* pLoaded = IMG_Load_RW(SDL_RWFromConstMem(bytes.data(), (int)bytes.size()), 1);
+		SDL_Surface* pSurface = pLoaded ? SDL_ConvertSurfaceFormat(pLoaded, options.format, 0) : nullptr;
+		SDL_FreeSurface(pLoaded);
+		if (pSurface == nullptr)
+		{
+			std::cerr << "skipping " << file.string() << ": " << SDL_GetError() << "\n";
+			continue;
+		}
+		decoded.push_back(pSurface);
+		masks.emplace_back();
+		masks.back().build(pSurface->pixels, pSurface->w, pSurface->h, pSurface->pitch, (uint8_t)options.maskThreshold);
+		runs.emplace_back();
+		runs.back().build(pSurface->pixels, pSurface->w, pSurface->h, pSurface->pitch);
+		writer.add(name, contentHash, pSurface->w, pSurface->h, pSurface->pitch, pSurface->pixels, &masks.back(), &runs.back());
+	}
+	previous.close();
+
+	bool ok = writer.write(options.packFile.string());
+	if (!ok)
+		std::cerr << "could not write " << options.packFile.string() << "\n";
+	std::cout << options.packFile.filename().string() << ": " << reusedPixels.size() + decoded.size() << " images ("
+		<< decoded.size() << " decoded, " << reusedPixels.size() << " unchanged), "
+		<< SDL_GetPixelFormatName(options.format) << "\n";
+
+	for (SDL_Surface* pSurface : decoded)
+		SDL_FreeSurface(pSurface);
+	IMG_Quit();
+	SDL_Quit();
+	return ok ? 0 : 1;
+}
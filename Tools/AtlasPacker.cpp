@@ -0,0 +1,299 @@
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <SDL.h>
+#include <SDL_image.h>
+#include "CollisionMask.h"
+#include "CollisionShape.h"
+#include "RectPacker.h"
+#include "SpriteMesh.h"
+#include "SpriteRuns.h"
+#include "SpriteTable.h"
+
+// AtlasPacker: packs every PNG under an asset directory into a few atlas pages.
+//
+//   AtlasPacker <assetDir> <outDir> [--max-size N] [--padding N] [--mask-threshold ALPHA] [--exclude NAME]...
+//
+// Writes outDir/atlas0.png, atlas1.png, ... and outDir/atlas.txt (see SpriteTable.h).
+// Transparent borders are trimmed before packing. Each sprite is surrounded by
+// `padding` pixels, and its edge pixels are copied outward into that gap so linear
+// filtering never picks up a neighbour. --exclude skips any file or directory with
+// that name (e.g. Backgrounds, which are tiled and need their own texture).
+//
+// Every sprite also gets collision shapes (a circle, an oriented box and a convex
+// hull; see CollisionShape.h) around the pixels whose alpha is at least
+// --mask-threshold. Keep it the same as AssetPackBuilder's so shapes and masks agree.
+// Its trimmed part is also classed as opaque, binary alpha or translucent (see
+// AlphaKind.h), which decides how the game blends it, and gets a mesh: a convex
+// outline of up to 12 corners around its visible pixels (see SpriteMesh.h) that the
+// game draws instead of the quad where that leaves out enough transparent pixels.
+
+namespace fs = std::filesystem;
+
+namespace
+{
+	struct Options
+	{
+		fs::path assetDir;
+		fs::path outDir;
+		int maxSize = 1024;
+		int padding = 2;
+		int maskThreshold = CollisionMask::defaultThreshold;
+		std::vector<std::string> excluded;
+	};
+
+	struct SourceImage
+	{
+		std::string name;
+		SDL_Surface* pSurface = nullptr; // RGBA32
+		SDL_Rect trimmed = { 0, 0, 0, 0 };
+	};
+
+	bool isExcluded(const fs::path& relative, const Options& options)
+	{
+		for (const fs::path& part : relative)
+		{
+			if (std::find(options.excluded.begin(), options.excluded.end(), part.string()) != options.excluded.end())
+				return true;
+		}
+		return false;
+	}
+
+	// Smallest rectangle holding every pixel with non-zero alpha. A fully transparent image keeps one pixel.
+	SDL_Rect opaqueBounds(SDL_Surface* pSurface)
+	{
+		int minX = pSurface->w, minY = pSurface->h, maxX = -1, maxY = -1;
+		for (int y = 0; y < pSurface->h; y++)
+		{
+			const Uint8* pRow = (const Uint8*)pSurface->pixels + y * pSurface->pitch;
+			for (int x = 0; x < pSurface->w; x++)
+			{
+				if (pRow[x * 4 + 3] != 0)
+				{
+					minX = std::min(minX, x);
+					maxX = std::max(maxX, x);
+					minY = std::min(minY, y);
+					maxY = std::max(maxY, y);
+				}
+			}
+		}
+		if (maxX < 0)
+			return { 0, 0, 1, 1 };
+		return { minX, minY, maxX - minX + 1, maxY - minY + 1 };
+	}
+
+	Uint32* pixelAt(SDL_Surface* pSurface, int x, int y)
+	{
+		return (Uint32*)((Uint8*)pSurface->pixels + y * pSurface->pitch) + x;
+	}
+
+	// Copies the trimmed image to (x, y) on the page and extrudes its edges into the padding.
+	void blitWithExtrusion(const SourceImage& image, SDL_Surface* pPage, int x, int y, int padding)
+	{
+		const SDL_Rect& r = image.trimmed;
+		for (int row = -padding; row < r.h + padding; row++)
+		{
+			int sourceY = r.y + std::min(std::max(row, 0), r.h - 1);
+			for (int column = -padding; column < r.w + padding; column++)
+			{
+				int sourceX = r.x + std::min(std::max(column, 0), r.w - 1);
+				*pixelAt(pPage, x + column, y + row) = *pixelAt(image.pSurface, sourceX, sourceY);
+			}
+		}
+	}
+
+	bool parseOptions(int argc, char* args[], Options& options)
+	{
+		std::vector<std::string> positional;
+		for (int i = 1; i < argc; i++)
+		{
+			std::string arg = args[i];
+			if (arg.rfind("--", 0) == 0)
+			{
+				if (i + 1 >= argc)
+					return false;
+				std::string value = args[++i];
+				if (arg == "--max-size")
+					options.maxSize = atoi(value.c_str());
+				else if (arg == "--padding")
+					options.padding = atoi(value.c_str());
+				else if (arg == "--mask-threshold")
+					options.maskThreshold = atoi(value.c_str());
+				else if (arg == "--exclude")
+					options.excluded.push_back(value);
+				else
+					return false;
+			}
+			else
+			{
+				positional.push_back(arg);
+			}
+		}
+		if (positional.size() != 2 || options.maxSize <= 0 || options.padding < 0 || options.maskThreshold < 1 || options.maskThreshold > 255)
+			return false;
+		options.assetDir = positional[0];
+		options.outDir = positional[1];
+		return true;
+	}
+}
+
+int main(int argc, char* args[])
+{
+	Options options;
+	if (!parseOptions(argc, args, options))
+	{
+		std::cerr << "usage: AtlasPacker <assetDir> <outDir> [--max-size N] [--padding N] [--mask-threshold ALPHA] [--exclude NAME]...\n";
+		return 1;
+	}
+
+	if (SDL_Init(0) != 0 || (IMG_Init(IMG_INIT_PNG) & IMG_INIT_PNG) == 0)
+	{
+		std::cerr << "could not initialise SDL/SDL_image: " << SDL_GetError() << "\n";
+		return 1;
+	}
+
+	std::error_code error;
+	fs::create_directories(options.outDir, error);
+	fs::path outDirAbsolute = fs::weakly_canonical(options.outDir);
+
+	// Collect sources in a stable order so the output only changes when the inputs do.
+	std::vector<fs::path> files;
+	for (const fs::directory_entry& entry : fs::recursive_directory_iterator(options.assetDir))
+	{
+		if (!entry.is_regular_file() || entry.path().extension() != ".png")
+			continue;
+		if (fs::weakly_canonical(entry.path()).string().rfind(outDirAbsolute.string(), 0) == 0)
+			continue;
+		if (isExcluded(fs::relative(entry.path(), options.assetDir), options))
+			continue;
+		files.push_back(entry.path());
+	}
+	std::sort(files.begin(), files.end());
+
+	std::vector<SourceImage> images;
+	std::vector<PackInput> inputs;
+	for (const fs::path& file : files)
+	{
+		SDL_Surface* pLoaded = IMG_Load(file.string().c_str());
+		SDL_Surface* pSurface = pLoaded ? SDL_ConvertSurfaceFormat(pLoaded, SDL_PIXELFORMAT_RGBA32, 0) : nullptr;
+		SDL_FreeSurface(pLoaded);
+		if (pSurface == nullptr)
+		{
+			std::cerr << "skipping " << file.string() << ": " << SDL_GetError() << "\n";
+			continue;
+		}
+
+		SourceImage image;
+		image.name = fs::relative(file, options.assetDir).replace_extension().generic_string();
+		image.pSurface = pSurface;
+		image.trimmed = opaqueBounds(pSurface);
+		images.push_back(image);
+		inputs.push_back({ image.trimmed.w + options.padding * 2, image.trimmed.h + options.padding * 2 });
+	}
+
+	PackedBins packed = packRects(inputs, options.maxSize, options.maxSize);
+
+	// One surface per page, cropped to what was actually used.
+	SpriteTable table;
+	std::vector<SDL_Surface*> pages;
+	for (size_t i = 0; i < packed.bins.size(); i++)
+	{
+		const MaxRectsBin& bin = packed.bins[i];
+		int width = (bin.usedWidth() + 3) & ~3;
+		int height = (bin.usedHeight() + 3) & ~3;
+		SDL_Surface* pPage = SDL_CreateRGBSurfaceWithFormat(0, width, height, 32, SDL_PIXELFORMAT_RGBA32);
+		SDL_FillRect(pPage, nullptr, 0);
+		pages.push_back(pPage);
+		table.pages.push_back({ "atlas" + std::to_string(i) + ".png", width, height });
+	}
+
+	long long trimmedArea = 0;
+	int shapeCount = 0;
+	int alphaCounts[3] = {}; // by AlphaKind
+	int meshCount = 0;
+	double meshArea = 0.0, meshedQuadArea = 0.0;
+	CollisionMask mask;
+	SpriteRuns runs;
+	for (size_t i = 0; i < images.size(); i++)
+	{
+		const SourceImage& image = images[i];
+		const PackResult& placement = packed.placements[i];
+		if (placement.bin < 0)
+		{
+			std::cerr << "skipping " << image.name << ": larger than " << options.maxSize << "x" << options.maxSize << "\n";
+			continue;
+		}
+
+		int x = placement.x + options.padding;
+		int y = placement.y + options.padding;
+		blitWithExtrusion(image, pages[placement.bin], x, y, options.padding);
+
+		SpriteEntry sprite;
+		sprite.name = image.name;
+		sprite.page = placement.bin;
+		sprite.x = x;
+		sprite.y = y;
+		sprite.w = image.trimmed.w;
+		sprite.h = image.trimmed.h;
+		sprite.offsetX = image.trimmed.x;
+		sprite.offsetY = image.trimmed.y;
+		sprite.sourceW = image.pSurface->w;
+		sprite.sourceH = image.pSurface->h;
+
+		// RGBA32 has alpha in the top byte of each little-endian pixel, as the mask wants.
+		mask.build(image.pSurface->pixels, image.pSurface->w, image.pSurface->h, image.pSurface->pitch, (uint8_t)options.maskThreshold);
+		sprite.shape.build(mask);
+		shapeCount += sprite.shape.isEmpty() ? 0 : 1;
+
+		// Only the trimmed part is drawn, so that's what decides how it can be.
+		const Uint8* pTrimmed = (const Uint8*)image.pSurface->pixels + image.trimmed.y * image.pSurface->pitch + image.trimmed.x * 4;
+		runs.build(pTrimmed, image.trimmed.w, image.trimmed.h, image.pSurface->pitch);
+		sprite.alpha = runs.alphaKind();
+		alphaCounts[(int)sprite.alpha]++;
+		sprite.mesh.build(runs);
+		if (!sprite.mesh.isEmpty())
+		{
+			meshCount++;
+			meshArea += sprite.mesh.area();
+			meshedQuadArea += (double)sprite.w * sprite.h;
+		}
+		table.sprites.push_back(sprite);
+		trimmedArea += (long long)sprite.w * sprite.h;
+	}
+
+	bool ok = true;
+	for (size_t i = 0; i < pages.size(); i++)
+	{
+		fs::path pagePath = options.outDir / table.pages[i].file;
+		if (IMG_SavePNG(pages[i], pagePath.string().c_str()) != 0)
+		{
+			std::cerr << "could not write " << pagePath.string() << ": " << SDL_GetError() << "\n";
+			ok = false;
+		}
+		std::cout << table.pages[i].file << ": " << table.pages[i].width << "x" << table.pages[i].height
+			<< ", " << (int)(packed.bins[i].occupancy() * 100.0f) << "% used\n";
+		SDL_FreeSurface(pages[i]);
+	}
+	for (SourceImage& image : images)
+		SDL_FreeSurface(image.pSurface);
+
+	fs::path tablePath = options.outDir / "atlas.txt";
+	if (!table.write(tablePath.string()))
+	{
+		std::cerr << "could not write " << tablePath.string() << "\n";
+		ok = false;
+	}
+	std::cout << table.sprites.size() << " sprites (" << shapeCount << " with collision shapes; " << alphaCounts[(int)AlphaKind::Opaque] << " opaque, "
+		<< alphaCounts[(int)AlphaKind::Binary] << " binary alpha, " << alphaCounts[(int)AlphaKind::Translucent] << " translucent), " << trimmedArea << " opaque-bounds pixels, "
+		<< pages.size() << " page(s)\n";
+	std::cout << meshCount << " sprites drawn as meshes, covering " << (int)(meshedQuadArea > 0.0 ? meshArea * 100.0 / meshedQuadArea : 0.0)
+		<< "% of their quads' pixels\n";
+
+	IMG_Quit();
+	SDL_Quit();
+	return ok ? 0 : 1;
+}